@@ -0,0 +1,345 @@
+#include "bench.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+	std::atomic<size_t> allocations{};
+
+	void* counted_allocation(size_t size, size_t alignment) {
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		size = size == 0 ? 1 : size;
+		void* p = nullptr;
+		if (alignment <= alignof(std::max_align_t))
+			p = std::malloc(size);
+		else
+#if defined(_MSC_VER)
+			p = _aligned_malloc(size, alignment);
+#else
+			p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+		return p;
+	}
+
+	void counted_free(void* p, size_t alignment) noexcept {
+#if defined(_MSC_VER)
+		if (alignment > alignof(std::max_align_t)) {
+			_aligned_free(p);
+			return;
+		}
+#else
+		(void)alignment;
+#endif
+		std::free(p);
+	}
+}
+
+void* operator new(size_t size) {
+	if (void* p = counted_allocation(size, alignof(std::max_align_t)))
+		return p;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	if (void* p = counted_allocation(size, size_t(alignment)))
+		return p;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return counted_allocation(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return counted_allocation(size, alignof(std::max_align_t));
+}
+
+void operator delete(void* p) noexcept { counted_free(p, alignof(std::max_align_t)); }
+void operator delete[](void* p) noexcept { counted_free(p, alignof(std::max_align_t)); }
+void operator delete(void* p, size_t) noexcept { counted_free(p, alignof(std::max_align_t)); }
+void operator delete[](void* p, size_t) noexcept { counted_free(p, alignof(std::max_align_t)); }
+void operator delete(void* p, std::align_val_t alignment) noexcept { counted_free(p, size_t(alignment)); }
+void operator delete[](void* p, std::align_val_t alignment) noexcept { counted_free(p, size_t(alignment)); }
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept { counted_free(p, size_t(alignment)); }
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept { counted_free(p, size_t(alignment)); }
+
+namespace bench
+{
+	size_t allocation_count() {
+		return allocations.load(std::memory_order_relaxed);
+	}
+
+	State::State(size_t iterations)
+		: iteration_count{ iterations }
+	{}
+
+	State::Iterator::Iterator(State* state, size_t remaining)
+		: state{ state }, remaining{ remaining }
+	{}
+
+	bool State::Iterator::operator!=(const Iterator&) {
+		if (remaining != 0)
+			return true;
+		state->stop();
+		return false;
+	}
+
+	void State::Iterator::operator++() {
+		remaining -= 1;
+	}
+
+	State::Value State::Iterator::operator*()const {
+		return {};
+	}
+
+	State::Iterator State::begin() {
+		start();
+		return Iterator(this, iteration_count);
+	}
+
+	State::Iterator State::end() {
+		return Iterator(this, 0);
+	}
+
+	size_t State::iterations()const {
+		return iteration_count;
+	}
+
+	void State::pause_timing() {
+		stop();
+	}
+
+	void State::resume_timing() {
+		start();
+	}
+
+	double State::elapsed_seconds()const {
+		return seconds;
+	}
+
+	double State::elapsed_cpu_seconds()const {
+		return cpu_seconds;
+	}
+
+	size_t State::timed_allocations()const {
+		return allocations;
+	}
+
+	void State::error(std::string message) {
+		failure = std::move(message);
+	}
+
+	const std::string& State::error_message()const {
+		return failure;
+	}
+
+	void State::start() {
+		started = std::chrono::steady_clock::now();
+		cpu_started = std::clock();
+		allocations_started = allocation_count();
+	}
+
+	void State::stop() {
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+		cpu_seconds += double(std::clock() - cpu_started) / CLOCKS_PER_SEC;
+		allocations += allocation_count() - allocations_started;
+	}
+
+	namespace
+	{
+		struct Benchmark
+		{
+			std::string name;
+			std::function<void(State&)> run;
+		};
+
+		struct Result
+		{
+			std::string name;
+			size_t iterations;
+			double real_ns;
+			double cpu_ns;
+			double items_per_second;
+			double allocations_per_iteration;
+			std::vector<std::pair<std::string, double>> counters;
+			std::string error;
+		};
+
+		std::vector<Benchmark>& registry() {
+			static std::vector<Benchmark> benchmarks{};
+			return benchmarks;
+		}
+
+		Result measure(const Benchmark& benchmark, double min_time) {
+			size_t iterations = 1;
+			while (true) {
+				State state(iterations);
+				benchmark.run(state);
+				const double seconds = state.elapsed_seconds();
+
+				// stop once the run was long enough, otherwise aim for min_time with some margin
+				if (seconds >= min_time or iterations >= 1'000'000'000 or not state.error_message().empty()) {
+					const double n = double(iterations);
+					return Result{
+						benchmark.name, iterations,
+						seconds * 1e9 / n, state.elapsed_cpu_seconds() * 1e9 / n,
+						state.items_processed > 0 ? double(state.items_processed) / seconds : 0.0,
+						double(state.timed_allocations()) / n,
+						state.counters, state.error_message() };
+				}
+				const double scale = seconds > 0.0 ? 1.4 * min_time / seconds : 100.0;
+				iterations = size_t(double(iterations) * std::min(std::max(scale, 2.0), 100.0));
+			}
+		}
+
+		std::string escape(std::string_view s) {
+			std::string out{};
+			for (char c : s) {
+				if (c == '"' or c == '\\')
+					out += '\\';
+				out += c;
+			}
+			return out;
+		}
+
+		const char* scalar_name() {
+#if defined(PHS_SCALAR_DOUBLE)
+			return "double";
+#elif defined(PHS_SCALAR_FIXED)
+			return "fixed";
+#else
+			return "float";
+#endif
+		}
+
+		const char* compiler_name() {
+#if defined(__clang__)
+			return "clang " __clang_version__;
+#elif defined(__GNUC__)
+			return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+			return "msvc";
+#else
+			return "unknown";
+#endif
+		}
+
+		// the layout follows Google Benchmark's --benchmark_format=json, so the same tooling can track both
+		void write_json(std::FILE* out, const std::vector<Result>& results) {
+			char date[64]{};
+			const std::time_t now = std::time(nullptr);
+			std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+			std::fprintf(out, "{\n  \"context\": {\n");
+			std::fprintf(out, "    \"date\": \"%s\",\n", date);
+			std::fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+			std::fprintf(out, "    \"compiler\": \"%s\",\n", escape(compiler_name()).c_str());
+			std::fprintf(out, "    \"scalar\": \"%s\",\n", scalar_name());
+#if defined(NDEBUG)
+			std::fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+			std::fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+			std::fprintf(out, "  },\n  \"benchmarks\": [\n");
+			for (size_t i = 0; i < results.size(); ++i) {
+				const auto& r = results[i];
+				std::fprintf(out, "    {\n");
+				std::fprintf(out, "      \"name\": \"%s\",\n", escape(r.name).c_str());
+				std::fprintf(out, "      \"run_name\": \"%s\",\n", escape(r.name).c_str());
+				std::fprintf(out, "      \"run_type\": \"iteration\",\n");
+				std::fprintf(out, "      \"iterations\": %zu,\n", r.iterations);
+				std::fprintf(out, "      \"real_time\": %.4f,\n", r.real_ns);
+				std::fprintf(out, "      \"cpu_time\": %.4f,\n", r.cpu_ns);
+				std::fprintf(out, "      \"time_unit\": \"ns\",\n");
+				std::fprintf(out, "      \"allocations_per_iteration\": %.6g", r.allocations_per_iteration);
+				if (not r.error.empty())
+					std::fprintf(out, ",\n      \"error_occurred\": true,\n      \"error_message\": \"%s\"", escape(r.error).c_str());
+				if (r.items_per_second > 0.0)
+					std::fprintf(out, ",\n      \"items_per_second\": %.6g", r.items_per_second);
+				for (const auto& [name, value] : r.counters)
+					std::fprintf(out, ",\n      \"%s\": %.6g", escape(name).c_str(), value);
+				std::fprintf(out, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+			}
+			std::fprintf(out, "  ]\n}\n");
+		}
+	}
+
+	void add(std::string name, std::function<void(State&)> benchmark) {
+		registry().push_back(Benchmark{ std::move(name), std::move(benchmark) });
+	}
+
+	Register::Register(std::string name, std::function<void(State&)> benchmark) {
+		add(std::move(name), std::move(benchmark));
+	}
+
+	int run(int argc, char** argv) {
+		std::string_view filter{};
+		std::string_view json_path{};
+		double min_time = 0.5;
+
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view arg = argv[i];
+			if (arg.starts_with("--filter="))
+				filter = arg.substr(9);
+			else if (arg.starts_with("--json="))
+				json_path = arg.substr(7);
+			else if (arg.starts_with("--min-time="))
+				min_time = std::strtod(argv[i] + 11, nullptr);
+			else {
+				std::fprintf(stderr, "usage: %s [--filter=substring] [--min-time=seconds] [--json=file|-]\n", argv[0]);
+				return 1;
+			}
+		}
+
+		// with the JSON on stdout the table goes to stderr
+		std::FILE* table = json_path == "-" ? stderr : stdout;
+		std::fprintf(table, "%-56s %17s %17s %12s %12s %12s\n", "benchmark", "time", "cpu", "iterations", "items/s", "allocs/iter");
+
+		std::vector<Result> results{};
+		bool failed = false;
+		for (const auto& benchmark : registry()) {
+			if (not filter.empty() and benchmark.name.find(filter) == std::string::npos)
+				continue;
+
+			const auto r = measure(benchmark, min_time);
+			std::fprintf(table, "%-56s %14.1f ns %14.1f ns %12zu %12.4g %12.4g\n", r.name.c_str(), r.real_ns, r.cpu_ns, r.iterations, r.items_per_second, r.allocations_per_iteration);
+			if (not r.error.empty()) {
+				std::fprintf(table, "    error: %s\n", r.error.c_str());
+				failed = true;
+			}
+			std::fflush(table);
+			results.push_back(r);
+		}
+
+		if (json_path == "-")
+			write_json(stdout, results);
+		else if (not json_path.empty()) {
+			std::FILE* out = std::fopen(std::string(json_path).c_str(), "w");
+			if (not out) {
+				std::fprintf(stderr, "cannot open %s\n", std::string(json_path).c_str());
+				return 1;
+			}
+			write_json(out, results);
+			std::fclose(out);
+		}
+		return failed ? 1 : 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	return bench::run(argc, argv);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <chrono>
+#include <ctime>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// a small self contained benchmark harness, in the spirit of Google Benchmark:
+//
+//	static bench::Register r("group/name", [](bench::State& state) {
+//		// setup
+//		for (auto _ : state) {
+//			// measured code
+//		}
+//		state.items_processed = state.iterations() * items_per_iteration;
+//	});
+//
+// every benchmark is run with more and more iterations until it takes at least --min-time seconds,
+// the harness replaces the global operator new, so every result also reports heap allocations per iteration
+namespace bench
+{
+	class State
+	{
+	public:
+		explicit State(size_t iterations);
+
+		// the loop variable is never used, the attribute keeps compilers quiet about it
+		struct [[maybe_unused]] Value {};
+
+		class Iterator
+		{
+		public:
+			Iterator(State* state, size_t remaining);
+			bool operator!=(const Iterator&);
+			void operator++();
+			Value operator*()const;
+		private:
+			State* state;
+			size_t remaining;
+		};
+
+		Iterator begin();
+		Iterator end();
+
+		size_t iterations()const;
+		// excludes work inside the loop from the measurement
+		void pause_timing();
+		void resume_timing();
+
+		size_t items_processed = 0;
+		std::vector<std::pair<std::string, double>> counters{};
+
+		// marks the benchmark as failed, bench_suite then exits with a non zero code
+		void error(std::string message);
+
+		double elapsed_seconds()const;
+		double elapsed_cpu_seconds()const;
+		size_t timed_allocations()const;
+		const std::string& error_message()const;
+	private:
+		void start();
+		void stop();
+
+		size_t iteration_count;
+		std::chrono::steady_clock::time_point started{};
+		std::clock_t cpu_started{};
+		double seconds = 0.0;
+		double cpu_seconds = 0.0;
+		size_t allocations_started = 0;
+		size_t allocations = 0;
+		std::string failure{};
+	};
+
+	// heap allocations made by this process so far
+	size_t allocation_count();
+
+	void add(std::string name, std::function<void(State&)> benchmark);
+
+	// keeps the compiler from optimizing a computed value away
+	template<class T>
+	void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	// registers at static initialization, for use at namespace scope
+	struct Register
+	{
+		Register(std::string name, std::function<void(State&)> benchmark);
+	};
+
+	// bench_suite [--filter=substring] [--min-time=seconds] [--json=file, - for stdout]
+	int run(int argc, char** argv);
+}
@@ -0,0 +1,74 @@
+// per-step cost of the uniform grid broad phase against the all-pairs loop
+// the scene grows with the ball count so the density stays the same
+#include "physics/physics.h"
+#include "physics/ball_storage.h"
+#include "physics/broad_phase.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	phs::BallStorage make_balls(size_t n, unsigned seed) {
+		std::mt19937 gen(seed);
+		std::uniform_real_distribution<float> dis(0.f, 1.f);
+
+		// roughly one ball per 60x60 square, the same fill as the demo scene
+		const float side = 60.f * std::sqrt(float(n));
+
+		phs::BallStorage balls{};
+		balls.reserve(n);
+		for (size_t i = 0; i < n; ++i) {
+			const float radius = 5.f + dis(gen) * 25.f;
+			balls.push_back(phs::Ball(phs::Point{ dis(gen) * side, dis(gen) * side }, radius, radius));
+		}
+		return balls;
+	}
+
+	volatile size_t sink = 0;
+
+	template<class F>
+	double seconds_per_call(F&& f, int repeats) {
+		const auto beg = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; ++r)
+			f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count() / repeats;
+	}
+}
+
+int main()
+{
+	std::printf("%10s %12s %12s %14s %14s\n", "balls", "pairs", "grid ms", "grid ns/ball", "n^2 ms");
+
+	for (size_t n : { 1'000, 10'000, 100'000, 1'000'000 }) {
+		const auto balls = make_balls(n, 42);
+
+		phs::UniformGrid grid{};
+		std::vector<phs::Pair> pairs{};
+		const int repeats = n <= 100'000 ? 20 : 3;
+
+		const double grid_s = seconds_per_call([&] {
+			grid.build(balls);
+			pairs.clear();
+			grid.find_pairs(pairs);
+		}, repeats);
+
+		double brute_s = 0.0;
+		if (n <= 10'000) {
+			brute_s = seconds_per_call([&] {
+				size_t hits = 0;
+				for (size_t i = 0; i < balls.size(); ++i)
+					for (size_t j = i + 1; j < balls.size(); ++j)
+						hits += phs::distance2(balls.center(i), balls.center(j)) <= (balls.radius[i] + balls.radius[j]) * (balls.radius[i] + balls.radius[j]);
+				sink = hits;
+			}, 1);
+		}
+
+		std::printf("%10zu %12zu %12.3f %14.1f ", n, pairs.size(), grid_s * 1e3, grid_s * 1e9 / double(n));
+		if (brute_s > 0.0)
+			std::printf("%14.3f\n", brute_s * 1e3);
+		else
+			std::printf("%14s\n", "-");
+	}
+}
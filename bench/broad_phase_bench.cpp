@@ -0,0 +1,124 @@
+// the broad phases on their own over radius distributions like those of the demo and of scenes spanning three orders
+// of magnitude: build, pair search and a circle test of every candidate, the least a narrow phase does with them,
+// and a check that each of them finds every overlapping pair
+#include "bench.h"
+#include "physics/broad_phase.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using phs::Float;
+
+	struct Radii
+	{
+		const char* name;
+		double min, max;
+		// log uniform spreads the balls evenly over the orders of magnitude, else the radii are uniform
+		bool log_uniform;
+	};
+
+	constexpr Radii distributions[] = { { "demo", 5.0, 30.0, false }, { "log3", 1.0, 1000.0, true } };
+
+	std::string count_name(size_t n) {
+		return n >= 1'000'000 ? std::to_string(n / 1'000'000) + "M" : std::to_string(n / 1'000) + "k";
+	}
+
+	// random balls covering about a fifth of a square, overlapping freely
+	phs::BallStorage make_balls(size_t n, const Radii& radii, unsigned seed) {
+		std::mt19937 gen(seed);
+		std::uniform_real_distribution<double> dis(0.0, 1.0);
+
+		std::vector<double> r(n);
+		double area = 0.0;
+		for (double& radius : r) {
+			radius = radii.log_uniform ? radii.min * std::pow(radii.max / radii.min, dis(gen)) : radii.min + dis(gen) * (radii.max - radii.min);
+			area += std::numbers::pi * radius * radius;
+		}
+		const double side = std::sqrt(area / 0.2);
+
+		phs::BallStorage balls{};
+		balls.reserve(n);
+		for (size_t i = 0; i < n; ++i)
+			balls.push_back(phs::Ball(phs::Point{ Float(dis(gen) * side), Float(dis(gen) * side) }, Float(r[i]), Float(r[i])));
+		return balls;
+	}
+
+	template<class Phase>
+	void add_build_benchmark(const std::string& name, size_t n, const Radii& radii) {
+		bench::add("broad_phase/" + name + "/" + radii.name + "/" + count_name(n), [n, radii](bench::State& state) {
+			const phs::BallStorage balls = make_balls(n, radii, 42);
+			Phase phase{};
+			std::vector<phs::Pair> pairs{};
+			size_t overlaps = 0;
+			for (auto _ : state) {
+				phase.build(balls);
+				pairs.clear();
+				phase.find_pairs(0, n, pairs);
+				overlaps = 0;
+				for (const auto& [i, j] : pairs) {
+					const Float r = balls.radius[i] + balls.radius[j];
+					overlaps += phs::distance2(balls.center(i), balls.center(j)) <= r * r ? 1 : 0;
+				}
+			}
+			bench::do_not_optimize(overlaps);
+			state.items_processed = state.iterations() * n;
+			state.counters.emplace_back("pairs", double(pairs.size()));
+			state.counters.emplace_back("overlaps", double(overlaps));
+		});
+	}
+
+	void add_build_benchmarks() {
+		for (const Radii& radii : distributions) {
+			for (size_t n : { 10'000, 100'000 }) {
+				add_build_benchmark<phs::UniformGrid>("grid", n, radii);
+				add_build_benchmark<phs::SweepAndPrune>("sap", n, radii);
+				add_build_benchmark<phs::HierarchicalGrid>("hierarchical_grid", n, radii);
+			}
+		}
+	}
+
+	void add_overlap_benchmark() {
+		bench::add("broad_phase/finds_every_overlap/log3/2k", [](bench::State& state) {
+			const size_t n = 2'000;
+			const phs::BallStorage balls = make_balls(n, distributions[1], 7);
+
+			std::vector<phs::Pair> expected{};
+			for (size_t i = 0; i < n; ++i) {
+				for (size_t j = i + 1; j < n; ++j) {
+					const Float r = balls.radius[i] + balls.radius[j];
+					if (phs::distance2(balls.center(i), balls.center(j)) <= r * r)
+						expected.emplace_back(i, j);
+				}
+			}
+
+			phs::UniformGrid grid{};
+			phs::SweepAndPrune sap{};
+			phs::HierarchicalGrid hierarchical{};
+			std::vector<phs::Pair> pairs{};
+			size_t missed = 0;
+			for (auto _ : state) {
+				for (phs::BroadPhase* phase : std::initializer_list<phs::BroadPhase*>{ &grid, &sap, &hierarchical }) {
+					phase->build(balls);
+					pairs.clear();
+					phase->find_pairs(0, n, pairs);
+					std::erase_if(pairs, [&](const phs::Pair& p) {
+						const Float r = balls.radius[p.first] + balls.radius[p.second];
+						return phs::distance2(balls.center(p.first), balls.center(p.second)) > r * r;
+					});
+					std::sort(pairs.begin(), pairs.end());
+					missed += pairs == expected ? 0 : 1;
+				}
+			}
+			if (missed > 0)
+				state.error(std::to_string(missed) + " builds did not find exactly the overlapping pairs");
+			state.counters.emplace_back("overlaps", double(expected.size()));
+		});
+	}
+
+	const bool registered = (add_build_benchmarks(), add_overlap_benchmark(), true);
+}
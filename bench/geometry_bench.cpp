@@ -0,0 +1,164 @@
+// narrow phase calls for both overloads and the geometry primitives under them
+#include "bench.h"
+#include "physics/physics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using phs::Float;
+
+	constexpr size_t block = 4096;
+
+	// pairs close enough that most of them overlap
+	std::vector<phs::Ball> make_balls(size_t n) {
+		std::mt19937 gen(42);
+		std::uniform_real_distribution<float> dis(0.f, 1.f);
+
+		std::vector<phs::Ball> balls{};
+		for (size_t i = 0; i < n; ++i) {
+			const Float radius = Float(5.f + dis(gen) * 25.f);
+			phs::Ball ball(phs::Point{ Float(dis(gen) * 40.f), Float(dis(gen) * 40.f) }, radius, radius);
+			ball.velocity = phs::Vector(Float(dis(gen) * 100.f - 50.f), Float(dis(gen) * 100.f - 50.f));
+			balls.push_back(ball);
+		}
+		return balls;
+	}
+
+	const phs::Wall wall(phs::Point{ Float(0), Float(20) }, phs::Point{ Float(40), Float(25) }, Float(10));
+
+	// the static resolution pushes the balls apart, so every block starts again from the same overlapping copy
+	bench::Register static_ball_ball("narrow/resolve_static_collision/ball_ball", [](bench::State& state) {
+		const auto balls = make_balls(2 * block);
+		auto work = balls;
+		for (auto _ : state) {
+			state.pause_timing();
+			work = balls;
+			state.resume_timing();
+			for (size_t i = 0; i < block; ++i)
+				bench::do_not_optimize(phs::resolve_static_collision(work[2 * i], work[2 * i + 1]));
+		}
+		state.items_processed = state.iterations() * block;
+	});
+
+	bench::Register static_wall_ball("narrow/resolve_static_collision/wall_ball", [](bench::State& state) {
+		const auto balls = make_balls(block);
+		auto work = balls;
+		auto w = wall;
+		for (auto _ : state) {
+			state.pause_timing();
+			work = balls;
+			state.resume_timing();
+			for (size_t i = 0; i < block; ++i)
+				bench::do_not_optimize(phs::resolve_static_collision(w, work[i]));
+		}
+		state.items_processed = state.iterations() * block;
+	});
+
+	bench::Register dynamic_ball_ball("narrow/resolve_dynamic_collision/ball_ball", [](bench::State& state) {
+		auto work = make_balls(2 * block);
+		for (auto _ : state) {
+			for (size_t i = 0; i < block; ++i)
+				phs::resolve_dynamic_collision(work[2 * i], work[2 * i + 1]);
+			bench::do_not_optimize(work[0].velocity);
+		}
+		state.items_processed = state.iterations() * block;
+	});
+
+	bench::Register dynamic_wall_ball("narrow/resolve_dynamic_collision/wall_ball", [](bench::State& state) {
+		auto work = make_balls(block);
+		auto w = wall;
+		for (auto _ : state) {
+			for (size_t i = 0; i < block; ++i)
+				phs::resolve_dynamic_collision(w, work[i]);
+			bench::do_not_optimize(work[0].velocity);
+		}
+		state.items_processed = state.iterations() * block;
+	});
+
+	bench::Register closest_circle("geometry/Stadium::closest_circle", [](bench::State& state) {
+		const auto balls = make_balls(block);
+		for (auto _ : state) {
+			for (size_t i = 0; i < block; ++i)
+				bench::do_not_optimize(wall.closest_circle(balls[i].center));
+		}
+		state.items_processed = state.iterations() * block;
+	});
+
+	// random segments in a unit square, about a quarter of them cross
+	bench::Register segments_intersection("geometry/line_segments_intersection", [](bench::State& state) {
+		std::mt19937 gen(7);
+		std::uniform_real_distribution<float> dis(0.f, 1.f);
+		std::vector<gm2d::LineSegment> segments{};
+		for (size_t i = 0; i < 2 * block; ++i)
+			segments.emplace_back(phs::Point{ Float(dis(gen)), Float(dis(gen)) }, phs::Point{ Float(dis(gen)), Float(dis(gen)) });
+
+		size_t hits = 0;
+		for (auto _ : state) {
+			for (size_t i = 0; i < block; ++i)
+				hits += gm2d::line_segments_intersection(segments[2 * i], segments[2 * i + 1]).size();
+		}
+		bench::do_not_optimize(hits);
+		state.items_processed = state.iterations() * block;
+		state.counters.emplace_back("hit_ratio", double(hits) / double(state.iterations() * block));
+	});
+
+	// the same segments against the signs of the orientations of their ends, pairs that come within a rounding error of
+	// touching are left out
+	bench::Register segments_intersection_matches("geometry/line_segments_intersection/matches_orientations", [](bench::State& state) {
+		std::mt19937 gen(11);
+		std::uniform_real_distribution<float> dis(0.f, 1.f);
+		std::vector<gm2d::LineSegment> segments{};
+		for (size_t i = 0; i < 2 * block; ++i)
+			segments.emplace_back(phs::Point{ Float(dis(gen)), Float(dis(gen)) }, phs::Point{ Float(dis(gen)), Float(dis(gen)) });
+
+		const auto orientation = [](const phs::Point& a, const phs::Point& b, const phs::Point& c) {
+			return double(b.x - a.x) * double(c.y - a.y) - double(b.y - a.y) * double(c.x - a.x);
+		};
+		size_t wrong = 0;
+		for (auto _ : state) {
+			wrong = 0;
+			for (size_t i = 0; i < block; ++i) {
+				const auto& s_1 = segments[2 * i];
+				const auto& s_2 = segments[2 * i + 1];
+				const double o[] = { orientation(s_1.beg, s_1.end, s_2.beg), orientation(s_1.beg, s_1.end, s_2.end),
+					orientation(s_2.beg, s_2.end, s_1.beg), orientation(s_2.beg, s_2.end, s_1.end) };
+				if (std::ranges::any_of(o, [](double v) { return std::abs(v) < 1e-3; }))
+					continue;
+				const bool cross = o[0] * o[1] < 0.0 and o[2] * o[3] < 0.0;
+				wrong += cross == gm2d::line_segments_intersection(s_1, s_2).empty() ? 1 : 0;
+			}
+		}
+		if (wrong > 0)
+			state.error(std::to_string(wrong) + " segment pairs where the intersection disagrees with the orientations");
+		state.items_processed = state.iterations() * block;
+	});
+
+	// the fixed point root against (r - 1/2)^2 <= x <= (r + 1/2)^2 in integers, over raw values below 2^46, so four times
+	// the squares still fit in 64 bits
+	bench::Register fixed_sqrt("geometry/fixed_sqrt/rounds_to_nearest", [](bench::State& state) {
+		std::mt19937_64 gen(3);
+		std::vector<std::int64_t> values{};
+		for (std::int64_t v = 1; v < 4096; ++v)
+			values.push_back(v);
+		for (size_t i = 0; i < block; ++i)
+			values.push_back(std::int64_t(gen() >> (18 + i % 40)) + 1);
+
+		size_t wrong = 0;
+		for (auto _ : state) {
+			wrong = 0;
+			for (const std::int64_t v : values) {
+				const std::uint64_t r = std::uint64_t(sqrt(gm2d::Fixed::from_raw(v)).raw);
+				const std::uint64_t x4 = std::uint64_t(v) * std::uint64_t(gm2d::Fixed::one) * 4;
+				wrong += 4 * r * r - 4 * r + 1 <= x4 and x4 <= 4 * r * r + 4 * r + 1 ? 0 : 1;
+			}
+		}
+		if (wrong > 0)
+			state.error(std::to_string(wrong) + " fixed point roots not rounded to the nearest");
+		state.items_processed = state.iterations() * values.size();
+	});
+}
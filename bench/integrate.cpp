@@ -0,0 +1,31 @@
+// throughput of the structure of arrays integration kernel, in balls per second and bytes moved per second
+#include "physics/ball_storage.h"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <random>
+
+int main()
+{
+	std::printf("%10s %12s %14s %10s\n", "balls", "ns/ball", "Mballs/s", "GB/s");
+
+	for (size_t n : { 1'000, 10'000, 100'000, 1'000'000, 10'000'000 }) {
+		std::mt19937 gen(42);
+		std::uniform_real_distribution<float> dis(0.f, 1.f);
+
+		phs::BallStorage balls{};
+		balls.reserve(n);
+		for (size_t i = 0; i < n; ++i)
+			balls.push_back(phs::Ball(phs::Point{ dis(gen), dis(gen) }, 1.f + dis(gen)));
+
+		const size_t repeats = std::max<size_t>(10, 100'000'000 / n);
+		const auto beg = std::chrono::steady_clock::now();
+		for (size_t r = 0; r < repeats; ++r)
+			phs::integrate(balls, 1.f / 60.f, phs::Vector(0.f, 100.f));
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count() / double(repeats);
+
+		// six arrays read and six written per ball
+		const double bytes = double(balls.padded_size()) * sizeof(phs::Float) * 12.0;
+		std::printf("%10zu %12.3f %14.1f %10.2f\n", n, seconds * 1e9 / double(n), double(n) / seconds * 1e-6, bytes / seconds * 1e-9);
+	}
+}
@@ -0,0 +1,244 @@
+// the batched rejection of candidate pairs and of balls far from the walls at every instruction set this CPU runs,
+// against the exact tests they save, and checks that all kernels keep the same and never leave out an overlap
+#include "bench.h"
+#include "physics/narrow_phase.h"
+#include "physics/world.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using phs::Float;
+
+	constexpr phs::SimdLevel levels[] = { phs::SimdLevel::scalar, phs::SimdLevel::avx2, phs::SimdLevel::avx512 };
+
+	// the candidates of the uniform grid in the demo scene, most of them apart
+	struct Candidates
+	{
+		std::unique_ptr<phs::World> world;
+		std::vector<phs::Pair> pairs;
+	};
+
+	// in creation order, or with the balls reordered along the Hilbert curve, where the gathers mostly hit the cache
+	Candidates make_candidates(size_t n, bool reordered) {
+		Candidates c{ std::make_unique<phs::World>(), {} };
+		const Float side = Float(30) * Float(float(std::sqrt(double(n))));
+		phs::add_box_scene(*c.world, phs::Point{ Float(0), Float(0) }, Float(1.2) * side, side, n, 42);
+		if (reordered)
+			c.world->reorder_balls();
+		phs::UniformGrid grid{};
+		grid.build(c.world->balls);
+		grid.find_pairs(0, n, c.pairs);
+		return c;
+	}
+
+	void add_rejection_benchmarks() {
+		for (bool reordered : { false, true }) {
+			const std::string scene = reordered ? "/demo_hilbert/100k" : "/demo/100k";
+			for (phs::SimdLevel level : levels) {
+				if (level > phs::supported_simd_level())
+					continue;
+				bench::add(std::string("narrow/keep_overlapping_pairs/") + phs::simd_level_name(level) + scene, [level, reordered](bench::State& state) {
+					const Candidates c = make_candidates(100'000, reordered);
+					std::uint32_t kept[phs::pair_block];
+					size_t total = 0;
+					for (auto _ : state) {
+						total = 0;
+						for (size_t begin = 0; begin < c.pairs.size(); begin += phs::pair_block)
+							total += phs::keep_overlapping_pairs(c.world->balls, c.pairs.data() + begin, std::min(phs::pair_block, c.pairs.size() - begin), kept, level);
+						bench::do_not_optimize(kept[0]);
+					}
+					state.items_processed = state.iterations() * c.pairs.size();
+					state.counters.emplace_back("kept_share", double(total) / double(c.pairs.size()));
+				});
+			}
+		}
+
+		// what every candidate cost before: both balls loaded and a square root
+		bench::add("narrow/exact_test/demo/100k", [](bench::State& state) {
+			const Candidates c = make_candidates(100'000, false);
+			const phs::BallStorage& balls = c.world->balls;
+			size_t total = 0;
+			for (auto _ : state) {
+				total = 0;
+				for (auto [i, j] : c.pairs) {
+					const phs::Ball a = balls.load(i), b = balls.load(j);
+					total += phs::distance(a.center, b.center) > a.radius + b.radius ? 0 : 1;
+				}
+				bench::do_not_optimize(total);
+			}
+			state.items_processed = state.iterations() * c.pairs.size();
+			state.counters.emplace_back("kept_share", double(total) / double(c.pairs.size()));
+		});
+	}
+
+	void add_agreement_benchmark() {
+		bench::add("narrow/keep_overlapping_pairs/levels_agree", [](bench::State& state) {
+			// random pairs of balls at distances around their radius sum, a few of them exactly touching
+			const size_t n = 4'096;
+			std::mt19937 gen(11);
+			std::uniform_real_distribution<float> dis(0.f, 1.f);
+			phs::BallStorage balls{};
+			std::vector<phs::Pair> pairs{};
+			for (size_t k = 0; k < n; ++k) {
+				const float r1 = 1.f + 29.f * dis(gen), r2 = 1.f + 29.f * dis(gen);
+				const float angle = 6.2831853f * dis(gen);
+				const float d = k % 16 == 0 ? r1 + r2 : (r1 + r2) * (0.9f + 0.2f * dis(gen));
+				const float x = 1000.f * dis(gen), y = 1000.f * dis(gen);
+				balls.push_back(phs::Ball(phs::Point{ Float(x), Float(y) }, Float(r1), Float(r1)));
+				balls.push_back(phs::Ball(phs::Point{ Float(x + d * std::cos(angle)), Float(y + d * std::sin(angle)) }, Float(r2), Float(r2)));
+				pairs.emplace_back(k % 2 == 0 ? 2 * k : 2 * k + 1, k % 2 == 0 ? 2 * k + 1 : 2 * k);
+			}
+
+			std::vector<std::uint32_t> expected(pairs.size()), kept(pairs.size());
+			expected.resize(phs::keep_overlapping_pairs(balls, pairs.data(), pairs.size(), expected.data(), phs::SimdLevel::scalar));
+			size_t dropped = 0, differing = 0;
+			for (auto _ : state) {
+				size_t e = 0;
+				for (size_t k = 0; k < pairs.size(); ++k) {
+					const auto [i, j] = pairs[k];
+					const bool overlaps = not (phs::distance(balls.center(i), balls.center(j)) > balls.radius[i] + balls.radius[j]);
+					const bool found = e < expected.size() and expected[e] == k;
+					e += found ? 1 : 0;
+					dropped += overlaps and not found ? 1 : 0;
+				}
+				for (phs::SimdLevel level : levels) {
+					if (level > phs::supported_simd_level())
+						continue;
+					kept.resize(pairs.size());
+					kept.resize(phs::keep_overlapping_pairs(balls, pairs.data(), pairs.size(), kept.data(), level));
+					differing += kept == expected ? 0 : 1;
+				}
+			}
+			if (dropped > 0 or differing > 0)
+				state.error(std::to_string(dropped) + " overlapping pairs left out and " + std::to_string(differing) + " kernels keeping other pairs");
+			state.counters.emplace_back("kept", double(expected.size()));
+		});
+	}
+
+	void add_wall_benchmarks() {
+		for (bool reordered : { false, true }) {
+			const std::string scene = reordered ? "/demo_hilbert/100k" : "/demo/100k";
+			for (phs::SimdLevel level : levels) {
+				if (level > phs::supported_simd_level())
+					continue;
+				// every wall against every block, what mark_balls_near_walls does when the blocks span the scene
+				bench::add(std::string("narrow/keep_balls_near_wall/") + phs::simd_level_name(level) + scene, [level, reordered](bench::State& state) {
+					const Candidates c = make_candidates(100'000, reordered);
+					const phs::World& world = *c.world;
+					std::uint32_t kept[phs::ball_block];
+					size_t total = 0;
+					for (auto _ : state) {
+						total = 0;
+						for (size_t begin = 0; begin < world.balls.size(); begin += phs::ball_block)
+							for (const phs::Wall& wall : world.walls)
+								total += phs::keep_balls_near_wall(wall, world.balls, begin, std::min(phs::ball_block, world.balls.size() - begin), kept, level);
+						bench::do_not_optimize(kept[0]);
+					}
+					state.items_processed = state.iterations() * world.balls.size() * world.walls.size();
+					state.counters.emplace_back("kept_share", double(total) / double(world.balls.size() * world.walls.size()));
+				});
+			}
+
+			bench::add("narrow/mark_balls_near_walls" + scene, [reordered](bench::State& state) {
+				const Candidates c = make_candidates(100'000, reordered);
+				const phs::World& world = *c.world;
+				phs::WallTree wall_tree{};
+				wall_tree.build(world.walls);
+				std::uint8_t near[phs::ball_block];
+				size_t total = 0;
+				for (auto _ : state) {
+					total = 0;
+					for (size_t begin = 0; begin < world.balls.size(); begin += phs::ball_block) {
+						const size_t m = std::min(phs::ball_block, world.balls.size() - begin);
+						phs::mark_balls_near_walls(world.walls, wall_tree, world.balls, begin, m, near);
+						for (size_t k = 0; k < m; ++k)
+							total += near[k];
+					}
+				}
+				state.items_processed = state.iterations() * world.balls.size();
+				state.counters.emplace_back("near_share", double(total) / double(world.balls.size()));
+			});
+		}
+
+		// what every ball cost before: a query of the wall tree and the closest point of each wall it returns
+		bench::add("narrow/wall_query/demo/100k", [](bench::State& state) {
+			const Candidates c = make_candidates(100'000, false);
+			const phs::World& world = *c.world;
+			phs::WallTree wall_tree{};
+			wall_tree.build(world.walls);
+			size_t total = 0;
+			for (auto _ : state) {
+				total = 0;
+				for (size_t i = 0; i < world.balls.size(); ++i) {
+					const phs::Ball ball = world.balls.load(i);
+					wall_tree.query(ball.center.x, ball.center.y, ball.radius, [&](size_t j) {
+						const phs::Circle closest = world.walls[j].closest_circle(ball.center);
+						total += phs::distance(closest.center, ball.center) > closest.radius + ball.radius ? 0 : 1;
+					});
+				}
+				bench::do_not_optimize(total);
+			}
+			state.items_processed = state.iterations() * world.balls.size();
+			state.counters.emplace_back("overlaps", double(total));
+		});
+	}
+
+	void add_wall_agreement_benchmark() {
+		bench::add("narrow/keep_balls_near_wall/levels_agree", [](bench::State& state) {
+			// balls at distances around the touching one from walls of every length, up to one a single point,
+			// some beyond the ends and some far from the origin, where the projection rounds the most
+			std::mt19937 gen(13);
+			std::uniform_real_distribution<float> dis(0.f, 1.f);
+			std::vector<phs::Wall> walls{};
+			for (size_t w = 0; w < 32; ++w) {
+				const float length = w == 0 ? 0.f : std::pow(10.f, 4.f * dis(gen)), angle = 6.2831853f * dis(gen);
+				const float x = (w % 4 == 0 ? 100'000.f : 1'000.f) * dis(gen), y = 1'000.f * dis(gen);
+				walls.emplace_back(phs::Point{ Float(x), Float(y) }, phs::Point{ Float(x + length * std::cos(angle)), Float(y + length * std::sin(angle)) }, Float(1.f + 9.f * dis(gen)));
+			}
+
+			const size_t n = 4'096;
+			phs::BallStorage balls{};
+			for (size_t k = 0; k < n; ++k) {
+				const phs::Wall& wall = walls[k % walls.size()];
+				const float t = -0.2f + 1.4f * dis(gen), r = 1.f + 29.f * dis(gen), angle = 6.2831853f * dis(gen);
+				const float d = (float(wall.radius) + r) * (k % 16 == 0 ? 1.f : 0.9f + 0.2f * dis(gen));
+				const float px = float(wall.beg.x) + t * float(wall.end.x - wall.beg.x), py = float(wall.beg.y) + t * float(wall.end.y - wall.beg.y);
+				balls.push_back(phs::Ball(phs::Point{ Float(px + d * std::cos(angle)), Float(py + d * std::sin(angle)) }, Float(r), Float(r)));
+			}
+
+			std::vector<std::uint32_t> expected(n), kept(n);
+			size_t dropped = 0, differing = 0;
+			for (auto _ : state) {
+				for (const phs::Wall& wall : walls) {
+					expected.resize(n);
+					expected.resize(phs::keep_balls_near_wall(wall, balls, 0, n, expected.data(), phs::SimdLevel::scalar));
+					size_t e = 0;
+					for (size_t i = 0; i < n; ++i) {
+						const phs::Ball ball = balls.load(i);
+						const phs::Circle closest = wall.closest_circle(ball.center);
+						const bool overlaps = not (phs::distance(closest.center, ball.center) > closest.radius + ball.radius);
+						const bool found = e < expected.size() and expected[e] == i;
+						e += found ? 1 : 0;
+						dropped += overlaps and not found ? 1 : 0;
+					}
+					for (phs::SimdLevel level : levels) {
+						if (level > phs::supported_simd_level())
+							continue;
+						kept.resize(n);
+						kept.resize(phs::keep_balls_near_wall(wall, balls, 0, n, kept.data(), level));
+						differing += kept == expected ? 0 : 1;
+					}
+				}
+			}
+			if (dropped > 0 or differing > 0)
+				state.error(std::to_string(dropped) + " overlapping balls left out and " + std::to_string(differing) + " kernels keeping other balls");
+		});
+	}
+
+	const bool registered = (add_rejection_benchmarks(), add_agreement_benchmark(), add_wall_benchmarks(), add_wall_agreement_benchmark(), true);
+}
@@ -0,0 +1,66 @@
+// the cost of the stage timers on a step, and a check that the stages and counters a profiler collects agree with the step
+#include "bench.h"
+#include "physics/world.h"
+#include <cmath>
+#include <memory>
+#include <string>
+
+namespace
+{
+	using phs::Float;
+
+	std::unique_ptr<phs::World> make_world(size_t n) {
+		auto world = std::make_unique<phs::World>();
+		const Float side = Float(30) * Float(float(std::sqrt(double(n))));
+		phs::add_box_scene(*world, phs::Point{ Float(0), Float(0) }, Float(1.2) * side, side, n, 42);
+		return world;
+	}
+
+	void add_overhead_benchmarks() {
+		for (bool profiled : { false, true }) {
+			bench::add(std::string("profiler/step/") + (profiled ? "on" : "off") + "/10k", [profiled](bench::State& state) {
+				// a profiler without events or rows, so a long run measures the timers and not the growing vectors
+				phs::Profiler profiler{ 0, 0 };
+				auto world = make_world(10'000);
+				if (profiled)
+					world->profiler = &profiler;
+				world->step(Float(1.0 / 60.0));
+
+				for (auto _ : state) {
+					world->step(Float(1.0 / 60.0));
+					if (profiled)
+						profiler.end_frame();
+				}
+				state.items_processed = state.iterations() * world->balls.size();
+			});
+		}
+	}
+
+	void add_consistency_benchmark() {
+		bench::add("profiler/stages_within_step", [](bench::State& state) {
+			phs::Profiler profiler{};
+			auto world = make_world(10'000);
+			world->profiler = &profiler;
+
+			size_t wrong = 0;
+			for (auto _ : state) {
+				world->step(Float(1.0 / 60.0));
+				profiler.end_frame();
+
+				std::uint64_t stages = 0;
+				for (phs::Stage s : { phs::Stage::reorder, phs::Stage::integrate, phs::Stage::sweep, phs::Stage::broad_phase, phs::Stage::narrow_phase, phs::Stage::resolution, phs::Stage::sleep })
+					stages += profiler.last_frame_ns(s);
+				const bool counted = profiler.last_frame_counter(phs::Counter::ball_ball_cols) == world->ball_ball_cols.size()
+					and profiler.last_frame_counter(phs::Counter::ball_wall_cols) == world->ball_wall_cols.size()
+					and profiler.last_frame_counter(phs::Counter::balls) == world->balls.size();
+				wrong += stages <= profiler.last_frame_ns(phs::Stage::step) and counted ? 0 : 1;
+			}
+			if (wrong > 0)
+				state.error(std::to_string(wrong) + " frames with stages longer than their step or counters off");
+			if (profiler.histogram(phs::Stage::step).frames != profiler.frame_count())
+				state.error("the step histogram missed frames");
+		});
+	}
+
+	const bool registered = (add_overhead_benchmarks(), add_consistency_benchmark(), true);
+}
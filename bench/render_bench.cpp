@@ -0,0 +1,242 @@
+// the software rasterizer: whole frames of the box scene, immediate calls against a draw list,
+// and checks of the covered pixels, the blending and the draw list output
+#include "bench.h"
+#include "graphics/software.h"
+#include "physics/world.h"
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using phs::Float;
+
+	// the box scene fitted into a 4k frame, at 1M balls a ball is a few pixels wide
+	void add_frame_benchmarks() {
+		for (size_t n : { 10'000, 100'000, 1'000'000 }) {
+			const std::string count = n >= 1'000'000 ? std::to_string(n / 1'000'000) + "M" : std::to_string(n / 1'000) + "k";
+			for (bool parallel : { false, true }) {
+				bench::add("render/frame/" + std::string(parallel ? "parallel/" : "") + count, [n, parallel](bench::State& state) {
+					const double half_height = 250.0 * std::sqrt(double(n) / 20.0);
+					phs::World world{};
+					phs::add_box_scene(world, phs::Point{ Float(0), Float(0) }, Float(1.2 * half_height), Float(half_height), n, 42);
+
+					std::mt19937 gen(1);
+					std::uniform_real_distribution<float> dis(0.f, 1.f);
+					std::vector<gfx::Color> colors{};
+					for (size_t i = 0; i < n; ++i)
+						colors.emplace_back(dis(gen), dis(gen), dis(gen));
+
+					phs::ThreadPool pool{};
+					gfx::SoftwareRenderTarget target{ 3840, 2160 };
+					const float zoom = float(0.95 * 2160.0 / (2.0 * half_height));
+					for (auto _ : state) {
+						target.beg_draw();
+						target.clear(gfx::Color(1.f, 1.f, 1.f));
+						for (size_t i = 0; i < n; ++i)
+							target.fill_circle(1920.f + float(world.balls.x[i]) * zoom, 1080.f + float(world.balls.y[i]) * zoom, float(world.balls.radius[i]) * zoom, colors[i]);
+						if (parallel)
+							target.end_draw(pool);
+						else
+							target.end_draw();
+					}
+					state.items_processed = state.iterations() * n;
+					state.counters.emplace_back("threads", parallel ? double(pool.size()) : 1.0);
+				});
+			}
+		}
+	}
+
+	// the same 1M ball frame submitted as a draw list with 64 colors and 4096 static walls,
+	// against the same primitives submitted one call at a time
+	void add_draw_list_benchmarks() {
+		for (bool batched : { false, true }) {
+			bench::add(std::string("render/submit/") + (batched ? "draw_list" : "immediate") + "/1M", [batched](bench::State& state) {
+				const size_t n = 1'000'000;
+				std::mt19937 gen(1);
+				std::uniform_real_distribution<float> dis(0.f, 1.f);
+				std::vector<float> x(n), y(n), r(n);
+				std::vector<std::uint32_t> colors(n);
+				for (size_t i = 0; i < n; ++i) {
+					x[i] = dis(gen) * 3840.f;
+					y[i] = dis(gen) * 2160.f;
+					r[i] = 0.5f + dis(gen) * 2.f;
+					colors[i] = std::uint32_t(gen() % 64);
+				}
+
+				gfx::DrawList list{};
+				std::vector<gfx::Color> palette{};
+				for (size_t c = 0; c < 65; ++c)
+					palette.push_back(gfx::Color(dis(gen), dis(gen), dis(gen)));
+				for (const gfx::Color& c : palette)
+					list.add_color(c);
+				std::vector<float> walls{};
+				for (size_t k = 0; k < 4'096; ++k) {
+					const float wx = float(k % 64) * 60.f, wy = float(k / 64) * 33.f;
+					walls.insert(walls.end(), { wx, wy, wx + 40.f, wy + 10.f, 2.f });
+					list.add_stadium(wx, wy, wx + 40.f, wy + 10.f, 2.f, 64);
+				}
+
+				gfx::SoftwareRenderTarget target{ 3840, 2160 };
+				for (auto _ : state) {
+					if (batched) {
+						list.begin_frame();
+						list.add_circles(x.data(), y.data(), r.data(), colors.data(), n);
+						list.end_frame();
+						target.beg_draw();
+						target.draw(list);
+					}
+					else {
+						target.beg_draw();
+						target.clear(list.background);
+						for (size_t i = 0; i < n; ++i)
+							target.fill_circle(x[i], y[i], r[i], palette[colors[i]]);
+						for (size_t k = 0; k < walls.size(); k += 5) {
+							const float* w = walls.data() + k;
+							target.draw_line(w[0], w[1], w[2], w[3], palette[64], 2.f * w[4]);
+							target.fill_circle(w[0], w[1], w[4], palette[64]);
+							target.fill_circle(w[2], w[3], w[4], palette[64]);
+						}
+					}
+				}
+				state.items_processed = state.iterations() * n;
+			});
+		}
+	}
+
+	// a draw list has to give the same pixels as the immediate calls made in its batch order
+	void add_draw_list_check() {
+		bench::add("render/draw_list/matches_immediate", [](bench::State& state) {
+			std::mt19937 gen(2);
+			std::uniform_real_distribution<float> dis(0.f, 1.f);
+			gfx::DrawList list{};
+			for (size_t c = 0; c < 8; ++c)
+				list.add_color(gfx::Color(dis(gen), dis(gen), dis(gen), c % 2 == 0 ? 1.f : 0.5f));
+			list.add_stadium(20.f, 20.f, 300.f, 180.f, 6.f, 1);
+			list.add_stadium(300.f, 20.f, 20.f, 180.f, 4.f, 0);
+
+			size_t mismatches = 0;
+			for (auto _ : state) {
+				list.begin_frame();
+				for (size_t i = 0; i < 2'000; ++i)
+					list.add_circle(dis(gen) * 320.f, dis(gen) * 200.f, dis(gen) * 6.f, std::uint32_t(gen() % 8));
+				list.add_line(0.f, 0.f, 320.f, 200.f, 3, 2.f);
+				list.end_frame();
+
+				gfx::SoftwareRenderTarget batched{ 320, 200 }, immediate{ 320, 200 };
+				batched.beg_draw();
+				batched.draw(list);
+				batched.end_draw();
+
+				immediate.beg_draw();
+				immediate.clear(list.background);
+				for (const auto& batch : list.circle_batches())
+					for (size_t i = batch.begin; i < batch.end; ++i)
+						immediate.fill_circle(list.circles()[i].x, list.circles()[i].y, list.circles()[i].r, list.color(batch.color));
+				for (const auto& batch : list.stadium_batches()) {
+					for (size_t k = batch.begin; k < batch.end; ++k) {
+						const float* w = list.stadiums().data() + 5 * k;
+						immediate.draw_line(w[0], w[1], w[2], w[3], list.color(batch.color), 2.f * w[4]);
+						immediate.fill_circle(w[0], w[1], w[4], list.color(batch.color));
+						immediate.fill_circle(w[2], w[3], w[4], list.color(batch.color));
+					}
+				}
+				for (const auto& line : list.lines())
+					immediate.draw_line(line.x0, line.y0, line.x1, line.y1, list.color(line.color), line.thickness);
+				immediate.end_draw();
+
+				for (size_t p = 0; p < 320 * 200; ++p)
+					mismatches += batched.pixels()[p] == immediate.pixels()[p] ? 0 : 1;
+			}
+			if (mismatches > 0)
+				state.error(std::to_string(mismatches) + " pixels of the draw list differ from the immediate calls");
+		});
+	}
+
+	// two lists with one wall each drawn by the same target, the second must not get the cached wall of the first
+	void add_stadium_cache_check() {
+		bench::add("render/draw_list/stadium_cache_per_list", [](bench::State& state) {
+			gfx::DrawList first{}, second{};
+			for (gfx::DrawList* list : { &first, &second }) {
+				list->add_color(gfx::Color(0.f, 0.f, 0.f));
+				list->begin_frame();
+				list->end_frame();
+			}
+			first.add_stadium(20.f, 20.f, 300.f, 20.f, 6.f, 0);
+			second.add_stadium(20.f, 180.f, 300.f, 180.f, 6.f, 0);
+			first.end_frame();
+			second.end_frame();
+
+			size_t mismatches = 0;
+			for (auto _ : state) {
+				gfx::SoftwareRenderTarget shared{ 320, 200 }, fresh{ 320, 200 };
+				for (gfx::DrawList* list : { &first, &second }) {
+					shared.beg_draw();
+					shared.draw(*list);
+					shared.end_draw();
+				}
+				fresh.beg_draw();
+				fresh.draw(second);
+				fresh.end_draw();
+				for (size_t p = 0; p < 320 * 200; ++p)
+					mismatches += shared.pixels()[p] == fresh.pixels()[p] ? 0 : 1;
+			}
+			if (mismatches > 0)
+				state.error(std::to_string(mismatches) + " pixels of the second list differ when its target drew another list before");
+		});
+	}
+
+	size_t count_pixels(const gfx::SoftwareRenderTarget& target, std::uint32_t color) {
+		size_t count = 0;
+		for (size_t i = 0; i < target.get_width() * target.get_height(); ++i)
+			count += target.pixels()[i] == color ? 1 : 0;
+		return count;
+	}
+
+	// covered pixel counts against the exact areas, shapes cut by tile borders, and a half transparent fill
+	void add_coverage_benchmark() {
+		bench::add("render/coverage", [](bench::State& state) {
+			const std::uint32_t white = 0xffffffffu, red = 0xff0000ffu;
+			std::vector<std::string> failures{};
+			for (auto _ : state) {
+				gfx::SoftwareRenderTarget target{ 300, 200 };
+				failures.clear();
+
+				target.beg_draw();
+				target.clear(gfx::Color(1.f, 1.f, 1.f));
+				target.fill_circle(100.3f, 80.7f, 40.f, gfx::Color(1.f, 0.f, 0.f));
+				target.end_draw();
+				const double circle = double(count_pixels(target, red));
+				if (std::abs(circle - std::numbers::pi * 1600.0) > 0.01 * std::numbers::pi * 1600.0)
+					failures.push_back("circle covers " + std::to_string(size_t(circle)) + " pixels");
+
+				// an axis aligned rectangle with corners on pixel borders, given clockwise and counter clockwise
+				for (bool reversed : { false, true }) {
+					target.beg_draw();
+					target.clear(gfx::Color(1.f, 1.f, 1.f));
+					if (reversed)
+						target.fill_quad(50.f, 150.f, 250.f, 150.f, 250.f, 30.f, 50.f, 30.f, gfx::Color(1.f, 0.f, 0.f));
+					else
+						target.fill_quad(50.f, 30.f, 250.f, 30.f, 250.f, 150.f, 50.f, 150.f, gfx::Color(1.f, 0.f, 0.f));
+					target.end_draw();
+					if (count_pixels(target, red) != 200 * 120)
+						failures.push_back("rectangle covers " + std::to_string(count_pixels(target, red)) + " pixels");
+				}
+
+				target.beg_draw();
+				target.clear(gfx::Color(1.f, 1.f, 1.f));
+				target.fill_quad(10.f, 10.f, 290.f, 10.f, 290.f, 190.f, 10.f, 190.f, gfx::Color(1.f, 0.f, 0.f, 0.5f));
+				target.end_draw();
+				const std::uint32_t blended = target.pixels()[100 * 300 + 150];
+				if (blended != 0xff7f7fffu or target.pixels()[0] != white)
+					failures.push_back("half transparent red over white gave " + std::to_string(blended));
+			}
+			for (const auto& failure : failures)
+				state.error(failure);
+		});
+	}
+
+	const bool registered = (add_frame_benchmarks(), add_draw_list_benchmarks(), add_draw_list_check(), add_stadium_cache_check(), add_coverage_benchmark(), true);
+}
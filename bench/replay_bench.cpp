@@ -0,0 +1,110 @@
+// playing back replay logs, and checks that an unchanged replay matches every step while a changed impulse is caught
+// at exactly the step it was applied to, and that a log whose counts do not fit the file is rejected
+#include "bench.h"
+#include "physics/replay.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using phs::Float;
+
+	// a minute of the demo scene at 120 Hz with a flick every second
+	phs::ReplayLog record_demo(bool use_solver) {
+		phs::World world{};
+		phs::ReplayScene scene{};
+		scene.seed = 11;
+		scene.continuous = true;
+		scene.use_solver = use_solver;
+		phs::ReplayRecorder recorder{ world, scene };
+
+		std::mt19937 gen(5);
+		std::uniform_real_distribution<float> dis(-1.f, 1.f);
+		for (size_t s = 0; s < 7'200; ++s) {
+			if (s % 120 == 60)
+				recorder.impulse(gen() % world.balls.size(), phs::Vector{ Float(dis(gen) * 20000.f), Float(dis(gen) * 20000.f) });
+			recorder.step(Float(1.0 / 120.0));
+		}
+		return recorder.log();
+	}
+
+	void add_play_benchmarks() {
+		for (bool use_solver : { false, true }) {
+			const std::string name = use_solver ? "demo_solver" : "demo";
+			bench::add("replay/play/" + name, [use_solver](bench::State& state) {
+				const phs::ReplayLog log = record_demo(use_solver);
+				size_t diverged = 0;
+				for (auto _ : state) {
+					phs::ReplayPlayer player{ log };
+					diverged += player.run() ? 1 : 0;
+				}
+				if (diverged > 0)
+					state.error(std::to_string(diverged) + " replays diverged from their own recording");
+				state.items_processed = state.iterations() * log.hashes.size();
+			});
+		}
+	}
+
+	void add_divergence_benchmark() {
+		bench::add("replay/find_divergence", [](bench::State& state) {
+			phs::ReplayLog log = record_demo(false);
+			const size_t changed = 30;
+			log.impulses[changed].acceleration.x += Float(1);
+
+			size_t wrong = 0;
+			for (auto _ : state) {
+				phs::ReplayPlayer player{ log };
+				const std::optional<size_t> diverged = player.run();
+				wrong += diverged == std::optional<size_t>(size_t(log.impulses[changed].step)) ? 0 : 1;
+			}
+			if (wrong > 0)
+				state.error(std::to_string(wrong) + " replays did not stop at the step of the changed impulse");
+			state.items_processed = state.iterations() * log.impulses[changed].step;
+		});
+	}
+
+	// counts whose products with the record sizes wrap around to a small number, loading has to throw before it
+	// reserves anything
+	void add_corrupt_count_benchmark() {
+		bench::add("replay/rejects_corrupt_counts", [](bench::State& state) {
+			const auto path = std::filesystem::temp_directory_path() / "bench_corrupt.phsr";
+			phs::save_replay(record_demo(false), path);
+			std::ifstream in(path, std::ios::binary);
+			const std::vector<char> original{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+			in.close();
+
+			// byte offsets of impulse_count and hash_count in the version 2 header, and the values written there
+			const std::pair<size_t, std::uint64_t> edits[] = {
+				{ 56, (std::uint64_t(1) << 59) + 1 }, { 64, (std::uint64_t(1) << 61) + 1 }, { 56, original.size() }, { 64, original.size() },
+			};
+			size_t accepted = 0;
+			for (auto _ : state) {
+				for (const auto& [offset, count] : edits) {
+					std::vector<char> bytes = original;
+					std::memcpy(bytes.data() + offset, &count, sizeof(count));
+					std::ofstream(path, std::ios::binary).write(bytes.data(), std::streamsize(bytes.size()));
+					try {
+						phs::load_replay(path);
+						accepted += 1;
+					}
+					catch (const std::runtime_error&) {
+					}
+				}
+			}
+			if (accepted > 0)
+				state.error(std::to_string(accepted) + " replays with a corrupt count were loaded");
+			std::filesystem::remove(path);
+		});
+	}
+
+	const bool registered = (add_play_benchmarks(), add_divergence_benchmark(), add_corrupt_count_benchmark(), true);
+}
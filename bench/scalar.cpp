@@ -0,0 +1,50 @@
+// step throughput and energy drift of one scalar build, compiled once per Float
+// (bench_scalar_float, bench_scalar_double, bench_scalar_fixed), every build starts from the same scene
+#include "physics/world.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+#if defined(PHS_SCALAR_DOUBLE)
+	constexpr const char* scalar_name = "double";
+#elif defined(PHS_SCALAR_FIXED)
+	constexpr const char* scalar_name = "fixed";
+#else
+	constexpr const char* scalar_name = "float";
+#endif
+
+	// kinetic plus potential energy in the gravity field, accumulated in double for every build
+	double total_energy(const phs::World& world) {
+		double energy = 0.0;
+		for (size_t i = 0; i < world.balls.size(); ++i) {
+			const double mass = 1.0 / double(world.balls.inv_mass[i]);
+			energy += 0.5 * mass * double(phs::length2(world.balls.velocity(i)));
+			energy -= mass * (double(world.gravity.x) * double(world.balls.x[i]) + double(world.gravity.y) * double(world.balls.y[i]));
+		}
+		return energy;
+	}
+}
+
+int main()
+{
+	std::printf("%8s %10s %8s %12s %14s\n", "scalar", "balls", "steps", "steps/s", "energy drift");
+
+	for (size_t n : { 1'000, 10'000, 100'000 }) {
+		const size_t steps = n <= 10'000 ? 600 : 60;
+		const double scale = std::sqrt(double(n) / 20.0);
+
+		phs::World world{};
+		phs::add_box_scene(world, phs::Point{ phs::Float(0), phs::Float(0) }, phs::Float(300.0 * scale), phs::Float(250.0 * scale), n, 42);
+
+		const double e0 = total_energy(world);
+		const auto beg = std::chrono::steady_clock::now();
+		for (size_t s = 0; s < steps; ++s)
+			world.step(phs::Float(1.0 / 60.0));
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+		const double e1 = total_energy(world);
+
+		std::printf("%8s %10zu %8zu %12.1f %13.4f%%\n", scalar_name, n, steps, double(steps) / seconds, 100.0 * (e1 - e0) / std::fabs(e0));
+	}
+}
@@ -0,0 +1,125 @@
+// publishing world snapshots through the triple buffer, a check that a reader never sees a torn or older snapshot,
+// and a check that a world stepped on the simulation thread ends exactly where the same steps on one thread end
+#include "bench.h"
+#include "physics/simulation_thread.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using phs::Float;
+
+	std::unique_ptr<phs::World> make_world(size_t n) {
+		auto world = std::make_unique<phs::World>();
+		const Float side = Float(30) * Float(float(std::sqrt(double(n))));
+		phs::add_box_scene(*world, phs::Point{ Float(0), Float(0) }, Float(1.2) * side, side, n, 42);
+		return world;
+	}
+
+	void add_capture_benchmarks() {
+		for (size_t n : { 10'000, 100'000 }) {
+			bench::add("simulation_thread/publish/" + std::to_string(n / 1'000) + "k", [n](bench::State& state) {
+				const auto world = make_world(n);
+				phs::TripleBuffer<phs::WorldSnapshot> buffer{};
+				std::uint64_t step = 0;
+				for (auto _ : state) {
+					++step;
+					buffer.back().capture(*world, step, double(step));
+					buffer.publish();
+					// the reader takes every other snapshot, so the slots keep changing hands
+					if (step % 2 == 0)
+						buffer.update();
+				}
+				bench::do_not_optimize(buffer.front().x.data());
+				state.items_processed = state.iterations() * n;
+			});
+		}
+	}
+
+	void add_consistency_benchmark() {
+		bench::add("simulation_thread/triple_buffer/consistency", [](bench::State& state) {
+			// every published value is filled with its own step number, a reader seeing two numbers in one value
+			// or a number older than the last one caught a race
+			struct Value
+			{
+				std::uint64_t step = 0;
+				std::vector<std::uint64_t> data = std::vector<std::uint64_t>(4096);
+			};
+			size_t torn = 0, older = 0, taken = 0;
+			for (auto _ : state) {
+				phs::TripleBuffer<Value> buffer{};
+				std::atomic<bool> writing{ true };
+				std::thread writer([&] {
+					for (std::uint64_t s = 1; s <= 20'000; ++s) {
+						Value& value = buffer.back();
+						value.step = s;
+						std::fill(value.data.begin(), value.data.end(), s);
+						buffer.publish();
+					}
+					writing = false;
+				});
+
+				std::uint64_t last = 0;
+				for (;;) {
+					// checked before the update, so the value published last is still taken
+					const bool was_writing = writing.load();
+					if (not buffer.update()) {
+						if (not was_writing)
+							break;
+						std::this_thread::yield();
+						continue;
+					}
+					const Value& value = buffer.front();
+					++taken;
+					older += value.step < last ? 1 : 0;
+					last = value.step;
+					for (std::uint64_t d : value.data)
+						torn += d != value.step ? 1 : 0;
+				}
+				writer.join();
+			}
+			if (torn > 0 or older > 0)
+				state.error(std::to_string(torn) + " torn values and " + std::to_string(older) + " older values taken");
+			state.counters.emplace_back("taken", double(taken) / double(state.iterations()));
+		});
+	}
+
+	void add_unpaced_benchmark() {
+		bench::add("simulation_thread/unpaced/10k", [](bench::State& state) {
+			const size_t steps = 120;
+			const auto reference = make_world(10'000);
+			for (size_t s = 0; s < steps; ++s)
+				reference->step(Float(1.0 / 120.0));
+
+			size_t wrong = 0, frames = 0;
+			for (auto _ : state) {
+				state.pause_timing();
+				const auto world = make_world(10'000);
+				state.resume_timing();
+
+				phs::SimulationThread simulation{ *world, 120.0, false, {}, steps };
+				// a reader taking whatever is newest, yielding so it does not starve the simulation on few cores
+				while (not simulation.finished()) {
+					bench::do_not_optimize(simulation.latest().x.data());
+					++frames;
+					std::this_thread::yield();
+				}
+				simulation.wait();
+
+				const phs::WorldSnapshot& last = simulation.latest();
+				wrong += last.step == steps and last.x == std::vector<Float>(reference->balls.x.begin(), reference->balls.x.begin() + last.size()) ? 0 : 1;
+			}
+			if (wrong > 0)
+				state.error(std::to_string(wrong) + " runs on the simulation thread did not end in the state of the same steps on one thread");
+			state.items_processed = state.iterations() * steps;
+			state.counters.emplace_back("reads", double(frames) / double(state.iterations()));
+		});
+	}
+
+	const bool registered = (add_capture_benchmarks(), add_consistency_benchmark(), add_unpaced_benchmark(), true);
+}
@@ -0,0 +1,201 @@
+// saving and loading world snapshots, a check that a loaded world steps on exactly like the saved one and one that
+// files whose header does not match their sections are rejected
+#include "bench.h"
+#include "physics/snapshot.h"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using phs::Float;
+
+	std::filesystem::path snapshot_path(const std::string& name) {
+		return std::filesystem::temp_directory_path() / ("bench_" + name + ".phs");
+	}
+
+	std::unique_ptr<phs::World> make_world(size_t n) {
+		auto world = std::make_unique<phs::World>();
+		const Float side = Float(30) * Float(float(std::sqrt(double(n))));
+		phs::add_box_scene(*world, phs::Point{ Float(0), Float(0) }, Float(1.2) * side, side, n, 42);
+		return world;
+	}
+
+	bool same_arrays(const phs::AlignedVector<Float>& a, const phs::AlignedVector<Float>& b) {
+		return a.size() == b.size() and std::memcmp(a.data(), b.data(), a.size() * sizeof(Float)) == 0;
+	}
+
+	bool same_balls(const phs::World& a, const phs::World& b) {
+		return same_arrays(a.balls.x, b.balls.x) and same_arrays(a.balls.y, b.balls.y)
+			and same_arrays(a.balls.vx, b.balls.vx) and same_arrays(a.balls.vy, b.balls.vy)
+			and a.balls.sleeping == b.balls.sleeping;
+	}
+
+	void add_save_load_benchmarks() {
+		for (size_t n : { 100'000, 1'000'000 }) {
+			const std::string count = n >= 1'000'000 ? std::to_string(n / 1'000'000) + "M" : std::to_string(n / 1'000) + "k";
+
+			bench::add("snapshot/save/" + count, [n, count](bench::State& state) {
+				const auto world = make_world(n);
+				const auto path = snapshot_path("save_" + count);
+				for (auto _ : state)
+					phs::save_snapshot(*world, path);
+				state.items_processed = state.iterations() * n;
+				state.counters.emplace_back("bytes", double(std::filesystem::file_size(path)));
+				std::filesystem::remove(path);
+			});
+
+			bench::add("snapshot/load/" + count, [n, count](bench::State& state) {
+				const auto path = snapshot_path("load_" + count);
+				phs::save_snapshot(*make_world(n), path);
+				phs::World world{};
+				for (auto _ : state)
+					phs::load_snapshot(world, path);
+				state.items_processed = state.iterations() * n;
+				std::filesystem::remove(path);
+			});
+		}
+	}
+
+	// saved halfway through a run with the solver, sleeping and reordering on, the loaded copy has to match the original bit for bit
+	void add_round_trip_benchmark() {
+		bench::add("snapshot/round_trip/10k", [](bench::State& state) {
+			const auto path = snapshot_path("round_trip");
+			size_t mismatches = 0;
+			for (auto _ : state) {
+				state.pause_timing();
+				auto world = make_world(10'000);
+				world->use_solver = true;
+				world->allow_sleeping = true;
+				world->reorder_interval = 25;
+				for (size_t s = 0; s < 120; ++s)
+					world->step(Float(1.0 / 60.0));
+				state.resume_timing();
+
+				phs::save_snapshot(*world, path);
+				phs::World loaded{};
+				phs::load_snapshot(loaded, path);
+
+				state.pause_timing();
+				for (size_t s = 0; s < 60; ++s) {
+					world->step(Float(1.0 / 60.0));
+					loaded.step(Float(1.0 / 60.0));
+				}
+				mismatches += same_balls(*world, loaded) and world->get_ball_ids() == loaded.get_ball_ids() ? 0 : 1;
+				state.resume_timing();
+			}
+			if (mismatches > 0)
+				state.error(std::to_string(mismatches) + " loaded worlds diverged from the saved ones");
+			state.items_processed = state.iterations() * 10'000;
+			std::filesystem::remove(path);
+		});
+	}
+
+	// every edit of the header of a valid snapshot makes it lie about its sections, every edit of its sleep state makes it
+	// index past its arrays or miscount, and every edit of its ball ids makes them no longer a permutation, loading has
+	// to throw and not read or write past the arrays
+	void add_corrupt_header_benchmark() {
+		bench::add("snapshot/rejects_corrupt_headers", [](bench::State& state) {
+			using phs::snapshot::Header;
+			const auto path = snapshot_path("corrupt");
+			auto world = make_world(20);
+			world->use_solver = true;
+			world->reorder_interval = 10;
+			world->allow_sleeping = true;
+			for (size_t s = 0; s < 30; ++s)
+				world->step(Float(1.0 / 60.0));
+			phs::save_snapshot(*world, path);
+			std::ifstream in(path, std::ios::binary);
+			const std::vector<char> original{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+			in.close();
+			Header saved{};
+			std::memcpy(&saved, original.data(), sizeof(saved));
+
+			constexpr std::uint64_t huge = std::numeric_limits<std::uint64_t>::max();
+			const std::function<void(Header&)> header_edits[] = {
+				[](Header& h) { h.ball_count = 1; },
+				[](Header& h) { h.ball_count += phs::BallStorage::lanes; },
+				[](Header& h) { h.padded_count = huge / sizeof(Float) + 1; },
+				[](Header& h) { h.wall_count += 1; },
+				[](Header& h) { h.ball_contact_count = huge / 4 + 1; },
+				[](Header& h) { h.wall_contact_count += 1; },
+				[](Header& h) { h.asleep = h.ball_count + 1; },
+				[](Header& h) { h.offset[phs::snapshot::ball_x] = huge - 63; },
+				[](Header& h) { h.size[phs::snapshot::wall_radius] += sizeof(Float); },
+				[](Header& h) { h.size[phs::snapshot::rest_time] = (h.ball_count + 1) * sizeof(Float); },
+			};
+			// (position, new value) of one ball id: out of range, far out of range and the first id twice
+			std::uint32_t first_id = 0;
+			std::memcpy(&first_id, original.data() + saved.offset[phs::snapshot::ball_id], sizeof(first_id));
+			const std::pair<size_t, std::uint32_t> id_edits[] = { { 0, 20 }, { 3, 1'000'000 }, { 1, first_id } };
+			// edits of the sleep state: an island out of range, a sleeping ball past a shortened rest time or island
+			// section, a flag asleep does not count and a flag in a padding lane
+			const auto set_flag = [&](std::vector<char>& bytes, size_t k) { bytes[size_t(saved.offset[phs::snapshot::ball_sleeping]) + k] = 1; };
+			const std::function<void(Header&, std::vector<char>&)> sleep_edits[] = {
+				[&](Header&, std::vector<char>& bytes) {
+					const std::uint32_t island = std::uint32_t(saved.ball_count);
+					std::memcpy(bytes.data() + saved.offset[phs::snapshot::island] + 2 * sizeof(island), &island, sizeof(island));
+				},
+				[&](Header& h, std::vector<char>& bytes) { set_flag(bytes, 5); h.asleep += 1; h.size[phs::snapshot::rest_time] = 0; },
+				[&](Header& h, std::vector<char>& bytes) { set_flag(bytes, 5); h.asleep += 1; h.size[phs::snapshot::island] = 4 * sizeof(std::uint32_t); },
+				[&](Header&, std::vector<char>& bytes) { set_flag(bytes, 5); },
+				[&](Header& h, std::vector<char>& bytes) { set_flag(bytes, size_t(saved.ball_count)); h.asleep += 1; },
+			};
+
+			const auto loads = [&](const std::vector<char>& bytes) {
+				std::ofstream(path, std::ios::binary).write(bytes.data(), std::streamsize(bytes.size()));
+				try {
+					phs::World loaded{};
+					phs::load_snapshot(loaded, path);
+					return true;
+				}
+				catch (const std::runtime_error&) {
+					return false;
+				}
+			};
+			size_t accepted = 0;
+			for (auto _ : state) {
+				for (const auto& edit : header_edits) {
+					std::vector<char> bytes = original;
+					Header h = saved;
+					edit(h);
+					std::memcpy(bytes.data(), &h, sizeof(h));
+					accepted += loads(bytes) ? 1 : 0;
+				}
+				for (const auto& edit : sleep_edits) {
+					std::vector<char> bytes = original;
+					Header h = saved;
+					edit(h, bytes);
+					std::memcpy(bytes.data(), &h, sizeof(h));
+					accepted += loads(bytes) ? 1 : 0;
+				}
+				for (const auto& [k, id] : id_edits) {
+					std::vector<char> bytes = original;
+					std::memcpy(bytes.data() + saved.offset[phs::snapshot::ball_id] + k * sizeof(id), &id, sizeof(id));
+					accepted += loads(bytes) ? 1 : 0;
+				}
+			}
+			if (saved.size[phs::snapshot::ball_id] == 0)
+				state.error("the snapshot of a reordered world has no ball ids");
+			if (saved.size[phs::snapshot::island] != saved.ball_count * sizeof(std::uint32_t) or saved.asleep != 0
+				or saved.padded_count == saved.ball_count)
+				state.error("the snapshot does not have the sleep state the edits expect");
+			if (loads(original) == false)
+				state.error("the unedited snapshot was rejected");
+			if (accepted > 0)
+				state.error(std::to_string(accepted) + " snapshots with a corrupt header or ball ids were loaded");
+			std::filesystem::remove(path);
+		});
+	}
+
+	const bool registered = (add_save_load_benchmarks(), add_round_trip_benchmark(), add_corrupt_header_benchmark(), true);
+}
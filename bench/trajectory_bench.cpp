@@ -0,0 +1,143 @@
+// recording trajectories while stepping, seeking in them, and a check that read back frames match the world within
+// the quantization step
+#include "bench.h"
+#include "physics/trajectory.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using phs::Float;
+
+	std::filesystem::path trajectory_path(const std::string& name) {
+		return std::filesystem::temp_directory_path() / ("bench_" + name + ".phst");
+	}
+
+	std::unique_ptr<phs::World> make_world(size_t n) {
+		auto world = std::make_unique<phs::World>();
+		const Float side = Float(30) * Float(float(std::sqrt(double(n))));
+		phs::add_box_scene(*world, phs::Point{ Float(0), Float(0) }, Float(1.2) * side, side, n, 42);
+		return world;
+	}
+
+	// the cost record adds to a step, and the bytes a frame takes against the 16 bytes per ball of raw floats
+	void add_record_benchmarks() {
+		for (size_t n : { 10'000, 100'000 }) {
+			const std::string count = std::to_string(n / 1'000) + "k";
+			bench::add("trajectory/record/" + count, [n, count](bench::State& state) {
+				const auto path = trajectory_path("record_" + count);
+				auto world = make_world(n);
+				world->step(Float(1.0 / 60.0));
+
+				size_t frames = 0;
+				{
+					phs::TrajectoryRecorder recorder{ path };
+					for (auto _ : state) {
+						state.pause_timing();
+						world->step(Float(1.0 / 60.0));
+						state.resume_timing();
+						recorder.record(*world);
+					}
+					recorder.close();
+					frames = recorder.frame_count();
+				}
+				state.items_processed = state.iterations() * n;
+				state.counters.emplace_back("bytes_per_ball", double(std::filesystem::file_size(path)) / double(frames * n));
+				std::filesystem::remove(path);
+			});
+		}
+	}
+
+	// random frames out of 1200 recorded steps of 10k balls
+	void add_seek_benchmark() {
+		bench::add("trajectory/seek/10k", [](bench::State& state) {
+			const auto path = trajectory_path("seek");
+			{
+				auto world = make_world(10'000);
+				phs::TrajectoryRecorder recorder{ path };
+				for (size_t s = 0; s < 1'200; ++s) {
+					world->step(Float(1.0 / 60.0));
+					recorder.record(*world);
+				}
+			}
+
+			phs::TrajectoryReader reader{ path };
+			std::mt19937 gen(7);
+			std::uniform_int_distribution<size_t> dis(0, reader.frame_count() - 1);
+			for (auto _ : state)
+				bench::do_not_optimize(reader.frame(dis(gen)).x.data());
+			state.items_processed = state.iterations();
+			std::filesystem::remove(path);
+		});
+	}
+
+	// every frame read back, in order and then in random order, has to be within half a quantization step of the world
+	// (plus the rounding of the Float), a ball added halfway starts a new block
+	void add_accuracy_benchmark() {
+		bench::add("trajectory/accuracy/1k", [](bench::State& state) {
+			const auto path = trajectory_path("accuracy");
+			const double position_step = 1.0 / 64.0, velocity_step = 1.0 / 64.0;
+			size_t mismatches = 0;
+			for (auto _ : state) {
+				state.pause_timing();
+				auto world = make_world(1'000);
+				std::vector<std::vector<Float>> expected{};
+				{
+					phs::TrajectoryRecorder recorder{ path, 50, position_step, velocity_step };
+					for (size_t s = 0; s < 300; ++s) {
+						if (s == 175)
+							world->balls.push_back(phs::Ball(phs::Point{ Float(0), Float(0) }, Float(10)));
+						world->step(Float(1.0 / 60.0));
+						recorder.record(*world);
+
+						auto& frame = expected.emplace_back();
+						for (const auto* values : { &world->balls.x, &world->balls.y, &world->balls.vx, &world->balls.vy })
+							frame.insert(frame.end(), values->begin(), values->begin() + world->balls.size());
+					}
+				}
+				state.resume_timing();
+
+				phs::TrajectoryReader reader{ path };
+				std::vector<size_t> order(reader.frame_count());
+				for (size_t f = 0; f < order.size(); ++f)
+					order[f] = f;
+				const size_t in_order = order.size();
+				std::shuffle(order.begin(), order.end(), std::mt19937(3));
+				for (size_t f = 0; f < in_order; ++f)
+					order.push_back(f);
+
+				mismatches += reader.frame_count() == expected.size() ? 0 : 1;
+				for (size_t f : order) {
+					if (f >= expected.size())
+						break;
+					const phs::TrajectoryFrame& frame = reader.frame(f);
+					const std::vector<Float>& want = expected[f];
+					const size_t n = want.size() / 4;
+					if (frame.x.size() != n) {
+						++mismatches;
+						continue;
+					}
+					double error = 0.0;
+					for (size_t i = 0; i < n; ++i) {
+						error = std::max(error, std::abs(double(frame.x[i]) - double(want[i])) / position_step);
+						error = std::max(error, std::abs(double(frame.y[i]) - double(want[n + i])) / position_step);
+						error = std::max(error, std::abs(double(frame.vx[i]) - double(want[2 * n + i])) / velocity_step);
+						error = std::max(error, std::abs(double(frame.vy[i]) - double(want[3 * n + i])) / velocity_step);
+					}
+					mismatches += error <= 0.51 ? 0 : 1;
+				}
+			}
+			if (mismatches > 0)
+				state.error(std::to_string(mismatches) + " frames read back differ from the recorded world");
+			state.items_processed = state.iterations() * 300;
+			std::filesystem::remove(path);
+		});
+	}
+
+	const bool registered = (add_record_benchmarks(), add_seek_benchmark(), add_accuracy_benchmark(), true);
+}
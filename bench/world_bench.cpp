@@ -0,0 +1,525 @@
+// full world steps of the box scene at 1k to 1M balls and a few densities, and with up to 65k walls
+#include "bench.h"
+#include "physics/replay.h"
+#include "physics/world.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using phs::Float;
+
+	struct Density
+	{
+		const char* name;
+		// share of the box area covered by balls
+		double fill;
+	};
+
+	constexpr Density densities[] = { { "sparse", 0.02 }, { "demo", 0.06 }, { "dense", 0.25 } };
+	constexpr size_t sizes[] = { 1'000, 10'000, 100'000, 1'000'000 };
+
+	std::string count_name(size_t n) {
+		return n >= 1'000'000 ? std::to_string(n / 1'000'000) + "M" : std::to_string(n / 1'000) + "k";
+	}
+
+	// add_box_scene spreads the balls over 0.9 of a 2w x 2h box with w : h = 300 : 250,
+	// radii are uniform in [5, 30], so the mean ball area is pi * (30^3 - 5^3) / (3 * 25)
+	double box_half_height(size_t n, double fill) {
+		const double mean_area = std::numbers::pi * (30.0 * 30.0 * 30.0 - 5.0 * 5.0 * 5.0) / 75.0;
+		const double box_area = double(n) * mean_area / fill;
+		return std::sqrt(box_area / (4.0 * 0.81 * 1.2));
+	}
+
+	std::unique_ptr<phs::World> make_world(size_t n, double fill) {
+		const double h = box_half_height(n, fill);
+
+		auto world = std::make_unique<phs::World>();
+		phs::add_box_scene(*world, phs::Point{ Float(0), Float(0) }, Float(1.2 * h), Float(h), n, 42);
+		return world;
+	}
+
+	void add_step_benchmarks() {
+		for (const auto& density : densities) {
+			for (size_t n : sizes) {
+				bench::add("world/step/" + std::string(density.name) + "/" + count_name(n), [n, density](bench::State& state) {
+					auto world = make_world(n, density.fill);
+					world->step(Float(1.0 / 60.0));
+
+					size_t contacts = 0;
+					for (auto _ : state) {
+						world->step(Float(1.0 / 60.0));
+						contacts += world->ball_ball_cols.size() + world->ball_wall_cols.size();
+					}
+					state.items_processed = state.iterations() * n;
+					state.counters.emplace_back("contacts_per_step", double(contacts) / double(state.iterations()));
+				});
+			}
+		}
+
+		for (size_t n : { 100'000, 1'000'000 }) {
+			bench::add("world/step_parallel/demo/" + count_name(n), [n](bench::State& state) {
+				phs::ThreadPool pool{};
+				auto world = make_world(n, 0.06);
+				world->step(Float(1.0 / 60.0), pool);
+
+				for (auto _ : state)
+					world->step(Float(1.0 / 60.0), pool);
+				state.items_processed = state.iterations() * n;
+				state.counters.emplace_back("threads", double(pool.size()));
+			});
+		}
+
+		// the parallel step has to give the same world on any number of threads, with every stage that has its own
+		// parallel or ordered path turned on, the state hash of every step is compared against the single thread pool
+		bench::add("world/step_parallel/same_for_any_thread_count", [](bench::State& state) {
+			// at least 3 threads for the last pool, so a machine with one or two cores still runs three different counts
+			const size_t thread_counts[] = { 1, 2, std::max(size_t(std::thread::hardware_concurrency()), size_t(3)) };
+			constexpr size_t steps = 300;
+			size_t differing = 0, sleeping = 0;
+			for (auto _ : state) {
+				std::vector<std::uint64_t> first{};
+				for (size_t threads : thread_counts) {
+					phs::ThreadPool pool{ threads };
+					auto world = make_world(3'000, 0.25);
+					world->use_solver = true;
+					world->allow_sleeping = true;
+					world->reorder_interval = 20;
+
+					std::vector<std::uint64_t> hashes{};
+					for (size_t s = 0; s < steps; ++s) {
+						world->step(Float(1.0 / 60.0), pool);
+						hashes.push_back(phs::state_hash(*world));
+					}
+					if (first.empty())
+						first = hashes;
+					else
+						differing += std::ranges::mismatch(first, hashes).in1 == first.end() ? 0 : 1;
+					sleeping = size_t(std::ranges::count_if(world->balls.sleeping, [](std::uint8_t flag) { return flag != 0; }));
+				}
+			}
+			if (differing > 0)
+				state.error(std::to_string(differing) + " thread counts whose steps hashed differently from one thread");
+			if (sleeping == 0)
+				state.error("no ball fell asleep, the sleeping path went untested");
+			state.items_processed = state.iterations() * 3 * steps * 3'000;
+		});
+	}
+
+	// the demo box at 10k balls with short walls on a jittered lattice, like the segments of a maze outline
+	void add_wall_benchmarks() {
+		for (size_t w : { 16, 256, 4'096, 65'536 }) {
+			bench::add("world/step_walls/" + std::to_string(w), [w](bench::State& state) {
+				const size_t n = 10'000;
+				const double h = box_half_height(n, 0.06);
+				auto world = make_world(n, 0.06);
+
+				std::mt19937 gen(7);
+				std::uniform_real_distribution<double> dis(0.0, 1.0);
+				const size_t side = size_t(std::ceil(std::sqrt(double(w))));
+				const double cell_x = 2.4 * h / double(side), cell_y = 2.0 * h / double(side);
+				for (size_t k = 0; k < w; ++k) {
+					const double x = -1.2 * h + (double(k % side) + dis(gen)) * cell_x;
+					const double y = -h + (double(k / side) + dis(gen)) * cell_y;
+					const double angle = dis(gen) * std::numbers::pi;
+					const double length = 0.3 * cell_x;
+					world->walls.emplace_back(
+						phs::Point{ Float(x), Float(y) },
+						phs::Point{ Float(x + length * std::cos(angle)), Float(y + length * std::sin(angle)) },
+						Float(2));
+				}
+				world->step(Float(1.0 / 60.0));
+
+				size_t contacts = 0;
+				for (auto _ : state) {
+					world->step(Float(1.0 / 60.0));
+					contacts += world->ball_wall_cols.size();
+				}
+				state.items_processed = state.iterations() * n;
+				state.counters.emplace_back("ball_wall_contacts_per_step", double(contacts) / double(state.iterations()));
+			});
+		}
+	}
+
+	// a wall moved in place onto resting balls, the next step has to find it without an update_walls call
+	void add_moved_wall_benchmark() {
+		bench::add("world/walls/moved_in_place", [](bench::State& state) {
+			size_t missed = 0;
+			for (auto _ : state) {
+				state.pause_timing();
+				auto world = std::make_unique<phs::World>();
+				world->gravity = phs::Vector{ Float(0), Float(0) };
+				world->walls.emplace_back(phs::Point{ Float(0), Float(-1000) }, phs::Point{ Float(0), Float(1000) }, Float(1));
+				for (size_t k = 0; k < 100; ++k)
+					world->balls.push_back(phs::Ball(phs::Point{ Float(-497), Float(-594.0 + 12.0 * double(k)) }, Float(5)));
+				world->step(Float(1.0 / 60.0));
+				world->walls[0] = phs::Wall(phs::Point{ Float(-500), Float(-1000) }, phs::Point{ Float(-500), Float(1000) }, Float(1));
+				state.resume_timing();
+
+				world->step(Float(1.0 / 60.0));
+
+				state.pause_timing();
+				missed += world->ball_wall_cols.size() == world->balls.size() ? 0 : 1;
+				state.resume_timing();
+			}
+			if (missed > 0)
+				state.error(std::to_string(missed) + " steps that did not collide the balls with the moved wall");
+			state.items_processed = state.iterations() * 100;
+		});
+	}
+
+	// balls fired at a wall thinner than their step length, a large dt must not let any of them through
+	// the wall closes a box, and a column of balls along it and a row along the top start inside the contact band
+	// heading out, where a cut back ball is left and where add_box_scene can place them
+	std::unique_ptr<phs::World> make_firing_range(bool continuous) {
+		auto world = std::make_unique<phs::World>();
+		world->continuous = continuous;
+		world->gravity = phs::Vector{ Float(0), Float(0) };
+		world->walls.emplace_back(phs::Point{ Float(0), Float(-1000) }, phs::Point{ Float(0), Float(1000) }, Float(1));
+		world->walls.emplace_back(phs::Point{ Float(-1000), Float(-1000) }, phs::Point{ Float(-1000), Float(1000) }, Float(1));
+		world->walls.emplace_back(phs::Point{ Float(-1000), Float(1000) }, phs::Point{ Float(0), Float(1000) }, Float(1));
+		world->walls.emplace_back(phs::Point{ Float(-1000), Float(-1000) }, phs::Point{ Float(0), Float(-1000) }, Float(1));
+
+		for (size_t k = 0; k < 1'000; ++k) {
+			phs::Ball ball(phs::Point{ Float(-20.0 - 12.0 * double(k % 10)), Float(-600.0 + 12.0 * double(k / 10)) }, Float(5));
+			ball.velocity = phs::Vector{ Float(3000), Float(0) };
+			world->balls.push_back(ball);
+		}
+		// 0.5 into the band of 6 units, deeper than the skin World::sweep leaves
+		for (size_t k = 0; k < 100; ++k) {
+			phs::Ball ball(phs::Point{ Float(-5.5), Float(-594.0 + 12.0 * double(k)) }, Float(5));
+			ball.velocity = phs::Vector{ Float(3000), Float(0) };
+			world->balls.push_back(ball);
+		}
+		for (size_t k = 0; k < 50; ++k) {
+			phs::Ball ball(phs::Point{ Float(-900.0 + 12.0 * double(k)), Float(994.5) }, Float(5));
+			ball.velocity = phs::Vector{ Float(0), Float(3000) };
+			world->balls.push_back(ball);
+		}
+		return world;
+	}
+
+	void add_continuous_benchmarks() {
+		bench::add("world/step_continuous/demo/10k", [](bench::State& state) {
+			auto world = make_world(10'000, 0.06);
+			world->continuous = true;
+			world->step(Float(1.0 / 60.0));
+
+			for (auto _ : state)
+				world->step(Float(1.0 / 60.0));
+			state.items_processed = state.iterations() * 10'000;
+		});
+
+		// a step moves every ball 300 units, the wall and the balls together are 12 units thick
+		// (NaN centers from a broken resolution count as tunneled as well)
+		bench::add("world/continuous/thin_wall", [](bench::State& state) {
+			size_t tunneled = 0;
+			for (auto _ : state) {
+				state.pause_timing();
+				auto world = make_firing_range(true);
+				state.resume_timing();
+
+				for (size_t s = 0; s < 5; ++s)
+					world->step(Float(0.1));
+
+				state.pause_timing();
+				for (size_t i = 0; i < world->balls.size(); ++i) {
+					const bool inside = world->balls.x[i] < Float(0) and world->balls.x[i] > Float(-1000)
+						and world->balls.y[i] < Float(1000) and world->balls.y[i] > Float(-1000);
+					tunneled += inside ? 0 : 1;
+				}
+				state.resume_timing();
+			}
+			if (tunneled > 0)
+				state.error(std::to_string(tunneled) + " balls went through the walls of the box");
+			state.items_processed = state.iterations() * 5 * 1'150;
+		});
+	}
+
+	// a settled pile of 2k balls, overlap and leftover motion after 10 s show how well the contacts converged
+	// iterations = 0 is the single static and dynamic pass
+	void add_solver_benchmarks() {
+		for (size_t iterations : { 0, 2, 4, 8 }) {
+			const std::string name = iterations == 0 ? "single_pass" : "solver_" + std::to_string(iterations);
+			bench::add("world/pile/" + name, [iterations](bench::State& state) {
+				auto world = make_world(2'000, 0.25);
+				world->use_solver = iterations > 0;
+				world->solver.velocity_iterations = iterations;
+				for (size_t s = 0; s < 600; ++s)
+					world->step(Float(1.0 / 60.0));
+
+				for (auto _ : state)
+					world->step(Float(1.0 / 60.0));
+
+				double overlap = 0.0, max_overlap = 0.0;
+				for (auto [i, j] : world->ball_ball_cols) {
+					const double d = double(phs::distance(world->balls.center(i), world->balls.center(j)));
+					const double o = std::max(double(world->balls.radius[i] + world->balls.radius[j]) - d, 0.0);
+					overlap += o;
+					max_overlap = std::max(max_overlap, o);
+				}
+				double speed = 0.0;
+				for (size_t i = 0; i < world->balls.size(); ++i)
+					speed += double(phs::length(world->balls.velocity(i)));
+
+				state.items_processed = state.iterations() * world->balls.size();
+				state.counters.emplace_back("mean_overlap", world->ball_ball_cols.empty() ? 0.0 : overlap / double(world->ball_ball_cols.size()));
+				state.counters.emplace_back("max_overlap", max_overlap);
+				state.counters.emplace_back("mean_speed", speed / double(world->balls.size()));
+			});
+		}
+	}
+
+	// the same kind of pile left to settle for 40 s, with and without sleeping
+	void add_sleeping_benchmarks() {
+		for (size_t n : { 2'000, 5'000 }) {
+			for (bool sleeping : { false, true }) {
+				bench::add("world/settled_pile/" + std::string(sleeping ? "sleeping/" : "awake/") + count_name(n), [n, sleeping](bench::State& state) {
+					auto world = make_world(n, 0.25);
+					world->use_solver = true;
+					world->allow_sleeping = sleeping;
+					for (size_t s = 0; s < 2400; ++s)
+						world->step(Float(1.0 / 60.0));
+
+					for (auto _ : state)
+						world->step(Float(1.0 / 60.0));
+					state.items_processed = state.iterations() * n;
+					state.counters.emplace_back("sleeping_share", double(world->sleeping_count()) / double(n));
+				});
+			}
+		}
+	}
+
+	// the uniform grid against the sort and sweep on a flowing scene and on a settled pile, where the order hardly changes
+	void add_broad_phase_benchmarks() {
+		struct Scene
+		{
+			const char* name;
+			size_t n;
+			double fill;
+			bool pile;
+		};
+		constexpr Scene scenes[] = { { "demo", 10'000, 0.06, false }, { "demo", 100'000, 0.06, false }, { "pile", 5'000, 0.25, true } };
+		for (const Scene& scene : scenes) {
+			for (auto kind : { phs::BroadPhaseKind::grid, phs::BroadPhaseKind::sweep_and_prune, phs::BroadPhaseKind::hierarchical_grid }) {
+				const std::string kind_name = kind == phs::BroadPhaseKind::grid ? "grid" : kind == phs::BroadPhaseKind::sweep_and_prune ? "sap" : "hierarchical_grid";
+				bench::add("world/broad_phase/" + kind_name + "/" + scene.name + "/" + count_name(scene.n), [scene, kind](bench::State& state) {
+					auto world = make_world(scene.n, scene.fill);
+					world->broad_phase = kind;
+					world->use_solver = scene.pile;
+					for (size_t s = 0; s < (scene.pile ? 600 : 10); ++s)
+						world->step(Float(1.0 / 60.0));
+
+					size_t pairs = 0, swaps = 0;
+					for (auto _ : state) {
+						world->step(Float(1.0 / 60.0));
+						pairs += world->ball_ball_cols.size();
+						swaps += world->get_sweep_and_prune().last_swaps();
+					}
+					state.items_processed = state.iterations() * scene.n;
+					state.counters.emplace_back("contacts_per_step", double(pairs) / double(state.iterations()));
+					if (kind == phs::BroadPhaseKind::sweep_and_prune)
+						state.counters.emplace_back("swaps_per_step", double(swaps) / double(state.iterations()));
+				});
+			}
+		}
+
+		// both broad phases have to report every overlapping pair, and the pairs the sort and sweep adds and removes
+		// have to turn the pairs of one step into those of the next
+		bench::add("world/broad_phase/sap_matches_grid", [](bench::State& state) {
+			auto world = make_world(5'000, 0.25);
+			world->broad_phase = phs::BroadPhaseKind::sweep_and_prune;
+			phs::UniformGrid grid{};
+			phs::SweepAndPrune sap{};
+			std::vector<phs::Pair> grid_pairs{}, sap_pairs{}, previous{}, expected{};
+
+			const auto overlapping = [&](std::vector<phs::Pair>& pairs) {
+				std::erase_if(pairs, [&](const phs::Pair& p) {
+					const Float r = world->balls.radius[p.first] + world->balls.radius[p.second];
+					return phs::distance2(world->balls.center(p.first), world->balls.center(p.second)) > r * r;
+				});
+				std::sort(pairs.begin(), pairs.end());
+			};
+
+			size_t missed = 0, wrong_events = 0;
+			for (auto _ : state) {
+				world->step(Float(1.0 / 60.0));
+				grid.build(world->balls);
+				sap.build(world->balls);
+
+				previous.swap(sap_pairs);
+				sap_pairs.clear();
+				sap.find_pairs(sap_pairs);
+				expected.clear();
+				std::set_difference(previous.begin(), previous.end(), sap.removed_pairs().begin(), sap.removed_pairs().end(), std::back_inserter(expected));
+				expected.insert(expected.end(), sap.added_pairs().begin(), sap.added_pairs().end());
+				std::sort(expected.begin(), expected.end());
+				wrong_events += expected == sap_pairs ? 0 : 1;
+
+				grid_pairs.clear();
+				grid.find_pairs(grid_pairs);
+				std::vector<phs::Pair> sap_overlapping = sap_pairs;
+				overlapping(grid_pairs);
+				overlapping(sap_overlapping);
+				missed += grid_pairs == sap_overlapping ? 0 : 1;
+			}
+			if (missed > 0 or wrong_events > 0)
+				state.error(std::to_string(missed) + " steps where the overlapping pairs differ and " + std::to_string(wrong_events)
+					+ " steps where the added and removed pairs do not lead from the last pairs to the new ones");
+		});
+	}
+
+	// a wide row of balls turned upright, the sweep has to follow it to the other axis and report no pair as added or
+	// removed, turning keeps every distance
+	void add_sap_axis_benchmark() {
+		bench::add("world/broad_phase/sap_turns_axis", [](bench::State& state) {
+			phs::BallStorage balls{};
+			std::mt19937 gen(5);
+			std::uniform_real_distribution<double> dis(0.0, 1.0);
+			for (size_t k = 0; k < 2'000; ++k)
+				balls.push_back(phs::Ball(phs::Point{ Float(dis(gen) * 4000.0), Float(dis(gen) * 200.0) }, Float(5.0 + dis(gen) * 10.0)));
+
+			size_t wrong = 0;
+			for (auto _ : state) {
+				phs::SweepAndPrune sap{};
+				sap.build(balls);
+				const size_t before = sap.sweep_axis();
+				for (size_t i = 0; i < balls.size(); ++i)
+					std::swap(balls.x[i], balls.y[i]);
+				sap.build(balls);
+				wrong += before == 0 and sap.sweep_axis() == 1 and sap.added_pairs().empty() and sap.removed_pairs().empty() ? 0 : 1;
+				for (size_t i = 0; i < balls.size(); ++i)
+					std::swap(balls.x[i], balls.y[i]);
+			}
+			if (wrong > 0)
+				state.error(std::to_string(wrong) + " turns the sweep did not follow or reported pairs for");
+			state.items_processed = state.iterations() * 2'000;
+		});
+	}
+
+	// the buffers grow while the balls settle and the contacts pile up, after the warm up a step must not touch the heap
+	// for a fixed run of steps, and then neither in the timed ones
+	constexpr size_t warm_up_steps = 1200;
+	constexpr size_t checked_steps = 600;
+
+	template<typename Step>
+	void check_steady_state(bench::State& state, Step step) {
+		for (size_t i = 0; i < warm_up_steps; ++i)
+			step();
+		const size_t before = bench::allocation_count();
+		for (size_t i = 0; i < checked_steps; ++i)
+			step();
+		const size_t checked = bench::allocation_count() - before;
+
+		for (auto _ : state)
+			step();
+		if (checked > 0 or state.timed_allocations() > 0)
+			state.error(std::to_string(checked) + " heap allocations in " + std::to_string(checked_steps) + " steps after "
+				+ std::to_string(warm_up_steps) + " warm up steps and " + std::to_string(state.timed_allocations()) + " in the timed ones");
+	}
+
+	// once every buffer of the world has reached its working size, a step must not touch the heap anymore
+	void add_allocation_benchmarks() {
+		for (size_t n : { 1'000, 10'000 }) {
+			bench::add("world/steady_state_allocations/" + count_name(n), [n](bench::State& state) {
+				auto world = make_world(n, 0.06);
+				check_steady_state(state, [&] { world->step(Float(1.0 / 60.0)); });
+				state.items_processed = state.iterations() * n;
+			});
+		}
+
+		bench::add("world/steady_state_allocations/sap/10k", [](bench::State& state) {
+			auto world = make_world(10'000, 0.06);
+			world->broad_phase = phs::BroadPhaseKind::sweep_and_prune;
+			check_steady_state(state, [&] { world->step(Float(1.0 / 60.0)); });
+			state.items_processed = state.iterations() * 10'000;
+		});
+
+		bench::add("world/steady_state_allocations_parallel/10k", [](bench::State& state) {
+			phs::ThreadPool pool{ 4 };
+			auto world = make_world(10'000, 0.06);
+			check_steady_state(state, [&] { world->step(Float(1.0 / 60.0), pool); });
+			state.items_processed = state.iterations() * 10'000;
+		});
+	}
+
+	void add_reorder_benchmarks() {
+		// add_box_scene places the balls at random, so in creation order neighbors are anywhere in memory,
+		// pair_span is the mean index distance of the contacts of a step, a proxy for how far apart they are in memory
+		for (size_t n : { 10'000, 100'000 }) {
+			for (size_t interval : { 0, 20 }) {
+				bench::add("world/reorder/" + std::string(interval > 0 ? "hilbert" : "off") + "/" + count_name(n), [n, interval](bench::State& state) {
+					auto world = make_world(n, 0.06);
+					world->reorder_interval = interval;
+					for (size_t s = 0; s < 20; ++s)
+						world->step(Float(1.0 / 60.0));
+
+					double span = 0.0;
+					size_t contacts = 0;
+					for (auto _ : state) {
+						world->step(Float(1.0 / 60.0));
+						for (auto [i, j] : world->ball_ball_cols)
+							span += double(i > j ? i - j : j - i);
+						contacts += world->ball_ball_cols.size();
+					}
+					state.items_processed = state.iterations() * n;
+					state.counters.emplace_back("pair_span", contacts > 0 ? span / double(contacts) : 0.0);
+				});
+			}
+		}
+
+		bench::add("world/reorder/sort/100k", [](bench::State& state) {
+			auto world = make_world(100'000, 0.06);
+			for (auto _ : state) {
+				state.pause_timing();
+				world->step(Float(1.0 / 60.0));
+				state.resume_timing();
+				world->reorder_balls();
+			}
+			state.items_processed = state.iterations() * 100'000;
+		});
+
+		// every ball keeps its id, radius and mass through the reorders, and the ids and indices stay inverse
+		bench::add("world/reorder/keeps_ball_ids", [](bench::State& state) {
+			const size_t n = 10'000;
+			const auto original = make_world(n, 0.06);
+			size_t wrong = 0;
+			for (auto _ : state) {
+				auto world = make_world(n, 0.06);
+				world->reorder_interval = 5;
+				world->allow_sleeping = true;
+				for (size_t s = 0; s < 60; ++s)
+					world->step(Float(1.0 / 60.0));
+
+				std::vector<bool> seen(n, false);
+				for (size_t i = 0; i < n; ++i) {
+					const size_t id = world->ball_id(i);
+					const bool kept = id < n and not seen[id] and world->ball_index(id) == i
+						and world->balls.radius[i] == original->balls.radius[id] and world->balls.inv_mass[i] == original->balls.inv_mass[id];
+					wrong += kept ? 0 : 1;
+					if (id < n)
+						seen[id] = true;
+				}
+			}
+			if (wrong > 0)
+				state.error(std::to_string(wrong) + " balls lost their id or their radius and mass");
+		});
+
+		bench::add("world/steady_state_allocations/reorder/10k", [](bench::State& state) {
+			auto world = make_world(10'000, 0.06);
+			world->reorder_interval = 1;
+			check_steady_state(state, [&] { world->step(Float(1.0 / 60.0)); });
+			state.items_processed = state.iterations() * 10'000;
+		});
+	}
+
+	const bool registered = (add_step_benchmarks(), add_wall_benchmarks(), add_moved_wall_benchmark(), add_continuous_benchmarks(), add_solver_benchmarks(), add_sleeping_benchmarks(), add_broad_phase_benchmarks(), add_sap_axis_benchmark(), add_allocation_benchmarks(), add_reorder_benchmarks(), true);
+}
@@ -0,0 +1,124 @@
+#include "draw_list.h"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+namespace gfx
+{
+	// the next stadium version of any list, lists on different threads change their stadiums independently
+	static std::atomic<std::uint64_t> next_stadium_version{ 2 };
+
+	std::uint32_t DrawList::add_color(Color c) {
+		palette.push_back(c);
+		return std::uint32_t(palette.size() - 1);
+	}
+
+	const Color& DrawList::color(std::uint32_t index)const {
+		return palette[index];
+	}
+
+	void DrawList::begin_frame() {
+		frame_circles.clear();
+		colors.clear();
+		frame_lines.clear();
+	}
+
+	void DrawList::add_circle(float cx, float cy, float cr, std::uint32_t color) {
+		frame_circles.push_back(Circle{ cx, cy, cr });
+		colors.push_back(color);
+	}
+
+	void DrawList::add_circles(const float* cx, const float* cy, const float* cr, const std::uint32_t* color, size_t n) {
+		const size_t first = frame_circles.size();
+		frame_circles.resize(first + n);
+		for (size_t i = 0; i < n; ++i)
+			frame_circles[first + i] = Circle{ cx[i], cy[i], cr[i] };
+		colors.insert(colors.end(), color, color + n);
+	}
+
+	void DrawList::add_line(float x0, float y0, float x1, float y1, std::uint32_t color, float thickness) {
+		frame_lines.push_back(Line{ x0, y0, x1, y1, thickness, color });
+	}
+
+	void DrawList::sort_by_color(const std::vector<std::uint32_t>& keys, std::vector<Batch>& sorted_batches) {
+		counts.assign(palette.size(), 0);
+		for (std::uint32_t key : keys) {
+			if (key >= palette.size())
+				throw std::out_of_range("color " + std::to_string(key) + " is not in the palette");
+			++counts[key];
+		}
+
+		// counts become the next free slot of every color
+		sorted_batches.clear();
+		size_t next = 0;
+		for (std::uint32_t c = 0; c < counts.size(); ++c) {
+			if (counts[c] == 0)
+				continue;
+			sorted_batches.push_back(Batch{ c, next, next + counts[c] });
+			const size_t count = counts[c];
+			counts[c] = std::uint32_t(next);
+			next += count;
+		}
+	}
+
+	void DrawList::end_frame() {
+		// one pass over the circles in submission order, scattered to as many streams as there are colors
+		sort_by_color(colors, batches);
+		sorted_circles.resize(frame_circles.size());
+		for (size_t i = 0; i < frame_circles.size(); ++i)
+			sorted_circles[counts[colors[i]]++] = frame_circles[i];
+
+		if (not stadiums_sorted) {
+			sort_by_color(stadium_colors, stadium_batch_list);
+			sorted_stadiums.resize(stadium_data.size());
+			for (size_t i = 0; i < stadium_colors.size(); ++i) {
+				const std::uint32_t k = counts[stadium_colors[i]]++;
+				for (size_t j = 0; j < 5; ++j)
+					sorted_stadiums[5 * size_t(k) + j] = stadium_data[5 * i + j];
+			}
+			stadiums_sorted = true;
+		}
+	}
+
+	void DrawList::clear_stadiums() {
+		stadium_data.clear();
+		stadium_colors.clear();
+		stadiums_sorted = false;
+		version = next_stadium_version.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void DrawList::add_stadium(float x0, float y0, float x1, float y1, float radius, std::uint32_t color) {
+		stadium_data.insert(stadium_data.end(), { x0, y0, x1, y1, radius });
+		stadium_colors.push_back(color);
+		stadiums_sorted = false;
+		version = next_stadium_version.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::uint64_t DrawList::stadium_version()const {
+		return version;
+	}
+
+	const std::vector<DrawList::Batch>& DrawList::circle_batches()const {
+		return batches;
+	}
+
+	const std::vector<DrawList::Circle>& DrawList::circles()const {
+		return sorted_circles;
+	}
+
+	const std::vector<DrawList::Batch>& DrawList::stadium_batches()const {
+		return stadium_batch_list;
+	}
+
+	const std::vector<float>& DrawList::stadiums()const {
+		return sorted_stadiums;
+	}
+
+	const std::vector<DrawList::Line>& DrawList::lines()const {
+		return frame_lines;
+	}
+
+	size_t DrawList::circle_count()const {
+		return sorted_circles.size();
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx
+{
+	struct Color
+	{
+		float r = 0.f, g = 0.f, b = 0.f, a = 1.f;
+
+		Color() = default;
+		Color(float r, float g, float b, float a = 1.f)
+			: r{ r }, g{ g }, b{ b }, a{ a }
+		{}
+	};
+
+	// retained draw commands of a frame, for backends that draw whole batches instead of one call per primitive
+	//
+	// colors live in a palette and instances refer to them by index, end_frame groups the circles of the frame by color
+	// with a counting sort, so a backend sets a color once per batch and walks plain arrays
+	// stadiums (the walls) are static: they stay until replaced and carry a version, so a backend can build its
+	// geometry for them once and reuse it every frame
+	// a frame is drawn as the background, the circles batch by batch, the stadiums, then the lines in submission order,
+	// circles of different colors are not drawn in submission order
+	class DrawList
+	{
+	public:
+		struct Batch
+		{
+			std::uint32_t color;
+			// range of the instance arrays
+			size_t begin, end;
+		};
+
+		struct Circle
+		{
+			float x, y, r;
+		};
+
+		struct Line
+		{
+			float x0, y0, x1, y1;
+			float thickness;
+			std::uint32_t color;
+		};
+
+		std::uint32_t add_color(Color c);
+		const Color& color(std::uint32_t index)const;
+
+		Color background{ 1.f, 1.f, 1.f };
+
+		// drops the circles and lines of the last frame, the palette and the stadiums stay
+		void begin_frame();
+		void add_circle(float x, float y, float r, std::uint32_t color);
+		// n circles at once, colors are palette indices
+		void add_circles(const float* x, const float* y, const float* r, const std::uint32_t* colors, size_t n);
+		void add_line(float x0, float y0, float x1, float y1, std::uint32_t color, float thickness = 1.f);
+		// sorts the circles and the stadiums into batches, call it after the last add of the frame
+		void end_frame();
+
+		void clear_stadiums();
+		void add_stadium(float x0, float y0, float x1, float y1, float r, std::uint32_t color);
+		// changes whenever the stadiums change, never 0, and taken from a counter shared by all lists, so two lists
+		// with different stadiums never have the same version and a backend can key its cache on the version alone
+		std::uint64_t stadium_version()const;
+
+		// circle batches and the circles sorted by color, valid after end_frame
+		const std::vector<Batch>& circle_batches()const;
+		const std::vector<Circle>& circles()const;
+
+		// stadium batches, index into the sorted stadium arrays
+		const std::vector<Batch>& stadium_batches()const;
+		// x0, y0, x1, y1, r of every stadium, sorted by color
+		const std::vector<float>& stadiums()const;
+
+		const std::vector<Line>& lines()const;
+
+		size_t circle_count()const;
+	private:
+		// counts the keys into one batch per used color and leaves the first slot of every color in `counts`
+		void sort_by_color(const std::vector<std::uint32_t>& keys, std::vector<Batch>& sorted_batches);
+
+		std::vector<Color> palette{};
+
+		// circles of the frame in submission order, then sorted (as structures, so the sort writes one stream per color)
+		std::vector<Circle> frame_circles{};
+		std::vector<std::uint32_t> colors{};
+		std::vector<Circle> sorted_circles{};
+		std::vector<Batch> batches{};
+		std::vector<std::uint32_t> counts{};
+
+		std::vector<Line> frame_lines{};
+
+		std::vector<float> stadium_data{};
+		std::vector<std::uint32_t> stadium_colors{};
+		std::vector<float> sorted_stadiums{};
+		std::vector<Batch> stadium_batch_list{};
+		// 1 for every list that never had stadiums
+		std::uint64_t version = 1;
+		bool stadiums_sorted = true;
+	};
+}
@@ -1,4 +1,5 @@
 #include "graphics.h"
+#include <cmath>
 
 namespace gfx
 {
@@ -98,4 +99,73 @@ namespace gfx
 		solid_color_brush->SetColor(c);
 		render_target->FillGeometry(quad_geometry.Get(), solid_color_brush.Get());
 	}
+
+	static D2D1::ColorF to_color_f(const Color& c) {
+		return D2D1::ColorF(c.r, c.g, c.b, c.a);
+	}
+
+	void WindowRenderTarget::build_stadiums(const DrawList& list) {
+		stadium_geometry.clear();
+		stadium_color.clear();
+
+		const auto& data = list.stadiums();
+		for (const DrawList::Batch& batch : list.stadium_batches()) {
+			Microsoft::WRL::ComPtr<ID2D1PathGeometry> geometry{};
+			FactorySingleton::get().CreatePathGeometry(geometry.GetAddressOf());
+			Microsoft::WRL::ComPtr<ID2D1GeometrySink> sink{};
+			geometry->Open(sink.GetAddressOf());
+			// overlapping walls of one color must not cancel out
+			sink->SetFillMode(D2D1_FILL_MODE_WINDING);
+
+			for (size_t k = batch.begin; k < batch.end; ++k) {
+				const float* s = data.data() + 5 * k;
+				const float dx = s[2] - s[0], dy = s[3] - s[1];
+				const float length = std::sqrt(dx * dx + dy * dy);
+				if (not (length > 0.f))
+					continue;
+				const float r = s[4];
+				const float nx = -dy / length * r, ny = dx / length * r;
+
+				// both sides and the two half circle caps, every cap goes around the far side of its end
+				sink->BeginFigure(D2D1::Point2F(s[0] + nx, s[1] + ny), D2D1_FIGURE_BEGIN_FILLED);
+				sink->AddLine(D2D1::Point2F(s[2] + nx, s[3] + ny));
+				sink->AddArc(D2D1::ArcSegment(D2D1::Point2F(s[2] - nx, s[3] - ny), D2D1::SizeF(r, r), 0.f,
+					D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE, D2D1_ARC_SIZE_SMALL));
+				sink->AddLine(D2D1::Point2F(s[0] - nx, s[1] - ny));
+				sink->AddArc(D2D1::ArcSegment(D2D1::Point2F(s[0] + nx, s[1] + ny), D2D1::SizeF(r, r), 0.f,
+					D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE, D2D1_ARC_SIZE_SMALL));
+				sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+			}
+			sink->Close();
+
+			stadium_geometry.push_back(geometry);
+			stadium_color.push_back(batch.color);
+		}
+		stadium_version = list.stadium_version();
+	}
+
+	void WindowRenderTarget::draw(const DrawList& list) {
+		render_target->Clear(to_color_f(list.background));
+
+		const auto& circles = list.circles();
+		for (const DrawList::Batch& batch : list.circle_batches()) {
+			solid_color_brush->SetColor(to_color_f(list.color(batch.color)));
+			for (size_t i = batch.begin; i < batch.end; ++i) {
+				const auto [x, y, r] = circles[i];
+				render_target->FillEllipse(D2D1::Ellipse(D2D1::Point2F(x, y), r, r), solid_color_brush.Get());
+			}
+		}
+
+		if (stadium_version != list.stadium_version())
+			build_stadiums(list);
+		for (size_t k = 0; k < stadium_geometry.size(); ++k) {
+			solid_color_brush->SetColor(to_color_f(list.color(stadium_color[k])));
+			render_target->FillGeometry(stadium_geometry[k].Get(), solid_color_brush.Get());
+		}
+
+		for (const DrawList::Line& line : list.lines()) {
+			solid_color_brush->SetColor(to_color_f(list.color(line.color)));
+			render_target->DrawLine(D2D1::Point2F(line.x0, line.y0), D2D1::Point2F(line.x1, line.y1), solid_color_brush.Get(), line.thickness);
+		}
+	}
 }
\ No newline at end of file
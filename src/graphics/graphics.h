@@ -1,9 +1,12 @@
 #pragma once
+#include "draw_list.h"
 #include <wrl.h>
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 #include <Windows.h>
 #include <d2d1.h>
+#include <cstdint>
+#include <vector>
 #pragma comment(lib, "d2d1")
 
 namespace gfx
@@ -43,8 +46,19 @@ namespace gfx
 				float x3, float y3,
 				float x4, float y4,
 				D2D1::ColorF c);
+
+			// draws a whole draw list between beg_draw and end_draw, the background replaces whatever was drawn before it,
+			// the brush color is set once per batch
+			// and the stadiums are one path geometry per color, built once per stadium version
+			void draw(const DrawList& list);
 		private:
+			void build_stadiums(const DrawList& list);
+
 			Microsoft::WRL::ComPtr<ID2D1HwndRenderTarget>render_target;
 			Microsoft::WRL::ComPtr<ID2D1SolidColorBrush>solid_color_brush;
+
+			std::uint64_t stadium_version = 0;
+			std::vector<Microsoft::WRL::ComPtr<ID2D1PathGeometry>> stadium_geometry;
+			std::vector<std::uint32_t> stadium_color;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,446 @@
+#include "software.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFX_SSE2
+#include <emmintrin.h>
+#endif
+
+// the framebuffer words are written out as R G B A bytes
+static_assert(std::endian::native == std::endian::little, "the software renderer writes little endian pixels");
+
+namespace gfx
+{
+	namespace
+	{
+		std::uint8_t to_byte(float v) {
+			return std::uint8_t(std::clamp(v, 0.f, 1.f) * 255.f + 0.5f);
+		}
+
+		// R G B A in memory order, with an opaque alpha byte
+		std::uint32_t pack(Color c) {
+			return std::uint32_t(to_byte(c.r)) | std::uint32_t(to_byte(c.g)) << 8 | std::uint32_t(to_byte(c.b)) << 16 | 0xff000000u;
+		}
+
+		void fill_span(std::uint32_t* out, size_t n, std::uint32_t color) {
+			size_t i = 0;
+#if defined(GFX_SSE2)
+			const __m128i c4 = _mm_set1_epi32(int(color));
+			for (; i + 4 <= n; i += 4)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), c4);
+#endif
+			for (; i < n; ++i)
+				out[i] = color;
+		}
+
+		// out = color * a + out * (1 - a) per channel, with v / 255 rounded as (v + 128 + (v + 128 >> 8)) >> 8
+		std::uint32_t blend(std::uint32_t dst, std::uint32_t color, std::uint32_t a) {
+			std::uint32_t result = 0;
+			for (unsigned shift = 0; shift < 32; shift += 8) {
+				const std::uint32_t v = ((color >> shift) & 0xff) * a + ((dst >> shift) & 0xff) * (255 - a) + 128;
+				result |= ((v + (v >> 8)) >> 8) << shift;
+			}
+			return result;
+		}
+
+		void blend_span(std::uint32_t* out, size_t n, std::uint32_t color, std::uint8_t alpha) {
+			size_t i = 0;
+#if defined(GFX_SSE2)
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32(int(color)), zero);
+			const __m128i a = _mm_set1_epi16(short(alpha));
+			const __m128i inv_a = _mm_set1_epi16(short(255 - alpha));
+			const __m128i half = _mm_set1_epi16(128);
+			const __m128i src_a = _mm_add_epi16(_mm_mullo_epi16(src, a), half);
+			const auto mix = [&](__m128i dst) {
+				const __m128i v = _mm_add_epi16(_mm_mullo_epi16(dst, inv_a), src_a);
+				return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+			};
+			for (; i + 4 <= n; i += 4) {
+				const __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + i));
+				const __m128i lo = mix(_mm_unpacklo_epi8(dst, zero));
+				const __m128i hi = mix(_mm_unpackhi_epi8(dst, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for (; i < n; ++i)
+				out[i] = blend(out[i], color, alpha);
+		}
+
+		// the pixels whose centers lie in [lo, hi], clipped to [x_min, x_max)
+		bool span(float lo, float hi, long x_min, long x_max, long& x0, long& x1) {
+			x0 = std::max(x_min, long(std::ceil(lo - 0.5f)));
+			x1 = std::min(x_max, long(std::floor(hi - 0.5f)) + 1);
+			return x0 < x1;
+		}
+	}
+
+	SoftwareRenderTarget::SoftwareRenderTarget(size_t width, size_t height)
+		: width{ width }, height{ height },
+		tiles_x{ (width + tile_size - 1) / tile_size }, tiles_y{ (height + tile_size - 1) / tile_size },
+		framebuffer(width * height, 0)
+	{
+		if (width == 0 or height == 0)
+			throw std::domain_error("render target dimensions have to be positive");
+	}
+
+	size_t SoftwareRenderTarget::get_width()const {
+		return width;
+	}
+
+	size_t SoftwareRenderTarget::get_height()const {
+		return height;
+	}
+
+	const std::uint32_t* SoftwareRenderTarget::pixels()const {
+		return framebuffer.data();
+	}
+
+	void SoftwareRenderTarget::beg_draw() {
+		cleared = false;
+		primitives.clear();
+	}
+
+	void SoftwareRenderTarget::clear(Color c) {
+		cleared = true;
+		clear_color = pack(c);
+		primitives.clear();
+	}
+
+	void SoftwareRenderTarget::add(const Primitive& primitive) {
+		// nothing outside the framebuffer is ever binned
+		if (primitive.max_x < 0.f or primitive.max_y < 0.f or primitive.min_x >= float(width) or primitive.min_y >= float(height))
+			return;
+		primitives.push_back(primitive);
+	}
+
+	SoftwareRenderTarget::Primitive SoftwareRenderTarget::circle(float x, float y, float r, std::uint32_t color, std::uint8_t alpha) {
+		return Primitive{ x - r, y - r, x + r, y + r, { x, y, r }, color, alpha, Shape::circle };
+	}
+
+	void SoftwareRenderTarget::fill_circle(float x, float y, float r, Color c) {
+		if (not (r > 0.f) or not std::isfinite(x + y + r) or c.a <= 0.f)
+			return;
+		add(circle(x, y, r, pack(c), to_byte(c.a)));
+	}
+
+	void SoftwareRenderTarget::fill_quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, Color c) {
+		// twice the signed area, the rasterizer expects the corners in the order that makes it positive
+		const float area = (x1 * y2 - x2 * y1) + (x2 * y3 - x3 * y2) + (x3 * y4 - x4 * y3) + (x4 * y1 - x1 * y4);
+		if (area == 0.f or not std::isfinite(area) or c.a <= 0.f)
+			return;
+
+		Primitive primitive{ std::min({ x1, x2, x3, x4 }), std::min({ y1, y2, y3, y4 }), std::max({ x1, x2, x3, x4 }), std::max({ y1, y2, y3, y4 }),
+			{ x1, y1, x2, y2, x3, y3, x4, y4 }, pack(c), to_byte(c.a), Shape::quad };
+		if (area < 0.f) {
+			std::swap(primitive.p[0], primitive.p[6]);
+			std::swap(primitive.p[1], primitive.p[7]);
+			std::swap(primitive.p[2], primitive.p[4]);
+			std::swap(primitive.p[3], primitive.p[5]);
+		}
+		add(primitive);
+	}
+
+	void SoftwareRenderTarget::draw_line(float x0, float y0, float x1, float y1, Color c, float t) {
+		const float dx = x1 - x0, dy = y1 - y0;
+		const float length = std::sqrt(dx * dx + dy * dy);
+		if (not (length > 0.f))
+			return;
+
+		const float nx = -dy / length * t * 0.5f, ny = dx / length * t * 0.5f;
+		fill_quad(x0 + nx, y0 + ny, x1 + nx, y1 + ny, x1 - nx, y1 - ny, x0 - nx, y0 - ny, c);
+	}
+
+	void SoftwareRenderTarget::draw(const DrawList& list) {
+		clear(list.background);
+
+		const auto& circles = list.circles();
+		primitives.reserve(primitives.size() + list.circle_count());
+		const float w = float(width), h = float(height);
+		for (const DrawList::Batch& batch : list.circle_batches()) {
+			const Color& c = list.color(batch.color);
+			if (c.a <= 0.f)
+				continue;
+			const std::uint32_t color = pack(c);
+			const std::uint8_t alpha = to_byte(c.a);
+			for (size_t i = batch.begin; i < batch.end; ++i) {
+				const auto [x, y, r] = circles[i];
+				// the negated test also drops NaN
+				if (not (r > 0.f and x + r >= 0.f and y + r >= 0.f and x - r < w and y - r < h) or not std::isfinite(x + y + r))
+					continue;
+				primitives.push_back(circle(x, y, r, color, alpha));
+			}
+		}
+
+		if (stadium_version != list.stadium_version()) {
+			// built through the immediate calls, then moved out of the frame into the cache
+			const size_t frame_size = primitives.size();
+			const auto& data = list.stadiums();
+			for (const DrawList::Batch& batch : list.stadium_batches()) {
+				const Color& c = list.color(batch.color);
+				for (size_t k = batch.begin; k < batch.end; ++k) {
+					const float* s = data.data() + 5 * k;
+					draw_line(s[0], s[1], s[2], s[3], c, 2.f * s[4]);
+					fill_circle(s[0], s[1], s[4], c);
+					fill_circle(s[2], s[3], s[4], c);
+				}
+			}
+			stadium_primitives.assign(primitives.begin() + std::ptrdiff_t(frame_size), primitives.end());
+			primitives.resize(frame_size);
+			stadium_version = list.stadium_version();
+		}
+		primitives.insert(primitives.end(), stadium_primitives.begin(), stadium_primitives.end());
+
+		for (const DrawList::Line& line : list.lines())
+			draw_line(line.x0, line.y0, line.x1, line.y1, list.color(line.color), line.thickness);
+	}
+
+	void SoftwareRenderTarget::tile_range(const Primitive& primitive, size_t& tx0, size_t& ty0, size_t& tx1, size_t& ty1)const {
+		const auto tile = [](float v, size_t tiles) { return size_t(std::clamp(v, 0.f, float(tiles * tile_size - 1))) / tile_size; };
+		tx0 = tile(primitive.min_x, tiles_x);
+		ty0 = tile(primitive.min_y, tiles_y);
+		tx1 = tile(primitive.max_x, tiles_x) + 1;
+		ty1 = tile(primitive.max_y, tiles_y) + 1;
+	}
+
+	void SoftwareRenderTarget::count_chunk(size_t chunk) {
+		std::uint32_t* const counts = chunk_tile.data() + chunk * tiles_x * tiles_y;
+		const size_t end = std::min(primitives.size(), (chunk + 1) * bin_chunk);
+		for (size_t k = chunk * bin_chunk; k < end; ++k) {
+			size_t tx0, ty0, tx1, ty1;
+			tile_range(primitives[k], tx0, ty0, tx1, ty1);
+			for (size_t ty = ty0; ty < ty1; ++ty)
+				for (size_t tx = tx0; tx < tx1; ++tx)
+					++counts[ty * tiles_x + tx];
+		}
+	}
+
+	void SoftwareRenderTarget::prefix_sum() {
+		// tile major, so the references of a tile are its primitives in submission order
+		const size_t tiles = tiles_x * tiles_y;
+		const size_t chunks = chunk_tile.size() / tiles;
+		std::uint32_t next = 0;
+		for (size_t t = 0; t < tiles; ++t) {
+			tile_start[t] = next;
+			for (size_t c = 0; c < chunks; ++c) {
+				const std::uint32_t count = chunk_tile[c * tiles + t];
+				chunk_tile[c * tiles + t] = next;
+				next += count;
+			}
+		}
+		tile_start[tiles] = next;
+		binned.resize(next);
+	}
+
+	void SoftwareRenderTarget::scatter_chunk(size_t chunk) {
+		std::uint32_t* const slots = chunk_tile.data() + chunk * tiles_x * tiles_y;
+		const size_t end = std::min(primitives.size(), (chunk + 1) * bin_chunk);
+		for (size_t k = chunk * bin_chunk; k < end; ++k) {
+			size_t tx0, ty0, tx1, ty1;
+			tile_range(primitives[k], tx0, ty0, tx1, ty1);
+			for (size_t ty = ty0; ty < ty1; ++ty)
+				for (size_t tx = tx0; tx < tx1; ++tx)
+					binned[slots[ty * tiles_x + tx]++] = primitives[k];
+		}
+	}
+
+	void SoftwareRenderTarget::draw_tile(size_t tile) {
+		const long x_min = long(tile % tiles_x * tile_size), y_min = long(tile / tiles_x * tile_size);
+		const long x_max = std::min(long(width), x_min + long(tile_size)), y_max = std::min(long(height), y_min + long(tile_size));
+		std::uint32_t* const rows = framebuffer.data();
+
+		if (cleared) {
+			for (long y = y_min; y < y_max; ++y)
+				fill_span(rows + size_t(y) * width + size_t(x_min), size_t(x_max - x_min), clear_color);
+		}
+
+		for (std::uint32_t r = tile_start[tile]; r < tile_start[tile + 1]; ++r) {
+			const Primitive& primitive = binned[r];
+			const auto fill = [&](long y, long x0, long x1) {
+				std::uint32_t* const out = rows + size_t(y) * width + size_t(x0);
+				if (primitive.alpha == 255)
+					fill_span(out, size_t(x1 - x0), primitive.color);
+				else
+					blend_span(out, size_t(x1 - x0), primitive.color, primitive.alpha);
+			};
+
+			const long row_beg = std::max(y_min, long(std::ceil(primitive.min_y - 0.5f)));
+			const long row_end = std::min(y_max, long(std::floor(primitive.max_y - 0.5f)) + 1);
+			if (primitive.shape == Shape::circle) {
+				const float cx = primitive.p[0], cy = primitive.p[1], r2 = primitive.p[2] * primitive.p[2];
+				for (long y = row_beg; y < row_end; ++y) {
+					const float dy = float(y) + 0.5f - cy;
+					const float h2 = r2 - dy * dy;
+					long x0, x1;
+					if (h2 >= 0.f and span(cx - std::sqrt(h2), cx + std::sqrt(h2), x_min, x_max, x0, x1))
+						fill(y, x0, x1);
+				}
+			}
+			else {
+				// every edge a -> b keeps the pixel centers p with cross(b - a, p - a) >= 0, which on a row bounds x from one side
+				for (long y = row_beg; y < row_end; ++y) {
+					const float py = float(y) + 0.5f;
+					float lo = -std::numeric_limits<float>::infinity(), hi = std::numeric_limits<float>::infinity();
+					for (size_t e = 0; e < 4; ++e) {
+						const float ax = primitive.p[2 * e], ay = primitive.p[2 * e + 1];
+						const float bx = primitive.p[(2 * e + 2) % 8], by = primitive.p[(2 * e + 3) % 8];
+						const float a = -(by - ay), b = (bx - ax) * (py - ay) + (by - ay) * ax;
+						if (a > 0.f)
+							lo = std::max(lo, -b / a);
+						else if (a < 0.f)
+							hi = std::min(hi, -b / a);
+						else if (b < 0.f)
+							hi = -std::numeric_limits<float>::infinity();
+					}
+					long x0, x1;
+					if (lo <= hi and span(lo, hi, x_min, x_max, x0, x1))
+						fill(y, x0, x1);
+				}
+			}
+		}
+	}
+
+	void SoftwareRenderTarget::end_draw() {
+		const size_t tiles = tiles_x * tiles_y;
+		const size_t chunks = (primitives.size() + bin_chunk - 1) / bin_chunk;
+		chunk_tile.assign(chunks * tiles, 0);
+		tile_start.resize(tiles + 1);
+
+		for (size_t c = 0; c < chunks; ++c)
+			count_chunk(c);
+		prefix_sum();
+		for (size_t c = 0; c < chunks; ++c)
+			scatter_chunk(c);
+		for (size_t t = 0; t < tiles; ++t)
+			draw_tile(t);
+	}
+
+	void SoftwareRenderTarget::end_draw(phs::ThreadPool& pool) {
+		const size_t tiles = tiles_x * tiles_y;
+		const size_t chunks = (primitives.size() + bin_chunk - 1) / bin_chunk;
+		chunk_tile.assign(chunks * tiles, 0);
+		tile_start.resize(tiles + 1);
+
+		pool.parallel_for(chunks, 1, [this](size_t begin, size_t end) {
+			for (size_t c = begin; c < end; ++c)
+				count_chunk(c);
+		});
+		prefix_sum();
+		pool.parallel_for(chunks, 1, [this](size_t begin, size_t end) {
+			for (size_t c = begin; c < end; ++c)
+				scatter_chunk(c);
+		});
+		pool.parallel_for(tiles, 4, [this](size_t begin, size_t end) {
+			for (size_t t = begin; t < end; ++t)
+				draw_tile(t);
+		});
+	}
+
+	void SoftwareRenderTarget::save_ppm(const std::filesystem::path& path)const {
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		if (not file)
+			throw std::runtime_error("cannot create " + path.string());
+		file << "P6\n" << width << ' ' << height << "\n255\n";
+
+		std::vector<char> row(width * 3);
+		for (size_t y = 0; y < height; ++y) {
+			for (size_t x = 0; x < width; ++x) {
+				const std::uint32_t p = framebuffer[y * width + x];
+				row[3 * x] = char(p & 0xff);
+				row[3 * x + 1] = char(p >> 8 & 0xff);
+				row[3 * x + 2] = char(p >> 16 & 0xff);
+			}
+			file.write(row.data(), std::streamsize(row.size()));
+		}
+		if (not file)
+			throw std::runtime_error("cannot write " + path.string());
+	}
+
+	void SoftwareRenderTarget::save_png(const std::filesystem::path& path)const {
+		static const std::array<std::uint32_t, 256> crc_table = [] {
+			std::array<std::uint32_t, 256> table{};
+			for (std::uint32_t n = 0; n < 256; ++n) {
+				std::uint32_t c = n;
+				for (int k = 0; k < 8; ++k)
+					c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				table[n] = c;
+			}
+			return table;
+		}();
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		if (not file)
+			throw std::runtime_error("cannot create " + path.string());
+
+		const auto put32 = [](std::vector<std::uint8_t>& out, std::uint32_t v) {
+			out.insert(out.end(), { std::uint8_t(v >> 24), std::uint8_t(v >> 16), std::uint8_t(v >> 8), std::uint8_t(v) });
+		};
+		// length, type, data and the crc of type and data
+		const auto chunk = [&](const char* type, const std::vector<std::uint8_t>& data) {
+			std::vector<std::uint8_t> head{};
+			put32(head, std::uint32_t(data.size()));
+			head.insert(head.end(), type, type + 4);
+			std::uint32_t crc = 0xffffffffu;
+			for (size_t i = 4; i < 8; ++i)
+				crc = crc_table[(crc ^ head[i]) & 0xff] ^ (crc >> 8);
+			for (std::uint8_t byte : data)
+				crc = crc_table[(crc ^ byte) & 0xff] ^ (crc >> 8);
+			std::vector<std::uint8_t> tail{};
+			put32(tail, crc ^ 0xffffffffu);
+			file.write(reinterpret_cast<const char*>(head.data()), std::streamsize(head.size()));
+			file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+			file.write(reinterpret_cast<const char*>(tail.data()), std::streamsize(tail.size()));
+		};
+
+		file.write("\x89PNG\r\n\x1a\n", 8);
+
+		std::vector<std::uint8_t> header{};
+		put32(header, std::uint32_t(width));
+		put32(header, std::uint32_t(height));
+		// 8 bit RGBA, deflate, adaptive filtering, no interlace
+		header.insert(header.end(), { 8, 6, 0, 0, 0 });
+		chunk("IHDR", header);
+
+		// every row is a filter byte (none) and the pixels, split into stored deflate blocks of at most 65535 bytes
+		const size_t row_bytes = 1 + 4 * width;
+		const size_t raw_size = row_bytes * height;
+		std::vector<std::uint8_t> raw(raw_size);
+		for (size_t y = 0; y < height; ++y) {
+			raw[y * row_bytes] = 0;
+			std::memcpy(raw.data() + y * row_bytes + 1, framebuffer.data() + y * width, 4 * width);
+		}
+
+		std::vector<std::uint8_t> data{ 0x78, 0x01 };
+		data.reserve(raw_size + raw_size / 65535 * 5 + 16);
+		for (size_t offset = 0; offset < raw_size; offset += 65535) {
+			const size_t n = std::min<size_t>(65535, raw_size - offset);
+			const bool last = offset + n == raw_size;
+			data.insert(data.end(), { std::uint8_t(last ? 1 : 0), std::uint8_t(n), std::uint8_t(n >> 8), std::uint8_t(~n), std::uint8_t(~n >> 8) });
+			data.insert(data.end(), raw.begin() + std::ptrdiff_t(offset), raw.begin() + std::ptrdiff_t(offset + n));
+		}
+		std::uint32_t s1 = 1, s2 = 0;
+		for (std::uint8_t byte : raw) {
+			s1 = (s1 + byte) % 65521;
+			s2 = (s2 + s1) % 65521;
+		}
+		put32(data, s2 << 16 | s1);
+		chunk("IDAT", data);
+		chunk("IEND", {});
+
+		if (not file)
+			throw std::runtime_error("cannot write " + path.string());
+	}
+
+	void SoftwareRenderTarget::write_raw(std::FILE* out)const {
+		if (std::fwrite(framebuffer.data(), sizeof(std::uint32_t), framebuffer.size(), out) != framebuffer.size())
+			throw std::runtime_error("cannot write the frame");
+	}
+}
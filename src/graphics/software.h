@@ -0,0 +1,103 @@
+#pragma once
+#include "draw_list.h"
+#include "../physics/thread_pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace gfx
+{
+	// portable CPU render target with the drawing calls of WindowRenderTarget, for machines without Direct2D
+	//
+	// the calls between beg_draw and end_draw only record primitives, end_draw rasterizes them into an RGBA8 framebuffer:
+	// every primitive is binned into the 64 x 64 pixel tiles its bounds touch (a counting sort, chunks of primitives
+	// are counted and scattered in parallel), then every tile fills the spans of its primitives in submission order,
+	// tiles in parallel since no two share a pixel
+	// pixels are covered when their center is inside the shape, without anti aliasing
+	class SoftwareRenderTarget
+	{
+	public:
+		static constexpr size_t tile_size = 64;
+
+		SoftwareRenderTarget(size_t width, size_t height);
+
+		size_t get_width()const;
+		size_t get_height()const;
+
+		void beg_draw();
+		void end_draw();
+		// the same with the binning and the tiles split across the pool
+		void end_draw(phs::ThreadPool& pool);
+
+		// drops everything drawn before it in this frame
+		void clear(Color c);
+		void fill_circle(float x, float y, float r, Color c);
+		void draw_line(float x0, float y0, float x1, float y1, Color c, float t = 1.f);
+		// a convex quad, in either winding
+		void fill_quad(
+			float x1, float y1,
+			float x2, float y2,
+			float x3, float y3,
+			float x4, float y4,
+			Color c);
+
+		// draws a whole draw list between beg_draw and end_draw, the background replaces whatever was drawn before it
+		// the primitives of the stadiums are built once per stadium version and copied into every frame
+		void draw(const DrawList& list);
+
+		// row major, R G B A bytes per pixel, valid after end_draw
+		const std::uint32_t* pixels()const;
+
+		// throw std::runtime_error when the file cannot be written
+		void save_ppm(const std::filesystem::path& path)const;
+		// uncompressed (stored deflate blocks), so no zlib is needed
+		void save_png(const std::filesystem::path& path)const;
+		// the raw RGBA frame, e.g. to a pipe into ffmpeg -f rawvideo -pix_fmt rgba
+		void write_raw(std::FILE* out)const;
+	private:
+		enum class Shape : std::uint8_t { circle, quad };
+
+		struct Primitive
+		{
+			float min_x, min_y, max_x, max_y;
+			// circle: x, y, r, quad: the four corners, ordered so their shoelace area is positive
+			float p[8];
+			// the color with an opaque alpha byte, alpha is the blend factor
+			std::uint32_t color;
+			std::uint8_t alpha;
+			Shape shape;
+		};
+
+		static constexpr size_t bin_chunk = 16384;
+
+		void add(const Primitive& primitive);
+		static Primitive circle(float x, float y, float r, std::uint32_t color, std::uint8_t alpha);
+		void tile_range(const Primitive& primitive, size_t& tx0, size_t& ty0, size_t& tx1, size_t& ty1)const;
+		void count_chunk(size_t chunk);
+		void scatter_chunk(size_t chunk);
+		void prefix_sum();
+		void draw_tile(size_t tile);
+
+		size_t width;
+		size_t height;
+		size_t tiles_x;
+		size_t tiles_y;
+		std::vector<std::uint32_t> framebuffer;
+
+		bool cleared = false;
+		std::uint32_t clear_color = 0;
+		std::vector<Primitive> primitives{};
+
+		// the stadiums of the last draw list as primitives
+		std::uint64_t stadium_version = 0;
+		std::vector<Primitive> stadium_primitives{};
+
+		// per chunk and tile, first the number of primitives and then the next free slot in `binned`
+		std::vector<std::uint32_t> chunk_tile{};
+		std::vector<std::uint32_t> tile_start{};
+		// copies of the primitives grouped by tile, so a tile reads its primitives in one sequential pass
+		std::vector<Primitive> binned{};
+	};
+}
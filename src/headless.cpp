@@ -0,0 +1,86 @@
+// runs the demo scene without a window, as fast as the CPU allows
+// usage: headless [balls] [steps] [dt] [seed] [threads] [continuous] [solver iterations] [trajectory file] [profile file]
+//        [reorder interval]
+// threads > 0 uses the parallel step, which gives the same result for any thread count
+// continuous = 1 turns on the time of impact mode, which keeps fast balls inside the box at large dt
+// solver iterations > 0 resolves the contacts with the sequential impulse solver
+// a trajectory file records every step, to be read back with phs::TrajectoryReader, - records none
+// a profile file gets the time of every stage of every step, as a Chrome trace when it ends in .json, else as CSV,
+// and a summary of the stages is printed, - profiles nothing
+// reorder interval > 0 sorts the balls along a Hilbert curve every that many steps
+#include "physics/profiler.h"
+#include "physics/trajectory.h"
+#include "physics/world.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+int main(int argc, char** argv)
+{
+	const size_t ball_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000;
+	const size_t steps = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 600;
+	const phs::Float dt = phs::Float(argc > 3 ? std::strtod(argv[3], nullptr) : 1.0 / 60.0);
+	const unsigned seed = argc > 4 ? unsigned(std::strtoul(argv[4], nullptr, 10)) : 42u;
+	const size_t threads = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 0;
+	const bool continuous = argc > 6 and std::strtoul(argv[6], nullptr, 10) != 0;
+	const size_t solver_iterations = argc > 7 ? std::strtoull(argv[7], nullptr, 10) : 0;
+	const char* trajectory = argc > 8 and std::string(argv[8]) != "-" ? argv[8] : nullptr;
+	const std::string profile = argc > 9 and std::string(argv[9]) != "-" ? argv[9] : "";
+	const size_t reorder_interval = argc > 10 ? std::strtoull(argv[10], nullptr, 10) : 0;
+
+	// keep the ball density of the 20 ball demo scene
+	const phs::Float scale = phs::Float(std::sqrt(double(ball_count) / 20.0));
+
+	phs::World world{};
+	world.continuous = continuous;
+	world.use_solver = solver_iterations > 0;
+	world.solver.velocity_iterations = solver_iterations;
+	world.reorder_interval = reorder_interval;
+	phs::add_box_scene(world, phs::Point{ phs::Float(0), phs::Float(0) }, phs::Float(300) * scale, phs::Float(250) * scale, ball_count, seed);
+
+	std::optional<phs::ThreadPool> pool{};
+	if (threads > 0)
+		pool.emplace(threads);
+
+	phs::Profiler profiler{};
+	if (not profile.empty())
+		world.profiler = &profiler;
+
+	std::optional<phs::TrajectoryRecorder> recorder{};
+	if (trajectory)
+		recorder.emplace(trajectory);
+
+	const auto beg = std::chrono::steady_clock::now();
+	for (size_t s = 0; s < steps; ++s) {
+		if (pool)
+			world.step(dt, *pool);
+		else
+			world.step(dt);
+		if (recorder)
+			recorder->record(world);
+		if (world.profiler)
+			profiler.end_frame();
+	}
+	if (recorder)
+		recorder->close();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+
+	double energy = 0.0;
+	for (size_t i = 0; i < world.balls.size(); ++i)
+		energy += 0.5 / double(world.balls.inv_mass[i]) * double(phs::length2(world.balls.velocity(i)));
+
+	std::printf("balls: %zu steps: %zu time: %.3f s (%.1f steps/s)\n", ball_count, steps, seconds, double(steps) / seconds);
+	std::printf("contacts: %zu ball-ball, %zu ball-wall, kinetic energy: %.9g\n",
+		world.ball_ball_cols.size(), world.ball_wall_cols.size(), energy);
+
+	if (world.profiler) {
+		profiler.write_summary(stdout);
+		if (profile.size() > 5 and profile.compare(profile.size() - 5, 5, ".json") == 0)
+			profiler.write_chrome_trace(profile);
+		else
+			profiler.write_csv(profile);
+	}
+}
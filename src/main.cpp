@@ -2,8 +2,16 @@
 #include "graphics/graphics.h"
 #include "physics/geometry2d.h"
 #include "physics/physics.h"
+#include "physics/profiler.h"
+#include "physics/replay.h"
+#include "physics/simulation_thread.h"
+#include "physics/timestep.h"
+#include "physics/world.h"
+#include <algorithm>
+#include <optional>
 #include <random>
 #include <ranges>
+#include <string_view>
 
 class DemoWindow : public wnd::BaseWindow
 {
@@ -11,16 +19,32 @@ class DemoWindow : public wnd::BaseWindow
 		gfx::WindowRenderTarget target;
 		const gm2d::Point screen_middle;
 
-		std::vector<phs::Ball> balls{};
-		std::vector<D2D1::ColorF> colors;
-		std::vector<phs::Wall> walls{};
-
+		phs::World world{};
+		// 120 physics steps per second whatever the frame rate, at most 8 of them per frame
+		phs::FixedTimestep timestep{ 120.0, 8 };
+		// every step and impulse goes through the recorder, the log is saved on exit for the replay tool
+		std::optional<phs::ReplayRecorder> recorder{};
+		// with --threaded the world steps on its own thread at the same rate and the frames draw its latest snapshot,
+		// the world and the recorder then belong to that thread and impulses are posted to it
+		std::optional<phs::SimulationThread> simulation{};
+		phs::WorldSnapshot lockstep{};
+		// stage timings, written on exit as Chrome traces (chrome://tracing), a frame of `profiler` is a rendered frame
+		// with its steps, the threaded mode times the steps on the simulation thread into simulation_profiler instead
+		phs::Profiler profiler{};
+		phs::Profiler simulation_profiler{};
+		// the frame is submitted as a draw list, every ball keeps a random color of its own in the palette
+		gfx::DrawList draw_list{};
+		std::vector<std::uint32_t> colors;
+		std::uint32_t line_color = 0;
+		std::vector<float> center_x, center_y, radii;
 
 		gm2d::Point impulse_end{};
-		phs::Ball* f_ball = nullptr;
+		// snapshots keep the balls in order of their ids, so the picked ball and `colors` stay with their balls
+		// when the world reorders, only the impulse needs the index of the ball
+		std::optional<size_t> f_ball{};
 		
 
-		DemoWindow(int width, int height)
+		DemoWindow(int width, int height, bool threaded)
 			:
 			BaseWindow(width, height, L"Demo"),
 			target(get_window_handle()),
@@ -30,82 +54,93 @@ class DemoWindow : public wnd::BaseWindow
 			const float h = 250.f;
 
 			std::random_device rd;
+			phs::ReplayScene scene{};
+			scene.seed = rd();
+			scene.middle = screen_middle;
+			scene.half_width = w;
+			scene.half_height = h;
+			scene.ball_count = 20;
+			// the drag impulse easily throws a ball further than a wall is thick in one frame
+			scene.continuous = true;
+			recorder.emplace(world, scene);
+
 			std::mt19937 gen(rd());
 			std::uniform_real_distribution<float> dis(0.f, 1.f);
-			for (int n = 0; n < 20; ++n)
-			{
-				const float radius = 5.f + dis(gen) * 25.f;
-				const float x0 = screen_middle.x + w - 2.f * dis(gen) * 0.9f * w;
-				const float y0 = screen_middle.y + h - 2.f * dis(gen) * 0.9f * h;
-				balls.emplace_back(phs::Point{ x0, y0 }, radius, radius);
-
-				colors.emplace_back(dis(gen), dis(gen), dis(gen));
+			for (size_t n = 0; n < world.balls.size(); ++n)
+				colors.push_back(draw_list.add_color(gfx::Color(dis(gen), dis(gen), dis(gen))));
+
+			draw_list.background = gfx::Color(0.94f, 0.97f, 1.f);
+			line_color = draw_list.add_color(gfx::Color(1.f, 0.f, 0.f));
+			const std::uint32_t wall_color = draw_list.add_color(gfx::Color(0.f, 0.f, 0.f));
+			for (const auto& wall : world.walls)
+				draw_list.add_stadium(wall.beg.x, wall.beg.y, wall.end.x, wall.end.y, wall.radius, wall_color);
+
+			if (threaded) {
+				simulation_profiler.thread_id = 2;
+				world.profiler = &simulation_profiler;
+				simulation.emplace(world, timestep.get_rate(), true, [this](phs::World&, phs::Float dt) {
+					recorder->step(dt);
+					simulation_profiler.end_frame();
+				});
+			}
+			else {
+				world.profiler = &profiler;
 			}
-			
-			walls.emplace_back(screen_middle + phs::Vector(-0.1f * w, 10.f), screen_middle + phs::Vector(0.1f * w, 50.f), 5.f);
-
-
-			walls.emplace_back(screen_middle + phs::Vector(-w, h), screen_middle + phs::Vector(w, h), 10.f);
-
-			walls.emplace_back(screen_middle + phs::Vector(-w, -h), screen_middle + phs::Vector(w, -h), 10.f);
-
-			walls.emplace_back(screen_middle + phs::Vector(-w, h), screen_middle + phs::Vector(-w, -h), 10.f);
-
-			walls.emplace_back(screen_middle + phs::Vector(w, h), screen_middle + phs::Vector(w, -h), 10.f);
-
 			run();
+			if (simulation)
+				simulation->stop();
+			phs::save_replay(recorder->log(), "last_run.phsr");
+			profiler.write_chrome_trace("last_run_profile.json");
+			if (simulation)
+				simulation_profiler.write_chrome_trace("last_run_simulation_profile.json");
+		}
+
+		// the balls as the frame draws them
+		const phs::WorldSnapshot& state() {
+			return simulation ? simulation->latest() : lockstep;
 		}
 
 
 		void on_update(float et)override {
 
-			for (auto& ball : balls) {
-				ball.acceleration += {0.f, 100.f};
-				ball.dt(et);
+			if (not simulation) {
+				timestep.advance(world, et, [this](phs::World&, phs::Float dt) { recorder->step(dt); });
+				lockstep.capture(world, 0, 0.0);
+				for (size_t i = 0; i < lockstep.size(); ++i) {
+					const auto center = timestep.interpolated_center(world, i);
+					lockstep.x[world.ball_id(i)] = center.x;
+					lockstep.y[world.ball_id(i)] = center.y;
+				}
 			}
 
-			std::vector<std::pair<size_t, size_t>>ball_ball_cols{};
-			std::vector<std::pair<size_t, size_t>>ball_wall_cols{};
-
-			
-			for (size_t i = 0; i < balls.size(); ++i)
-				for (size_t j = i + 1; j < balls.size(); ++j)
-					if (phs::resolve_static_collision(balls[i], balls[j]))
-						ball_ball_cols.emplace_back(i, j);
-				
-					
-
-			for (size_t i = 0; i < balls.size(); ++i)
-				for (size_t j = 0; j < walls.size(); ++j)
-					if (phs::resolve_static_collision(walls[j], balls[i]))
-						ball_wall_cols.emplace_back(i, j);
-			
-			for (auto [ball_i, ball_j] : ball_ball_cols)
-				phs::resolve_dynamic_collision(balls[ball_i], balls[ball_j]);
-
-			for (auto [ball_i, wall_j] : ball_wall_cols)
-				phs::resolve_dynamic_collision(walls[wall_j], balls[ball_i]);
-
-			target.beg_draw();
-			target.clear(D2D1::ColorF::AliceBlue);
-			
-
-			for (const auto& [i, ball] : std::views::enumerate(balls))
-				draw(ball, colors[i]);
-
-			for (const auto& wall : walls)
-				draw(wall);
-
+			const phs::WorldSnapshot& balls = state();
+			const size_t n = std::min(balls.size(), colors.size());
+			center_x.resize(n);
+			center_y.resize(n);
+			radii.resize(n);
+			for (size_t i = 0; i < n; ++i) {
+				center_x[i] = balls.x[i];
+				center_y[i] = balls.y[i];
+				radii[i] = balls.radius[i];
+			}
 
-			if (f_ball) {
+			draw_list.begin_frame();
+			draw_list.add_circles(center_x.data(), center_y.data(), radii.data(), colors.data(), n);
+			if (f_ball and *f_ball < n) {
 				POINT mp;
 				GetCursorPos(&mp);
 				ScreenToClient(get_window_handle(), &mp);
-
-				target.draw_line((float)mp.x, (float)mp.y, f_ball->center.x, f_ball->center.y, Color::Red, 3.f);
+				draw_list.add_line((float)mp.x, (float)mp.y, center_x[*f_ball], center_y[*f_ball], line_color, 3.f);
 			}
+			draw_list.end_frame();
 
-			target.end_draw();
+			{
+				PHS_PROFILE_SCOPE(&profiler, phs::Stage::render);
+				target.beg_draw();
+				target.draw(draw_list);
+				target.end_draw();
+			}
+			profiler.end_frame();
 		}
 
 
@@ -113,14 +148,23 @@ class DemoWindow : public wnd::BaseWindow
 
 			const gm2d::Point mouse_position(float(me.window_x), float(me.window_y));
 
+			// picks from the snapshot, the world itself may be in the middle of a step on the simulation thread
+			const phs::WorldSnapshot& balls = state();
 			if (me.lb_changed and me.is_lb_down) {
-				for (auto& ball : balls)
-					if (ball.contains(mouse_position))
-						f_ball = &ball;
+				for (size_t i = 0; i < balls.size(); ++i)
+					if (gm2d::Circle(gm2d::Point(balls.x[i], balls.y[i]), balls.radius[i]).contains(mouse_position))
+						f_ball = i;
 			}
 			if (me.lb_changed and not me.is_lb_down and f_ball) {
-				f_ball->acceleration += gm2d::Vector(mouse_position, f_ball->center) * 100.f;
-				f_ball = nullptr;
+				const size_t ball = *f_ball;
+				f_ball.reset();
+				if (ball >= balls.size())
+					return;
+				const auto impulse = gm2d::Vector(mouse_position, gm2d::Point(balls.x[ball], balls.y[ball])) * 100.f;
+				if (simulation)
+					simulation->post([this, ball, impulse](phs::World& w) { recorder->impulse(w.ball_index(ball), impulse); });
+				else
+					recorder->impulse(world.ball_index(ball), impulse);
 			}
 		}
 		using Color = D2D1::ColorF;
@@ -193,7 +237,11 @@ class DemoWindow : public wnd::BaseWindow
 };
 
 
-int main()
+// --threaded steps the world on a thread of its own instead of inside the frame
+int main(int argc, char** argv)
 {
-	auto wnd = DemoWindow(800, 600);
+	bool threaded = false;
+	for (int i = 1; i < argc; ++i)
+		threaded = threaded or std::string_view(argv[i]) == "--threaded";
+	auto wnd = DemoWindow(800, 600, threaded);
 }
\ No newline at end of file
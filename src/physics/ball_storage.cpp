@@ -0,0 +1,208 @@
+#include "ball_storage.h"
+#include <algorithm>
+
+// the vector paths only exist for float, double and Fixed builds use the portable loop
+#if defined(PHS_SCALAR_FLOAT) && defined(__AVX__)
+#define PHS_AVX
+#include <immintrin.h>
+#elif defined(PHS_SCALAR_FLOAT) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PHS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace phs
+{
+	static size_t round_up_to_lanes(size_t n) {
+		return (n + BallStorage::lanes - 1) / BallStorage::lanes * BallStorage::lanes;
+	}
+
+	size_t BallStorage::size()const {
+		return count;
+	}
+
+	size_t BallStorage::padded_size()const {
+		return x.size();
+	}
+
+	bool BallStorage::empty()const {
+		return count == 0;
+	}
+
+	void BallStorage::resize_arrays(size_t n) {
+		for (auto* array : { &x, &y, &vx, &vy, &ax, &ay, &radius, &inv_mass })
+			array->resize(n, Float(0));
+		sleeping.resize(n, 0);
+	}
+
+	void BallStorage::reserve(size_t n) {
+		for (auto* array : { &x, &y, &vx, &vy, &ax, &ay, &radius, &inv_mass })
+			array->reserve(round_up_to_lanes(n));
+		sleeping.reserve(round_up_to_lanes(n));
+	}
+
+	void BallStorage::clear() {
+		count = 0;
+		resize_arrays(0);
+	}
+
+	void BallStorage::resize(size_t n) {
+		clear();
+		count = n;
+		resize_arrays(round_up_to_lanes(n));
+	}
+
+	void BallStorage::push_back(const Ball& ball) {
+		if (count == padded_size())
+			resize_arrays(round_up_to_lanes(count + 1));
+
+		radius[count] = ball.radius;
+		inv_mass[count] = Float(1) / ball.mass;
+		store(count, ball);
+		count += 1;
+	}
+
+	Ball BallStorage::load(size_t i)const {
+		Ball ball(Point(x[i], y[i]), radius[i], Float(1) / inv_mass[i]);
+		ball.velocity = Vector(vx[i], vy[i]);
+		ball.acceleration = Vector(ax[i], ay[i]);
+		return ball;
+	}
+
+	void BallStorage::store(size_t i, const Ball& ball) {
+		x[i] = ball.center.x;
+		y[i] = ball.center.y;
+		vx[i] = ball.velocity.x;
+		vy[i] = ball.velocity.y;
+		ax[i] = ball.acceleration.x;
+		ay[i] = ball.acceleration.y;
+	}
+
+	Point BallStorage::center(size_t i)const {
+		return Point(x[i], y[i]);
+	}
+
+	Vector BallStorage::velocity(size_t i)const {
+		return Vector(vx[i], vy[i]);
+	}
+
+	void BallStorage::permute(const std::vector<std::uint32_t>& order) {
+		const size_t padded = padded_size();
+		spare.resize(padded, Float(0));
+		for (auto* array : { &x, &y, &vx, &vy, &ax, &ay, &radius, &inv_mass }) {
+			for (size_t k = 0; k < count; ++k)
+				spare[k] = (*array)[order[k]];
+			std::fill(spare.begin() + count, spare.end(), Float(0));
+			array->swap(spare);
+		}
+		spare_flags.resize(padded, 0);
+		for (size_t k = 0; k < count; ++k)
+			spare_flags[k] = sleeping[order[k]];
+		std::fill(spare_flags.begin() + count, spare_flags.end(), std::uint8_t(0));
+		sleeping.swap(spare_flags);
+	}
+
+	// no fused multiply-add anywhere, so every path rounds exactly like Ball::dt
+	void integrate(BallStorage& balls, Float t, const Vector& gravity) {
+		integrate(balls, 0, balls.padded_size(), t, gravity);
+		clear_padding(balls);
+	}
+
+	void integrate(BallStorage& balls, size_t begin, size_t end, Float t, const Vector& gravity) {
+		const Float h = t * t * Float(0.5);
+
+		Float* const x = balls.x.data();
+		Float* const y = balls.y.data();
+		Float* const vx = balls.vx.data();
+		Float* const vy = balls.vy.data();
+		Float* const ax = balls.ax.data();
+		Float* const ay = balls.ay.data();
+
+#if defined(PHS_AVX)
+		const __m256 t8 = _mm256_set1_ps(t);
+		const __m256 h8 = _mm256_set1_ps(h);
+		const __m256 gx8 = _mm256_set1_ps(gravity.x);
+		const __m256 gy8 = _mm256_set1_ps(gravity.y);
+		const __m256 zero = _mm256_setzero_ps();
+		for (size_t i = begin; i < end; i += 8) {
+			const __m256 ax8 = _mm256_add_ps(_mm256_load_ps(ax + i), gx8);
+			const __m256 ay8 = _mm256_add_ps(_mm256_load_ps(ay + i), gy8);
+			const __m256 vx8 = _mm256_load_ps(vx + i);
+			const __m256 vy8 = _mm256_load_ps(vy + i);
+			_mm256_store_ps(x + i, _mm256_add_ps(_mm256_load_ps(x + i), _mm256_add_ps(_mm256_mul_ps(t8, vx8), _mm256_mul_ps(h8, ax8))));
+			_mm256_store_ps(y + i, _mm256_add_ps(_mm256_load_ps(y + i), _mm256_add_ps(_mm256_mul_ps(t8, vy8), _mm256_mul_ps(h8, ay8))));
+			_mm256_store_ps(vx + i, _mm256_add_ps(vx8, _mm256_mul_ps(t8, ax8)));
+			_mm256_store_ps(vy + i, _mm256_add_ps(vy8, _mm256_mul_ps(t8, ay8)));
+			_mm256_store_ps(ax + i, zero);
+			_mm256_store_ps(ay + i, zero);
+		}
+#elif defined(PHS_SSE2)
+		const __m128 t4 = _mm_set1_ps(t);
+		const __m128 h4 = _mm_set1_ps(h);
+		const __m128 gx4 = _mm_set1_ps(gravity.x);
+		const __m128 gy4 = _mm_set1_ps(gravity.y);
+		const __m128 zero = _mm_setzero_ps();
+		for (size_t i = begin; i < end; i += 4) {
+			const __m128 ax4 = _mm_add_ps(_mm_load_ps(ax + i), gx4);
+			const __m128 ay4 = _mm_add_ps(_mm_load_ps(ay + i), gy4);
+			const __m128 vx4 = _mm_load_ps(vx + i);
+			const __m128 vy4 = _mm_load_ps(vy + i);
+			_mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), _mm_add_ps(_mm_mul_ps(t4, vx4), _mm_mul_ps(h4, ax4))));
+			_mm_store_ps(y + i, _mm_add_ps(_mm_load_ps(y + i), _mm_add_ps(_mm_mul_ps(t4, vy4), _mm_mul_ps(h4, ay4))));
+			_mm_store_ps(vx + i, _mm_add_ps(vx4, _mm_mul_ps(t4, ax4)));
+			_mm_store_ps(vy + i, _mm_add_ps(vy4, _mm_mul_ps(t4, ay4)));
+			_mm_store_ps(ax + i, zero);
+			_mm_store_ps(ay + i, zero);
+		}
+#else
+		for (size_t i = begin; i < end; ++i) {
+			const Float ax1 = ax[i] + gravity.x;
+			const Float ay1 = ay[i] + gravity.y;
+			x[i] += t * vx[i] + h * ax1;
+			y[i] += t * vy[i] + h * ay1;
+			vx[i] += t * ax1;
+			vy[i] += t * ay1;
+			ax[i] = Float(0);
+			ay[i] = Float(0);
+		}
+#endif
+	}
+
+	void integrate_awake(BallStorage& balls, size_t begin, size_t end, Float t, const Vector& gravity) {
+		const Float h = t * t * Float(0.5);
+
+		for (size_t block = begin; block < end; block += BallStorage::lanes) {
+			const size_t block_end = std::min(block + BallStorage::lanes, end);
+			size_t asleep = 0;
+			for (size_t i = block; i < block_end; ++i)
+				asleep += balls.sleeping[i];
+
+			if (asleep == 0) {
+				integrate(balls, block, block_end, t, gravity);
+				continue;
+			}
+			if (asleep == block_end - block)
+				continue;
+
+			// the scalar loop of integrate, one ball at a time
+			for (size_t i = block; i < block_end; ++i) {
+				if (balls.sleeping[i])
+					continue;
+				const Float ax1 = balls.ax[i] + gravity.x;
+				const Float ay1 = balls.ay[i] + gravity.y;
+				balls.x[i] += t * balls.vx[i] + h * ax1;
+				balls.y[i] += t * balls.vy[i] + h * ay1;
+				balls.vx[i] += t * ax1;
+				balls.vy[i] += t * ay1;
+				balls.ax[i] = Float(0);
+				balls.ay[i] = Float(0);
+			}
+		}
+	}
+
+	// the padding goes through the kernels as well, this puts it back to zero
+	void clear_padding(BallStorage& balls) {
+		for (size_t i = balls.size(); i < balls.padded_size(); ++i) {
+			balls.x[i] = balls.y[i] = balls.vx[i] = balls.vy[i] = Float(0);
+		}
+	}
+}
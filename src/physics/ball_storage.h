@@ -0,0 +1,102 @@
+#pragma once
+#include "physics.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace phs
+{
+	template<class T, size_t Alignment>
+	struct AlignedAllocator
+	{
+		using value_type = T;
+
+		template<class U>
+		struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+		AlignedAllocator() = default;
+		template<class U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+		T* allocate(size_t n) {
+			return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+		}
+
+		void deallocate(T* p, size_t) noexcept {
+			::operator delete(p, std::align_val_t(Alignment));
+		}
+
+		template<class U>
+		bool operator==(const AlignedAllocator<U, Alignment>&)const noexcept { return true; }
+	};
+
+	// cache line aligned, which is also enough for any SIMD load
+	template<class T>
+	using AlignedVector = std::vector<T, AlignedAllocator<T, 64>>;
+
+	// makes room for n elements at least doubling the capacity, like push_back grows
+	// resize and insert on a cleared vector allocate just the size asked for, and so again whenever a count that
+	// settles slowly, like the contacts of a pile, grows by a few
+	template<class Vector>
+	void reserve_doubling(Vector& v, size_t n) {
+		if (n > v.capacity())
+			v.reserve(std::max(n, 2 * v.capacity()));
+	}
+
+	// structure of arrays storage for balls
+	// every array is padded with zeros to a multiple of `lanes`, so kernels can run whole SIMD registers to the end
+	class BallStorage
+	{
+	public:
+		static constexpr size_t lanes = 16;
+
+		AlignedVector<Float> x, y;
+		AlignedVector<Float> vx, vy;
+		AlignedVector<Float> ax, ay;
+		AlignedVector<Float> radius;
+		AlignedVector<Float> inv_mass;
+		// 1 for balls put to sleep by the world, which the integration and the narrow phase skip
+		AlignedVector<std::uint8_t> sleeping;
+
+		size_t size()const;
+		size_t padded_size()const;
+		bool empty()const;
+
+		void reserve(size_t n);
+		void clear();
+		// n balls with every array zeroed, to be filled in place
+		void resize(size_t n);
+		void push_back(const Ball& ball);
+
+		// copies one ball out of the arrays
+		Ball load(size_t i)const;
+		// writes back the kinematic state (center, velocity, acceleration), radius and mass are left untouched
+		void store(size_t i, const Ball& ball);
+
+		Point center(size_t i)const;
+		Vector velocity(size_t i)const;
+
+		// moves ball order[k] to k in every array, order has to be a permutation of [0, size())
+		// the arrays are swapped with spare ones, so permuting again does not allocate
+		void permute(const std::vector<std::uint32_t>& order);
+	private:
+		void resize_arrays(size_t n);
+		size_t count{};
+		AlignedVector<Float> spare{};
+		AlignedVector<std::uint8_t> spare_flags{};
+	};
+
+	// the equivalent of Ball::dt with `gravity` added to the acceleration first, for all balls in one pass
+	void integrate(BallStorage& balls, Float t, const Vector& gravity);
+
+	// integrates the balls in [begin, end), both multiples of BallStorage::lanes (or end == padded_size())
+	// leaves the padding dirty, use the overload above unless the range is split between threads
+	void integrate(BallStorage& balls, size_t begin, size_t end, Float t, const Vector& gravity);
+	void clear_padding(BallStorage& balls);
+
+	// the same as integrate over [begin, end) but leaves sleeping balls untouched,
+	// blocks of BallStorage::lanes balls that are all awake still go through the vector kernel
+	void integrate_awake(BallStorage& balls, size_t begin, size_t end, Float t, const Vector& gravity);
+}
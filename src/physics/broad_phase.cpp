@@ -0,0 +1,449 @@
+#include "broad_phase.h"
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <numeric>
+
+namespace phs
+{
+	UniformGrid::UniformGrid(Float cell_size)
+		: requested_cell_size{ cell_size }
+	{}
+
+	size_t UniformGrid::bucket(std::int32_t cx, std::int32_t cy)const {
+		const auto h = std::uint32_t(cx) * 73856093u ^ std::uint32_t(cy) * 19349663u;
+		return size_t(h) & bucket_mask;
+	}
+
+	void UniformGrid::build(const BallStorage& balls) {
+		const size_t n = balls.size();
+
+		cell_size = requested_cell_size;
+		if (cell_size <= Float(0)) {
+			for (size_t i = 0; i < n; ++i)
+				cell_size = std::max(cell_size, Float(2) * balls.radius[i]);
+			if (cell_size <= Float(0))
+				cell_size = Float(1);
+		}
+		inv_cell_size = Float(1) / cell_size;
+
+		// twice as many buckets as balls keeps the chains short
+		const size_t buckets = std::bit_ceil(std::max<size_t>(2 * n, 16));
+		bucket_mask = buckets - 1;
+
+		cell_x.resize(n);
+		cell_y.resize(n);
+		bucket_start.assign(buckets + 1, 0);
+		sorted_balls.resize(n);
+
+		for (size_t i = 0; i < n; ++i) {
+			cell_x[i] = std::int32_t(floor(balls.x[i] * inv_cell_size));
+			cell_y[i] = std::int32_t(floor(balls.y[i] * inv_cell_size));
+			bucket_start[bucket(cell_x[i], cell_y[i]) + 1] += 1;
+		}
+
+		for (size_t b = 0; b < buckets; ++b)
+			bucket_start[b + 1] += bucket_start[b];
+
+		// counting sort, stable so every bucket lists its balls in increasing order
+		for (size_t i = 0; i < n; ++i) {
+			const size_t b = bucket(cell_x[i], cell_y[i]);
+			sorted_balls[bucket_start[b]++] = std::uint32_t(i);
+		}
+
+		for (size_t b = buckets; b > 0; --b)
+			bucket_start[b] = bucket_start[b - 1];
+		bucket_start[0] = 0;
+	}
+
+	void UniformGrid::find_pairs(std::vector<Pair>& pairs)const {
+		find_pairs(0, cell_x.size(), pairs);
+	}
+
+	void UniformGrid::find_pairs(size_t begin, size_t end, std::vector<Pair>& pairs)const {
+		for (size_t i = begin; i < end; ++i) {
+			for (std::int32_t dy = -1; dy <= 1; ++dy) {
+				for (std::int32_t dx = -1; dx <= 1; ++dx) {
+					const std::int32_t cx = cell_x[i] + dx;
+					const std::int32_t cy = cell_y[i] + dy;
+					const size_t b = bucket(cx, cy);
+
+					// different cells can share a bucket, the cell check filters them out
+					for (auto k = bucket_start[b]; k < bucket_start[b + 1]; ++k) {
+						const size_t j = sorted_balls[k];
+						if (j > i and cell_x[j] == cx and cell_y[j] == cy)
+							pairs.emplace_back(i, j);
+					}
+				}
+			}
+		}
+	}
+
+	void UniformGrid::find_awake_pairs(size_t begin, size_t end, const AlignedVector<std::uint8_t>& sleeping, std::vector<Pair>& pairs)const {
+		for (size_t i = begin; i < end; ++i) {
+			if (sleeping[i])
+				continue;
+			for (std::int32_t dy = -1; dy <= 1; ++dy) {
+				for (std::int32_t dx = -1; dx <= 1; ++dx) {
+					const std::int32_t cx = cell_x[i] + dx;
+					const std::int32_t cy = cell_y[i] + dy;
+					const size_t b = bucket(cx, cy);
+
+					// a sleeping neighbour never looks for its own pairs, so the awake ball reports those in both directions
+					for (auto k = bucket_start[b]; k < bucket_start[b + 1]; ++k) {
+						const size_t j = sorted_balls[k];
+						if ((j > i or (j < i and sleeping[j])) and cell_x[j] == cx and cell_y[j] == cy)
+							pairs.emplace_back(std::min(i, j), std::max(i, j));
+					}
+				}
+			}
+		}
+	}
+
+	Float UniformGrid::get_cell_size()const {
+		return cell_size;
+	}
+
+	void PairTable::clear() {
+		found.clear();
+		start.clear();
+		grouped.clear();
+	}
+
+	void PairTable::group(size_t n, bool sort_second) {
+		// counting sort by the first ball, stable, so every ball keeps its pairs in the order they were found
+		start.assign(n + 1, 0);
+		for (const auto& [i, j] : found)
+			start[i + 1] += 1;
+		for (size_t i = 0; i < n; ++i)
+			start[i + 1] += start[i];
+
+		reserve_doubling(grouped, found.size());
+		grouped.resize(found.size());
+		for (const Pair& pair : found)
+			grouped[start[pair.first]++] = pair;
+		for (size_t i = n; i > 0; --i)
+			start[i] = start[i - 1];
+		start[0] = 0;
+
+		if (sort_second) {
+			for (size_t i = 0; i < n; ++i)
+				if (start[i + 1] - start[i] > 1)
+					std::sort(grouped.begin() + start[i], grouped.begin() + start[i + 1]);
+		}
+	}
+
+	const std::vector<Pair>& PairTable::pairs()const {
+		return grouped;
+	}
+
+	void PairTable::append(size_t begin, size_t end, std::vector<Pair>& out)const {
+		reserve_doubling(out, out.size() + (start[end] - start[begin]));
+		out.insert(out.end(), grouped.begin() + start[begin], grouped.begin() + start[end]);
+	}
+
+	void PairTable::append_awake(size_t begin, size_t end, const AlignedVector<std::uint8_t>& sleeping, std::vector<Pair>& out)const {
+		for (auto k = start[begin]; k < start[end]; ++k)
+			if (not (sleeping[grouped[k].first] and sleeping[grouped[k].second]))
+				out.push_back(grouped[k]);
+	}
+
+	void SweepAndPrune::build(const BallStorage& balls) {
+		const size_t n = balls.size();
+		const bool rebuild = order.size() != n;
+
+		// sweeping along the axis the centers spread wider on leaves fewer boxes overlapping on the sweep axis alone,
+		// the variances are taken again every build, in double so fixed point squares cannot overflow
+		double sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_yy = 0.0;
+		for (size_t i = 0; i < n; ++i) {
+			const double x = double(balls.x[i]), y = double(balls.y[i]);
+			sum_x += x;
+			sum_y += y;
+			sum_xx += x * x;
+			sum_yy += y * y;
+		}
+		const double inv_n = n > 0 ? 1.0 / double(n) : 0.0;
+		const double var_x = sum_xx * inv_n - sum_x * inv_n * sum_x * inv_n;
+		const double var_y = sum_yy * inv_n - sum_y * inv_n * sum_y * inv_n;
+
+		// the other axis has to be clearly wider before the order is given up, so a square scene does not flip every step
+		const bool turn = not rebuild and (axis == 0 ? var_y > axis_switch * var_x : var_x > axis_switch * var_y);
+		if (rebuild or turn)
+			axis = var_y > var_x ? 1 : 0;
+		if (rebuild) {
+			order.resize(n);
+			std::iota(order.begin(), order.end(), std::uint32_t(0));
+		}
+
+		const AlignedVector<Float>& a = axis == 0 ? balls.x : balls.y;
+		const AlignedVector<Float>& b = axis == 0 ? balls.y : balls.x;
+		entries.resize(n);
+		for (size_t k = 0; k < n; ++k) {
+			const std::uint32_t i = order[k];
+			const Float r = balls.radius[i];
+			entries[k] = Entry{ a[i] - r, a[i] + r, b[i] - r, b[i] + r, i };
+		}
+
+		const auto before = [](const Entry& l, const Entry& r) { return l.lo < r.lo or (l.lo == r.lo and l.ball < r.ball); };
+		swaps = 0;
+		if (rebuild or turn) {
+			std::sort(entries.begin(), entries.end(), before);
+		}
+		else {
+			// an order that changed too much to repair cheaply is sorted from scratch instead
+			const size_t budget = 8 * n + 1024;
+			for (size_t k = 1; k < n; ++k) {
+				const Entry e = entries[k];
+				size_t j = k;
+				while (j > 0 and before(e, entries[j - 1])) {
+					entries[j] = entries[j - 1];
+					--j;
+				}
+				entries[j] = e;
+				swaps += k - j;
+				if (swaps > budget) {
+					std::sort(entries.begin(), entries.end(), before);
+					break;
+				}
+			}
+		}
+		for (size_t k = 0; k < n; ++k)
+			order[k] = entries[k].ball;
+
+		std::swap(table, last_table);
+		if (rebuild)
+			last_table.clear();
+		table.clear();
+
+		// boxes further along the order than the upper end of box k cannot overlap it
+		for (size_t k = 0; k < n; ++k) {
+			const Entry& e = entries[k];
+			for (size_t m = k + 1; m < n and entries[m].lo <= e.hi; ++m) {
+				const Entry& o = entries[m];
+				if (o.other_lo <= e.other_hi and e.other_lo <= o.other_hi)
+					table.add(e.ball, o.ball);
+			}
+		}
+
+		table.group(n, true);
+
+		const auto& now = table.pairs();
+		const auto& before_pairs = last_table.pairs();
+		added.clear();
+		removed.clear();
+		std::set_difference(now.begin(), now.end(), before_pairs.begin(), before_pairs.end(), std::back_inserter(added));
+		std::set_difference(before_pairs.begin(), before_pairs.end(), now.begin(), now.end(), std::back_inserter(removed));
+	}
+
+	void SweepAndPrune::find_pairs(std::vector<Pair>& pairs)const {
+		pairs.insert(pairs.end(), table.pairs().begin(), table.pairs().end());
+	}
+
+	void SweepAndPrune::find_pairs(size_t begin, size_t end, std::vector<Pair>& pairs)const {
+		table.append(begin, end, pairs);
+	}
+
+	void SweepAndPrune::find_awake_pairs(size_t begin, size_t end, const AlignedVector<std::uint8_t>& sleeping, std::vector<Pair>& pairs)const {
+		table.append_awake(begin, end, sleeping, pairs);
+	}
+
+	const std::vector<Pair>& SweepAndPrune::added_pairs()const {
+		return added;
+	}
+
+	const std::vector<Pair>& SweepAndPrune::removed_pairs()const {
+		return removed;
+	}
+
+	size_t SweepAndPrune::last_swaps()const {
+		return swaps;
+	}
+
+	size_t SweepAndPrune::sweep_axis()const {
+		return axis;
+	}
+
+	void SweepAndPrune::reset() {
+		// an order of the wrong size makes the next build start over
+		order.clear();
+	}
+
+	size_t HierarchicalGrid::bucket(std::uint32_t l, std::int32_t cx, std::int32_t cy)const {
+		const auto h = std::uint32_t(cx) * 73856093u ^ std::uint32_t(cy) * 19349663u ^ l * 83492791u;
+		return size_t(h) & bucket_mask;
+	}
+
+	void HierarchicalGrid::build(const BallStorage& balls) {
+		const size_t n = balls.size();
+
+		Float min_radius = std::numeric_limits<Float>::max(), max_radius = Float(0);
+		for (size_t i = 0; i < n; ++i) {
+			if (balls.radius[i] > Float(0))
+				min_radius = std::min(min_radius, balls.radius[i]);
+			max_radius = std::max(max_radius, balls.radius[i]);
+		}
+		if (max_radius <= Float(0))
+			min_radius = max_radius = Float(0.5);
+
+		// level l has cells of 2^l times the smallest diameter, the top level fits the largest ball
+		levels = 1;
+		cell_size[0] = Float(2) * min_radius;
+		while (levels < max_levels and cell_size[levels - 1] < Float(2) * max_radius) {
+			cell_size[levels] = cell_size[levels - 1] * Float(2);
+			++levels;
+		}
+		cell_size[levels - 1] = std::max(cell_size[levels - 1], Float(2) * max_radius);
+		for (size_t l = 0; l < levels; ++l)
+			inv_cell_size[l] = Float(1) / cell_size[l];
+		level_balls.fill(0);
+		level_radius.fill(Float(0));
+
+		// twice as many buckets as balls keeps the chains short, as in the uniform grid
+		const size_t buckets = std::bit_ceil(std::max<size_t>(2 * n, 16));
+		bucket_mask = buckets - 1;
+
+		balls_by_index.resize(n);
+		bucket_start.assign(buckets + 1, 0);
+		sorted_balls.resize(n);
+
+		for (size_t i = 0; i < n; ++i) {
+			std::uint32_t l = 0;
+			const Float diameter = Float(2) * balls.radius[i];
+			while (l + 1 < levels and cell_size[l] < diameter)
+				++l;
+			level_balls[l] += 1;
+			level_radius[l] = std::max(level_radius[l], balls.radius[i]);
+			Entry& e = balls_by_index[i];
+			e = Entry{ std::int32_t(floor(balls.x[i] * inv_cell_size[l])), std::int32_t(floor(balls.y[i] * inv_cell_size[l])),
+				std::uint32_t(i), l, balls.x[i], balls.y[i], balls.radius[i] };
+			bucket_start[bucket(l, e.cx, e.cy) + 1] += 1;
+		}
+
+		for (size_t b = 0; b < buckets; ++b)
+			bucket_start[b + 1] += bucket_start[b];
+		for (const Entry& e : balls_by_index)
+			sorted_balls[bucket_start[bucket(e.level, e.cx, e.cy)]++] = e;
+		for (size_t b = buckets; b > 0; --b)
+			bucket_start[b] = bucket_start[b - 1];
+		bucket_start[0] = 0;
+
+		table.clear();
+		for (const Entry& e : balls_by_index) {
+			for (std::uint32_t l = e.level; l < levels; ++l) {
+				if (level_balls[l] == 0)
+					continue;
+				const bool own_level = l == e.level;
+				const Float reach = e.radius + level_radius[l];
+				const auto x0 = std::int32_t(floor((e.x - reach) * inv_cell_size[l])), x1 = std::int32_t(floor((e.x + reach) * inv_cell_size[l]));
+				const auto y0 = std::int32_t(floor((e.y - reach) * inv_cell_size[l])), y1 = std::int32_t(floor((e.y + reach) * inv_cell_size[l]));
+				for (std::int32_t cy = y0; cy <= y1; ++cy) {
+					for (std::int32_t cx = x0; cx <= x1; ++cx) {
+						const size_t b = bucket(l, cx, cy);
+						for (auto k = bucket_start[b]; k < bucket_start[b + 1]; ++k) {
+							const Entry& o = sorted_balls[k];
+							// balls of its own level pair up once from the lower index, balls of coarser levels always
+							if ((own_level and o.ball <= e.ball) or o.level != l or o.cx != cx or o.cy != cy)
+								continue;
+							const Float d = e.radius + o.radius;
+							if (fabs(o.x - e.x) <= d and fabs(o.y - e.y) <= d)
+								table.add(e.ball, o.ball);
+						}
+					}
+				}
+			}
+		}
+		table.group(n, false);
+	}
+
+	void HierarchicalGrid::find_pairs(std::vector<Pair>& pairs)const {
+		pairs.insert(pairs.end(), table.pairs().begin(), table.pairs().end());
+	}
+
+	void HierarchicalGrid::find_pairs(size_t begin, size_t end, std::vector<Pair>& pairs)const {
+		table.append(begin, end, pairs);
+	}
+
+	void HierarchicalGrid::find_awake_pairs(size_t begin, size_t end, const AlignedVector<std::uint8_t>& sleeping, std::vector<Pair>& pairs)const {
+		table.append_awake(begin, end, sleeping, pairs);
+	}
+
+	size_t HierarchicalGrid::level_count()const {
+		return levels;
+	}
+
+	Float HierarchicalGrid::get_cell_size(size_t l)const {
+		return cell_size[l];
+	}
+
+	size_t HierarchicalGrid::level_size(size_t l)const {
+		return level_balls[l];
+	}
+
+	void WallTree::build(const std::vector<Wall>& walls) {
+		nodes.clear();
+		wall_index.resize(walls.size());
+		for (size_t i = 0; i < walls.size(); ++i)
+			wall_index[i] = std::uint32_t(i);
+
+		if (walls.empty())
+			return;
+
+		nodes.reserve(2 * (walls.size() / leaf_size + 1));
+		nodes.push_back(Node{ Float(0), Float(0), Float(0), Float(0), 0, std::uint32_t(walls.size()) });
+		split(0, walls);
+	}
+
+	void WallTree::split(std::uint32_t node, const std::vector<Wall>& walls) {
+		const auto first = nodes[node].first;
+		const auto count = nodes[node].count;
+
+		// bounds of the walls and of their midpoints, the split runs along the longer side of the latter
+		Float min_x = std::numeric_limits<Float>::max(), min_y = std::numeric_limits<Float>::max();
+		Float max_x = std::numeric_limits<Float>::lowest(), max_y = std::numeric_limits<Float>::lowest();
+		Float mid_min_x = min_x, mid_min_y = min_y, mid_max_x = max_x, mid_max_y = max_y;
+		for (auto k = first; k < first + count; ++k) {
+			const Wall& wall = walls[wall_index[k]];
+			min_x = std::min(min_x, std::min(wall.beg.x, wall.end.x) - wall.radius);
+			min_y = std::min(min_y, std::min(wall.beg.y, wall.end.y) - wall.radius);
+			max_x = std::max(max_x, std::max(wall.beg.x, wall.end.x) + wall.radius);
+			max_y = std::max(max_y, std::max(wall.beg.y, wall.end.y) + wall.radius);
+
+			const Float mid_x = (wall.beg.x + wall.end.x) * Float(0.5);
+			const Float mid_y = (wall.beg.y + wall.end.y) * Float(0.5);
+			mid_min_x = std::min(mid_min_x, mid_x);
+			mid_min_y = std::min(mid_min_y, mid_y);
+			mid_max_x = std::max(mid_max_x, mid_x);
+			mid_max_y = std::max(mid_max_y, mid_y);
+		}
+		nodes[node].min_x = min_x;
+		nodes[node].min_y = min_y;
+		nodes[node].max_x = max_x;
+		nodes[node].max_y = max_y;
+
+		if (count <= leaf_size)
+			return;
+
+		// ties are broken by wall index, so the tree only depends on the walls
+		const bool along_x = mid_max_x - mid_min_x >= mid_max_y - mid_min_y;
+		const auto half = count / 2;
+		std::nth_element(wall_index.begin() + first, wall_index.begin() + first + half, wall_index.begin() + first + count,
+			[&](std::uint32_t a, std::uint32_t b) {
+				const Float ma = along_x ? walls[a].beg.x + walls[a].end.x : walls[a].beg.y + walls[a].end.y;
+				const Float mb = along_x ? walls[b].beg.x + walls[b].end.x : walls[b].beg.y + walls[b].end.y;
+				return ma < mb or (ma == mb and a < b);
+			});
+
+		const auto left = std::uint32_t(nodes.size());
+		nodes[node].first = left;
+		nodes[node].count = 0;
+		nodes.push_back(Node{ Float(0), Float(0), Float(0), Float(0), first, half });
+		nodes.push_back(Node{ Float(0), Float(0), Float(0), Float(0), first + half, count - half });
+		split(left, walls);
+		split(left + 1, walls);
+	}
+
+	size_t WallTree::size()const {
+		return wall_index.size();
+	}
+}
@@ -0,0 +1,281 @@
+#pragma once
+#include "ball_storage.h"
+#include "physics.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace phs
+{
+	using Pair = std::pair<size_t, size_t>;
+
+	enum class BroadPhaseKind : std::uint8_t { grid, sweep_and_prune, hierarchical_grid };
+
+	// what the step needs of a broad phase: built once per step from the balls, then asked for the candidate pairs
+	// of consecutive ranges of first balls, possibly from several threads at once
+	class BroadPhase
+	{
+	public:
+		virtual ~BroadPhase() = default;
+
+		virtual void build(const BallStorage& balls) = 0;
+		// appends every candidate pair (i, j), i < j, whose first ball is in [begin, end), sorted by i,
+		// concatenating consecutive ranges gives the pairs of [0, n)
+		virtual void find_pairs(size_t begin, size_t end, std::vector<Pair>& pairs)const = 0;
+		// leaves out the pairs of two sleeping balls, every other pair comes out once as (i, j), i < j
+		virtual void find_awake_pairs(size_t begin, size_t end, const AlignedVector<std::uint8_t>& sleeping, std::vector<Pair>& pairs)const = 0;
+	};
+
+	// spatial hash rebuilt every step from ball centers and radii
+	// every ball is binned into the cell containing its center, the cell size is at least
+	// the largest diameter, so two overlapping balls always sit in neighbouring cells
+	class UniformGrid : public BroadPhase
+	{
+	public:
+		// cell_size <= 0 picks the largest ball diameter on every build
+		explicit UniformGrid(Float cell_size = Float(0));
+
+		void build(const BallStorage& balls)override;
+
+		// appends every pair (i, j), i < j, of balls from neighbouring cells
+		// pairs come out sorted by i, so the result does not depend on hashing
+		void find_pairs(std::vector<Pair>& pairs)const;
+		// only the pairs whose first ball is in [begin, end), concatenating consecutive ranges gives find_pairs
+		void find_pairs(size_t begin, size_t end, std::vector<Pair>& pairs)const override;
+		// does not look at the neighbours of sleeping balls at all, so the pairs come in the order of their first awake ball
+		void find_awake_pairs(size_t begin, size_t end, const AlignedVector<std::uint8_t>& sleeping, std::vector<Pair>& pairs)const override;
+
+		// calls fn(ball index) for every ball whose center lies in a cell overlapping the box [min_x, max_x] x [min_y, max_y]
+		// boxes spanning more cells than there are balls just visit every ball
+		template<class F>
+		void query(Float min_x, Float min_y, Float max_x, Float max_y, F&& fn)const {
+			const auto x0 = std::int64_t(floor(min_x * inv_cell_size)), x1 = std::int64_t(floor(max_x * inv_cell_size));
+			const auto y0 = std::int64_t(floor(min_y * inv_cell_size)), y1 = std::int64_t(floor(max_y * inv_cell_size));
+			if ((x1 - x0 + 1) * (y1 - y0 + 1) > std::int64_t(cell_x.size())) {
+				for (size_t i = 0; i < cell_x.size(); ++i)
+					if (cell_x[i] >= x0 and cell_x[i] <= x1 and cell_y[i] >= y0 and cell_y[i] <= y1)
+						fn(i);
+				return;
+			}
+
+			for (auto cy = std::int32_t(y0); cy <= std::int32_t(y1); ++cy) {
+				for (auto cx = std::int32_t(x0); cx <= std::int32_t(x1); ++cx) {
+					const size_t b = bucket(cx, cy);
+					for (auto k = bucket_start[b]; k < bucket_start[b + 1]; ++k) {
+						const size_t j = sorted_balls[k];
+						if (cell_x[j] == cx and cell_y[j] == cy)
+							fn(j);
+					}
+				}
+			}
+		}
+
+		Float get_cell_size()const;
+	private:
+		size_t bucket(std::int32_t cx, std::int32_t cy)const;
+
+		Float requested_cell_size;
+		Float cell_size{};
+		Float inv_cell_size{};
+		size_t bucket_mask{};
+
+		std::vector<std::int32_t>cell_x;
+		std::vector<std::int32_t>cell_y;
+		std::vector<std::uint32_t>bucket_start;
+		std::vector<std::uint32_t>sorted_balls;
+	};
+
+	// pairs a broad phase finds all at once while building, grouped by their first ball,
+	// so they can be handed out by ranges of first balls like the grid does
+	class PairTable
+	{
+	public:
+		// drops the pairs found and grouped so far
+		void clear();
+		void add(size_t i, size_t j) {
+			found.emplace_back(std::min(i, j), std::max(i, j));
+		}
+		// groups the pairs added since clear by first ball, for n balls, keeping the order they were found in
+		// or ordering them by second ball as well with sort_second
+		void group(size_t n, bool sort_second);
+
+		// every grouped pair
+		const std::vector<Pair>& pairs()const;
+		// the grouped pairs whose first ball is in [begin, end)
+		void append(size_t begin, size_t end, std::vector<Pair>& out)const;
+		void append_awake(size_t begin, size_t end, const AlignedVector<std::uint8_t>& sleeping, std::vector<Pair>& out)const;
+	private:
+		std::vector<Pair> found{};
+		// the pairs of ball i are grouped[start[i], start[i + 1])
+		std::vector<std::uint32_t> start{};
+		std::vector<Pair> grouped{};
+	};
+
+	// sort and sweep over the bounding boxes of the balls, kept sorted along one axis from step to step
+	//
+	// the boxes are ordered by their lower end on the sweep axis, the axis along which the centers have the larger
+	// variance, taken again every build and switched once the other one is axis_switch times larger, which sorts from
+	// scratch, every other build starts from the order of the last one and repairs it with an insertion sort, which
+	// costs one pass plus one move per pair of balls that swapped places since the last step
+	// a sweep along the order then yields every pair of overlapping boxes, kept sorted by (i, j), so the pairs and the
+	// added and removed pairs against the last build come out of a merge
+	// not a general replacement for the grid: every box overlaps the boxes of a whole band across the scene on the sweep
+	// axis, so in large uniform scenes the sweep tests far more pairs than the grid does (at 100k balls of the demo scene
+	// a world step takes about twice as long as with the grid), it only pays off where the band stays thin and balls
+	// keep their order, and where mixed radii would make every grid cell as large as the largest ball
+	class SweepAndPrune : public BroadPhase
+	{
+	public:
+		void build(const BallStorage& balls)override;
+
+		void find_pairs(std::vector<Pair>& pairs)const;
+		void find_pairs(size_t begin, size_t end, std::vector<Pair>& pairs)const override;
+		void find_awake_pairs(size_t begin, size_t end, const AlignedVector<std::uint8_t>& sleeping, std::vector<Pair>& pairs)const override;
+
+		// pairs whose boxes started or stopped overlapping in the last build, sorted by (i, j)
+		// the first build after a change of the ball count or a reset reports every pair as added and none as removed
+		const std::vector<Pair>& added_pairs()const;
+		const std::vector<Pair>& removed_pairs()const;
+
+		// moves the insertion sort made in the last build, about the number of pairs that changed order
+		size_t last_swaps()const;
+		// 0 for x, 1 for y
+		size_t sweep_axis()const;
+
+		// forgets the order and the pairs, after the balls were renumbered, the next build sorts from scratch
+		// and reports every pair as added
+		void reset();
+	private:
+		struct Entry
+		{
+			// lower and upper end on the sweep axis, then on the other one
+			Float lo, hi;
+			Float other_lo, other_hi;
+			std::uint32_t ball;
+		};
+
+		static constexpr double axis_switch = 1.5;
+
+		size_t axis = 0;
+		size_t swaps = 0;
+		std::vector<std::uint32_t> order{};
+		std::vector<Entry> entries{};
+
+		// the pairs of this build and of the last one
+		PairTable table{};
+		PairTable last_table{};
+		std::vector<Pair> added{};
+		std::vector<Pair> removed{};
+	};
+
+	// grids of doubling cell sizes, every ball is binned by its radius into the level whose cells just fit its diameter
+	//
+	// the finest cells are as large as the smallest diameter, so small balls do not crowd into cells sized for the
+	// largest one and large balls do not span many small cells, whatever the spread of radii
+	// all levels share one spatial hash keyed by (level, cell), a ball looks for pairs on its own level and on every
+	// coarser level that holds balls, in the cells its box grown by the largest radius of that level touches (2 x 2
+	// on average), pairs of two levels are found once from the finer ball
+	// the pairs are found in build, with a box test, and grouped by first ball, so find_pairs only copies them
+	class HierarchicalGrid : public BroadPhase
+	{
+	public:
+		static constexpr size_t max_levels = 24;
+
+		void build(const BallStorage& balls)override;
+
+		void find_pairs(std::vector<Pair>& pairs)const;
+		void find_pairs(size_t begin, size_t end, std::vector<Pair>& pairs)const override;
+		// the pairs of sleeping balls are found in build as well and only left out here
+		void find_awake_pairs(size_t begin, size_t end, const AlignedVector<std::uint8_t>& sleeping, std::vector<Pair>& pairs)const override;
+
+		size_t level_count()const;
+		Float get_cell_size(size_t level)const;
+		// number of balls on a level
+		size_t level_size(size_t level)const;
+	private:
+		// a ball as the hash stores it, so a query reads its candidates from one array
+		struct Entry
+		{
+			std::int32_t cx, cy;
+			std::uint32_t ball;
+			std::uint32_t level;
+			Float x, y, radius;
+		};
+
+		size_t bucket(std::uint32_t level, std::int32_t cx, std::int32_t cy)const;
+
+		size_t levels = 0;
+		std::array<Float, max_levels> cell_size{};
+		std::array<Float, max_levels> inv_cell_size{};
+		std::array<size_t, max_levels> level_balls{};
+		std::array<Float, max_levels> level_radius{};
+		size_t bucket_mask{};
+
+		std::vector<Entry> balls_by_index{};
+		std::vector<std::uint32_t> bucket_start{};
+		std::vector<Entry> sorted_balls{};
+
+		PairTable table{};
+	};
+
+	// static bounding volume hierarchy over walls, built once and then queried per ball
+	// leaves hold up to leaf_size walls, inner nodes split their walls at the median along the longer axis
+	class WallTree
+	{
+	public:
+		static constexpr size_t leaf_size = 4;
+
+		void build(const std::vector<Wall>& walls);
+
+		// number of walls the tree was built from
+		size_t size()const;
+
+		// calls fn(wall index) for every wall whose box overlaps the box of the circle (x, y, radius)
+		template<class F>
+		void query(Float x, Float y, Float radius, F&& fn)const {
+			query(x - radius, y - radius, x + radius, y + radius, fn);
+		}
+
+		// calls fn(wall index) for every wall whose box overlaps the box [min_x, max_x] x [min_y, max_y]
+		template<class F>
+		void query(Float min_x, Float min_y, Float max_x, Float max_y, F&& fn)const {
+			if (nodes.empty())
+				return;
+
+			// a median split halves the walls on every level, so 64 entries cover any wall count
+			std::uint32_t stack[64];
+			size_t top = 0;
+			stack[top++] = 0;
+			while (top > 0) {
+				const Node& node = nodes[stack[--top]];
+				if (node.max_x < min_x or node.min_x > max_x or node.max_y < min_y or node.min_y > max_y)
+					continue;
+
+				if (node.count > 0) {
+					for (auto k = node.first; k < node.first + node.count; ++k)
+						fn(size_t(wall_index[k]));
+				}
+				else {
+					stack[top++] = node.first + 1;
+					stack[top++] = node.first;
+				}
+			}
+		}
+	private:
+		// a leaf when count > 0, walls wall_index[first, first + count)
+		// otherwise an inner node whose children are nodes[first] and nodes[first + 1]
+		struct Node
+		{
+			Float min_x, min_y, max_x, max_y;
+			std::uint32_t first;
+			std::uint32_t count;
+		};
+
+		void split(std::uint32_t node, const std::vector<Wall>& walls);
+
+		std::vector<Node>nodes;
+		std::vector<std::uint32_t>wall_index;
+	};
+}
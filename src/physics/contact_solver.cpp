@@ -0,0 +1,212 @@
+#include "contact_solver.h"
+#include "narrow_phase.h"
+#include <algorithm>
+#include <utility>
+
+namespace phs
+{
+	void ContactSolver::clear() {
+		ball_contacts.clear();
+		wall_contacts.clear();
+		previous_ball_contacts.clear();
+		previous_wall_contacts.clear();
+	}
+
+	void ContactSolver::remap_balls(const std::vector<std::uint32_t>& new_index) {
+		// the contacts of the last step are the ones the next step warm starts from
+		for (auto& contact : ball_contacts) {
+			const std::uint32_t a = new_index[contact.a], b = new_index[contact.b];
+			contact.a = std::min(a, b);
+			contact.b = std::max(a, b);
+		}
+		for (auto& contact : wall_contacts)
+			contact.a = new_index[contact.a];
+		sort_contacts(ball_contacts);
+		sort_contacts(wall_contacts);
+	}
+
+	void ContactSolver::build_contacts(const BallStorage& balls, const std::vector<Wall>& walls, const WallTree& wall_tree, const std::vector<Pair>& candidate_pairs) {
+		ball_contacts.clear();
+		// nothing moves while the contacts are built, so the batched rejection leaves out exactly pairs that are apart
+		std::uint32_t kept[pair_block];
+		for (size_t begin = 0; begin < candidate_pairs.size(); begin += pair_block) {
+			const size_t kept_count = keep_overlapping_pairs(balls, candidate_pairs.data() + begin, std::min(pair_block, candidate_pairs.size() - begin), kept);
+			for (size_t s = 0; s < kept_count; ++s) {
+				const auto [i, j] = candidate_pairs[begin + kept[s]];
+				const Vector d(balls.x[j] - balls.x[i], balls.y[j] - balls.y[i]);
+				const Float r = balls.radius[i] + balls.radius[j];
+				const Float dist2 = length2(d);
+				if (dist2 > r * r)
+					continue;
+
+				// coincident centers have no normal of their own, any one will do
+				const Float dist = sqrt(dist2);
+				const Vector normal = dist > Float(0) ? d / dist : Vector(Float(1), Float(0));
+				ball_contacts.push_back(Contact{ std::uint32_t(i), std::uint32_t(j), normal, Float(0), Float(0), Float(0) });
+			}
+		}
+
+		wall_contacts.clear();
+		std::uint8_t near[ball_block];
+		for (size_t block = 0; block < balls.size(); block += ball_block) {
+			const size_t m = std::min(ball_block, balls.size() - block);
+			mark_balls_near_walls(walls, wall_tree, balls, block, m, near);
+			for (size_t k = 0; k < m; ++k) {
+				const size_t i = block + k;
+				if (not near[k] or balls.sleeping[i])
+					continue;
+				const Point center = balls.center(i);
+				const Float radius = balls.radius[i];
+				wall_tree.query(center.x, center.y, radius, [&](size_t j) {
+					const Circle closest = walls[j].closest_circle(center);
+					const Float r = closest.radius + radius;
+					const Float dist2 = distance2(closest.center, center);
+					if (dist2 > r * r)
+						return;
+
+					const Float dist = sqrt(dist2);
+					const Vector normal = dist > Float(0) ? Vector(closest.center, center) / dist : Vector(walls[j].normal());
+					wall_contacts.push_back(Contact{ std::uint32_t(i), std::uint32_t(j), normal, Float(0), Float(0), Float(0) });
+				});
+			}
+		}
+	}
+
+	const std::vector<ContactSolver::Contact>& ContactSolver::last_ball_contacts()const {
+		return ball_contacts;
+	}
+
+	const std::vector<ContactSolver::Contact>& ContactSolver::last_wall_contacts()const {
+		return wall_contacts;
+	}
+
+	void ContactSolver::restore_contacts(std::vector<Contact> ball, std::vector<Contact> wall) {
+		clear();
+		ball_contacts = std::move(ball);
+		wall_contacts = std::move(wall);
+	}
+
+	void ContactSolver::sort_contacts(std::vector<Contact>& contacts) {
+		// the grid and the wall tree report contacts in their own order, sorted they can be matched against the last step
+		std::sort(contacts.begin(), contacts.end(), [](const Contact& p, const Contact& q) {
+			return p.a < q.a or (p.a == q.a and p.b < q.b);
+		});
+	}
+
+	void ContactSolver::warm_start_contacts(std::vector<Contact>& contacts, const std::vector<Contact>& previous) {
+		// both lists are sorted, one merge walk finds every contact that already existed
+		size_t k = 0;
+		for (auto& contact : contacts) {
+			while (k < previous.size() and (previous[k].a < contact.a or (previous[k].a == contact.a and previous[k].b < contact.b)))
+				++k;
+			if (k < previous.size() and previous[k].a == contact.a and previous[k].b == contact.b)
+				contact.impulse = previous[k].impulse;
+		}
+	}
+
+	void ContactSolver::apply_ball_impulse(BallStorage& balls, const Contact& contact, Float impulse)const {
+		const Vector p = contact.normal * impulse;
+		balls.vx[contact.a] -= p.x * balls.inv_mass[contact.a];
+		balls.vy[contact.a] -= p.y * balls.inv_mass[contact.a];
+		balls.vx[contact.b] += p.x * balls.inv_mass[contact.b];
+		balls.vy[contact.b] += p.y * balls.inv_mass[contact.b];
+	}
+
+	void ContactSolver::apply_wall_impulse(BallStorage& balls, const Contact& contact, Float impulse)const {
+		balls.vx[contact.a] += contact.normal.x * impulse * balls.inv_mass[contact.a];
+		balls.vy[contact.a] += contact.normal.y * impulse * balls.inv_mass[contact.a];
+	}
+
+	void ContactSolver::solve_velocities(BallStorage& balls) {
+		for (size_t iteration = 0; iteration < velocity_iterations; ++iteration) {
+			for (auto& contact : ball_contacts) {
+				const Float vn = dot(balls.velocity(contact.b) - balls.velocity(contact.a), contact.normal);
+				// the accumulated impulse may shrink again but never pulls the balls together
+				const Float impulse = std::max(contact.impulse + (contact.velocity_bias - vn) * contact.normal_mass, Float(0));
+				apply_ball_impulse(balls, contact, impulse - contact.impulse);
+				contact.impulse = impulse;
+			}
+			for (auto& contact : wall_contacts) {
+				const Float vn = dot(balls.velocity(contact.a), contact.normal);
+				const Float impulse = std::max(contact.impulse + (contact.velocity_bias - vn) * contact.normal_mass, Float(0));
+				apply_wall_impulse(balls, contact, impulse - contact.impulse);
+				contact.impulse = impulse;
+			}
+		}
+	}
+
+	void ContactSolver::solve_positions(BallStorage& balls, const std::vector<Wall>& walls)const {
+		// the overlap is measured again from the moved centers on every iteration
+		for (size_t iteration = 0; iteration < position_iterations; ++iteration) {
+			for (const auto& contact : ball_contacts) {
+				const size_t i = contact.a, j = contact.b;
+				const Vector d(balls.x[j] - balls.x[i], balls.y[j] - balls.y[i]);
+				const Float dist = length(d);
+				const Float overlap = balls.radius[i] + balls.radius[j] - dist;
+				if (overlap <= slop)
+					continue;
+
+				const Vector normal = dist > Float(0) ? d / dist : contact.normal;
+				const Float correction = std::min(correction_rate * (overlap - slop), max_correction) / (balls.inv_mass[i] + balls.inv_mass[j]);
+				balls.x[i] -= normal.x * correction * balls.inv_mass[i];
+				balls.y[i] -= normal.y * correction * balls.inv_mass[i];
+				balls.x[j] += normal.x * correction * balls.inv_mass[j];
+				balls.y[j] += normal.y * correction * balls.inv_mass[j];
+			}
+			for (const auto& contact : wall_contacts) {
+				const size_t i = contact.a;
+				const Point center = balls.center(i);
+				const Circle closest = walls[contact.b].closest_circle(center);
+				const Float dist = distance(closest.center, center);
+				const Float overlap = closest.radius + balls.radius[i] - dist;
+				if (overlap <= slop)
+					continue;
+
+				// the wall does not move, so the ball takes all of the correction
+				const Vector normal = dist > Float(0) ? Vector(closest.center, center) / dist : contact.normal;
+				const Float correction = std::min(correction_rate * (overlap - slop), max_correction);
+				balls.x[i] += normal.x * correction;
+				balls.y[i] += normal.y * correction;
+			}
+		}
+	}
+
+	void ContactSolver::solve(BallStorage& balls, const std::vector<Wall>& walls, const WallTree& wall_tree,
+		const std::vector<Pair>& candidate_pairs, std::vector<Pair>& ball_ball_cols, std::vector<Pair>& ball_wall_cols) {
+
+		std::swap(ball_contacts, previous_ball_contacts);
+		std::swap(wall_contacts, previous_wall_contacts);
+		build_contacts(balls, walls, wall_tree, candidate_pairs);
+		sort_contacts(ball_contacts);
+		sort_contacts(wall_contacts);
+		if (warm_start) {
+			warm_start_contacts(ball_contacts, previous_ball_contacts);
+			warm_start_contacts(wall_contacts, previous_wall_contacts);
+		}
+
+		// effective masses and restitution targets from the velocities before any impulse
+		for (auto& contact : ball_contacts) {
+			contact.normal_mass = Float(1) / (balls.inv_mass[contact.a] + balls.inv_mass[contact.b]);
+			const Float vn = dot(balls.velocity(contact.b) - balls.velocity(contact.a), contact.normal);
+			contact.velocity_bias = vn < -restitution_threshold ? -restitution * vn : Float(0);
+		}
+		for (auto& contact : wall_contacts) {
+			contact.normal_mass = Float(1) / balls.inv_mass[contact.a];
+			const Float vn = dot(balls.velocity(contact.a), contact.normal);
+			contact.velocity_bias = vn < -restitution_threshold ? -restitution * vn : Float(0);
+		}
+
+		for (const auto& contact : ball_contacts)
+			apply_ball_impulse(balls, contact, contact.impulse);
+		for (const auto& contact : wall_contacts)
+			apply_wall_impulse(balls, contact, contact.impulse);
+
+		solve_velocities(balls);
+		solve_positions(balls, walls);
+
+		for (const auto& contact : ball_contacts)
+			ball_ball_cols.emplace_back(contact.a, contact.b);
+		for (const auto& contact : wall_contacts)
+			ball_wall_cols.emplace_back(contact.a, contact.b);
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "ball_storage.h"
+#include "broad_phase.h"
+#include "physics.h"
+#include <cstdint>
+#include <vector>
+
+namespace phs
+{
+	// sequential impulse solver over the contacts of one step, for piles the single resolution pass cannot settle
+	// every overlapping ball pair and ball wall pair is one contact point along the line between the centers,
+	// velocities are solved in velocity_iterations Gauss-Seidel passes starting from the impulses of the same contacts
+	// in the previous step (warm starting), overlap is then removed by projecting the centers apart, the overlap measured
+	// again after every move (nonlinear Gauss-Seidel), which never touches the velocities, so the correction adds no energy
+	class ContactSolver
+	{
+	public:
+		size_t velocity_iterations = 8;
+		size_t position_iterations = 3;
+		// normal velocity kept after an impact, only for impacts faster than restitution_threshold so resting contacts stay at rest
+		Float restitution = Float(0.5);
+		Float restitution_threshold = Float(20);
+		// share of the overlap beyond `slop` a position iteration projects away, and the most it moves any one contact
+		Float correction_rate = Float(0.2);
+		Float slop = Float(0.5);
+		Float max_correction = Float(5);
+		bool warm_start = true;
+
+		// builds the contacts of this step from the candidate pairs and the walls near every ball, then solves them
+		// the pairs that touched are appended to ball_ball_cols and ball_wall_cols
+		void solve(BallStorage& balls, const std::vector<Wall>& walls, const WallTree& wall_tree,
+			const std::vector<Pair>& candidate_pairs, std::vector<Pair>& ball_ball_cols, std::vector<Pair>& ball_wall_cols);
+
+		// forgets the impulses of the last step, after the balls or walls were replaced
+		void clear();
+		// keeps the impulses of the last step for balls that moved from index i to new_index[i]
+		void remap_balls(const std::vector<std::uint32_t>& new_index);
+
+		struct Contact
+		{
+			// ball indices a < b, or ball a and wall b
+			std::uint32_t a, b;
+			// from a to b, from the wall to the ball for wall contacts
+			Vector normal;
+			Float normal_mass;
+			Float velocity_bias;
+			Float impulse;
+		};
+
+		// the contacts of the last step, which the next step warm starts from
+		const std::vector<Contact>& last_ball_contacts()const;
+		const std::vector<Contact>& last_wall_contacts()const;
+		// replaces them, as when a saved world is loaded, only the ids and impulses are used
+		void restore_contacts(std::vector<Contact> ball, std::vector<Contact> wall);
+	private:
+
+		void build_contacts(const BallStorage& balls, const std::vector<Wall>& walls, const WallTree& wall_tree, const std::vector<Pair>& candidate_pairs);
+		static void sort_contacts(std::vector<Contact>& contacts);
+		static void warm_start_contacts(std::vector<Contact>& contacts, const std::vector<Contact>& previous);
+
+		void apply_ball_impulse(BallStorage& balls, const Contact& contact, Float impulse)const;
+		void apply_wall_impulse(BallStorage& balls, const Contact& contact, Float impulse)const;
+		void solve_velocities(BallStorage& balls);
+		void solve_positions(BallStorage& balls, const std::vector<Wall>& walls)const;
+
+		std::vector<Contact> ball_contacts{};
+		std::vector<Contact> wall_contacts{};
+		std::vector<Contact> previous_ball_contacts{};
+		std::vector<Contact> previous_wall_contacts{};
+	};
+}
@@ -1,30 +1,48 @@
 #pragma once
+#include "fixed.h"
+#include <algorithm>
 #include <concepts>
 #include <cmath>
+#include <limits>
 #include <numbers>
-#include <vector>
-#include <print>
+#include <optional>
+#include <cstddef>
+#include <type_traits>
+
+// the scalar of the whole engine is picked at build time,
+// define PHS_SCALAR_DOUBLE or PHS_SCALAR_FIXED for double or Fixed instead of float
+#if !defined(PHS_SCALAR_DOUBLE) && !defined(PHS_SCALAR_FIXED)
+#define PHS_SCALAR_FLOAT
+#endif
 
 namespace gm2d
 {
+#if defined(PHS_SCALAR_DOUBLE)
+	using Float = double;
+#elif defined(PHS_SCALAR_FIXED)
+	using Float = Fixed;
+#else
 	using Float = float;
+#endif
+	// sqrt, fabs, floor, cos and sin are called unqualified below, so Fixed finds its own through ADL
+	using std::sqrt, std::fabs, std::floor, std::cos, std::sin;
 	
 
 	static constexpr Float inv(Float x) { return Float(1) / x; }
 
+	// never below the resolution of Float, so Fixed still tells equal values apart from different ones
+	constexpr Float epsilon = std::max(Float(0.000001), std::numeric_limits<Float>::epsilon());
 
 	bool are_nearly_equal(auto a, auto b){
-		constexpr Float epsilon = Float(0.000001);
-		return std::fabs(a - b) < epsilon * std::fabs(a);
+		return fabs(a - b) < epsilon * fabs(a);
 	}
 
 	bool is_nearly_zero(auto x) {
-		constexpr Float epsilon = Float(0.000001);
-		return std::fabs(x) < epsilon;
+		return fabs(x) < epsilon;
 	}
 
-	constexpr Float pi = std::numbers::pi_v<Float>;
-	constexpr Float inv_pi = std::numbers::inv_pi_v<Float>;
+	constexpr Float pi = Float(std::numbers::pi);
+	constexpr Float inv_pi = Float(std::numbers::inv_pi);
 
 	static constexpr Float deg(Float rad) noexcept { return inv_pi * Float(180) * rad; }
 	static constexpr Float rad(Float deg) noexcept { return pi * (Float(1) / Float(180)) * deg; }
@@ -34,88 +52,91 @@ namespace gm2d
 	class DirectionVector;
 	class Matrix;
 
+	// everything below is defined inline at the end of this header, so the hot loops never call out of line,
+	// whatever does not need sqrt or trigonometry is constexpr as well
+
 	class Vector
 	{
 		public:
 			Float x{}, y{};
 
-			Vector(Float x, Float y);
+			constexpr Vector(Float x, Float y) noexcept;
 			Vector() = default;
 
-			Vector(const Point& begin, const Point& end);
+			constexpr Vector(const Point& begin, const Point& end) noexcept;
 
-			void operator*=(Float s);
-			void operator/=(Float s);
+			constexpr void operator*=(Float s) noexcept;
+			constexpr void operator/=(Float s) noexcept;
 
-			void operator+=(const Vector& other);
-			void operator-=(const Vector& other);
+			constexpr void operator+=(const Vector& other) noexcept;
+			constexpr void operator-=(const Vector& other) noexcept;
 
-			Vector perp()const;
-			Vector rotate(Float theta)const;
+			constexpr Vector perp()const noexcept;
+			Vector rotate(Float theta)const noexcept;
 
-			DirectionVector normalize()const;
+			DirectionVector normalize()const noexcept;
 
-			Point as_point()const;
+			constexpr Point as_point()const noexcept;
 	};
 
-	Vector operator*(const Vector& vector, Float scalar);
-	Vector operator/(const Vector& vector, Float scalar);
-	Vector operator*(Float scalar, const Vector& vector);
+	constexpr Vector operator*(const Vector& vector, Float scalar) noexcept;
+	constexpr Vector operator/(const Vector& vector, Float scalar) noexcept;
+	constexpr Vector operator*(Float scalar, const Vector& vector) noexcept;
 
-	Vector operator+(const Vector& p, const Vector& q);
-	Vector operator-(const Vector& p, const Vector& q);
+	constexpr Vector operator+(const Vector& p, const Vector& q) noexcept;
+	constexpr Vector operator-(const Vector& p, const Vector& q) noexcept;
 
-	Vector operator-(const Vector& v);
+	constexpr Vector operator-(const Vector& v) noexcept;
 	
-	Float dot(const Vector& p, const Vector& q);
+	constexpr Float dot(const Vector& p, const Vector& q) noexcept;
 	
-	Float det(const Vector& p, const Vector& q);
+	constexpr Float det(const Vector& p, const Vector& q) noexcept;
 
-	Float length2(const Vector& v);
-	Float length(const Vector& v);
+	constexpr Float length2(const Vector& v) noexcept;
+	Float length(const Vector& v) noexcept;
 	
-	Vector perp(const Vector& v);
-	Vector rotate(const Vector& v, Float theta);
+	constexpr Vector perp(const Vector& v) noexcept;
+	Vector rotate(const Vector& v, Float theta) noexcept;
 
 	class Point
 	{
 		public:
 			Float x{}, y{};
-			Point(Float x, Float y);
+			constexpr Point(Float x, Float y) noexcept;
 			Point() = default;
 
 
-			void operator+=(const Vector&);
-			void operator-=(const Vector&);
+			constexpr void operator+=(const Vector&) noexcept;
+			constexpr void operator-=(const Vector&) noexcept;
 
-			Point operator+(const Vector&)const;
-			Point operator-(const Vector&)const;
+			constexpr Point operator+(const Vector&)const noexcept;
+			constexpr Point operator-(const Vector&)const noexcept;
 
-			Vector as_vector()const;
+			constexpr Vector as_vector()const noexcept;
 	};
 
-	Float distance2(const Point&p1, const Point&p2);
-	Float distance(const Point& p1, const Point& p2);
+	constexpr Float distance2(const Point&p1, const Point&p2) noexcept;
+	Float distance(const Point& p1, const Point& p2) noexcept;
 
 	class DirectionVector
 	{
 		public:
-			explicit DirectionVector(Float theta);
-			explicit DirectionVector(const Vector&);
+			explicit DirectionVector(Float theta) noexcept;
+			explicit DirectionVector(const Vector&) noexcept;
 			DirectionVector() = delete;
 
-			operator Vector()const;
-			DirectionVector operator-()const;
+			constexpr operator Vector()const noexcept;
+			constexpr DirectionVector operator-()const noexcept;
 
-			DirectionVector perp()const;
+			constexpr DirectionVector perp()const noexcept;
 
-			Point as_point()const;
+			constexpr Point as_point()const noexcept;
 		private:
-			DirectionVector(Float x, Float y);
+			constexpr DirectionVector(Float x, Float y) noexcept;
 			Float x, y;
 	};
 
-	Float length(const DirectionVector&);
+	constexpr Float length(const DirectionVector&) noexcept;
 
 	class Matrix
 	{
@@ -123,37 +144,37 @@ namespace gm2d
 			Float a{}, b{}, c{}, d{};
 			//| a b |
 			//| c d |
-			Matrix(Float a, Float b, Float c, Float d);
-			Matrix(const Vector& column_1, const Vector& column_2);
+			constexpr Matrix(Float a, Float b, Float c, Float d) noexcept;
+			constexpr Matrix(const Vector& column_1, const Vector& column_2) noexcept;
 			Matrix() = default;
 
-			static Matrix id();
-			static Matrix clockwise_rotation(Float theta);
-			static Matrix counterclockwise_rotation(Float theta);
-			static Matrix stretching_x(Float k);
-			static Matrix stretching_y(Float k);
-			static Matrix scaling(Float k);
-			static Matrix shearing_x(Float k);
-			static Matrix shearing_y(Float k);
-			static Matrix reflection(const Vector&);
-			static Matrix orthogonal_projection(const Vector&);
-			static Matrix change_basis(const Vector& new_basis_1, const Vector& new_basis_2);
+			static constexpr Matrix id() noexcept;
+			static Matrix clockwise_rotation(Float theta) noexcept;
+			static Matrix counterclockwise_rotation(Float theta) noexcept;
+			static constexpr Matrix stretching_x(Float k) noexcept;
+			static constexpr Matrix stretching_y(Float k) noexcept;
+			static constexpr Matrix scaling(Float k) noexcept;
+			static constexpr Matrix shearing_x(Float k) noexcept;
+			static constexpr Matrix shearing_y(Float k) noexcept;
+			static constexpr Matrix reflection(const Vector&) noexcept;
+			static constexpr Matrix orthogonal_projection(const Vector&) noexcept;
+			static constexpr Matrix change_basis(const Vector& new_basis_1, const Vector& new_basis_2) noexcept;
 			
 
-			Matrix operator*(const Matrix& other)const;
-			Matrix operator+(const Matrix& other)const;
-			Matrix operator-(const Matrix& other)const;
+			constexpr Matrix operator*(const Matrix& other)const noexcept;
+			constexpr Matrix operator+(const Matrix& other)const noexcept;
+			constexpr Matrix operator-(const Matrix& other)const noexcept;
 
-			Vector operator*(const Vector& vector)const;
+			constexpr Vector operator*(const Vector& vector)const noexcept;
 
-			Matrix operator*(Float scalar)const;
-			Matrix operator/(Float scalar)const;
+			constexpr Matrix operator*(Float scalar)const noexcept;
+			constexpr Matrix operator/(Float scalar)const noexcept;
 
-			Matrix operator-()const;
+			constexpr Matrix operator-()const noexcept;
 
-			Matrix adjugate()const;
-			Matrix transpose()const;
-			Float det()const;
+			constexpr Matrix adjugate()const noexcept;
+			constexpr Matrix transpose()const noexcept;
+			constexpr Float det()const noexcept;
 	};
 
 	//Vector world_to_screen(Vector v, const Vector& screen_origin, const Vector& screen_basis_x, const Vector& screen_basis_y);
@@ -161,13 +182,31 @@ namespace gm2d
 	//Point change_basis(Point p, const Vector& new_basis_1, const Vector& new_basis_2);
 
 
-	Point orthogonal_projection(const Point beg, const Point end, const Point p);
-	Point reflection(const Point beg, const Point end, const Point p);
+	constexpr Point orthogonal_projection(const Point beg, const Point end, const Point p) noexcept;
+	constexpr Point reflection(const Point beg, const Point end, const Point p) noexcept;
 
-	Float distance2(const Point& beg, const Point& end, const Point& p);
-	Float distance(const Point& beg, const Point& end, const Point& p);
+	constexpr Float distance2(const Point& beg, const Point& end, const Point& p) noexcept;
+	Float distance(const Point& beg, const Point& end, const Point& p) noexcept;
 
-	std::vector<Point> lines_intersection(const Point& beg_1, const Point& end_1, const Point& beg_2, const Point& end_2);
+	// result of the intersection functions below, kept inline so they never touch the heap
+	// one point where two lines cross, the two starting points when they coincide, nothing otherwise
+	class Intersection
+	{
+		public:
+			constexpr size_t size()const noexcept;
+			constexpr bool empty()const noexcept;
+
+			constexpr const Point& operator[](size_t i)const noexcept;
+			constexpr const Point* begin()const noexcept;
+			constexpr const Point* end()const noexcept;
+
+			constexpr void push_back(const Point& p) noexcept;
+		private:
+			Point points[2]{};
+			size_t count{};
+	};
+
+	Intersection lines_intersection(const Point& beg_1, const Point& end_1, const Point& beg_2, const Point& end_2) noexcept;
 	
 	class Line 
 	{
@@ -175,21 +214,21 @@ namespace gm2d
 			Point point;
 			DirectionVector direction;
 
-			Line(const Point& p1, const Point& p2);
-			Line(const Point& p, const Vector& v);
+			Line(const Point& p1, const Point& p2) noexcept;
+			Line(const Point& p, const Vector& v) noexcept;
 
 
-			Float get_x_for_y(Float y)const;
-			Float get_y_for_x(Float x)const;
+			constexpr Float get_x_for_y(Float y)const noexcept;
+			constexpr Float get_y_for_x(Float x)const noexcept;
 
-			Point operator()(Float)const;
+			constexpr Point operator()(Float)const noexcept;
 
-			Point reflection(const Point&)const;
-			Point projection(const Point&)const;
+			constexpr Point reflection(const Point&)const noexcept;
+			constexpr Point projection(const Point&)const noexcept;
 
-			bool contains(const Point&)const;
+			bool contains(const Point&)const noexcept;
 	};
-	std::vector<Point> lines_intersection(const Line& line_1, const Line& line_2);
+	Intersection lines_intersection(const Line& line_1, const Line& line_2) noexcept;
 	
 	class LineSegment
 	{
@@ -197,13 +236,13 @@ namespace gm2d
 		Point beg;
 		Point end;
 
-		LineSegment(const Point& beg, const Point& end);
+		constexpr LineSegment(const Point& beg, const Point& end) noexcept;
 
-		Point closest_point(const Point& p)const;
-		bool contains(const Point& p)const;
+		Point closest_point(const Point& p)const noexcept;
+		bool contains(const Point& p)const noexcept;
 	};
 
-	std::vector<Point> line_segments_intersection(const LineSegment& seg_1, const LineSegment& seg_2);
+	Intersection line_segments_intersection(const LineSegment& seg_1, const LineSegment& seg_2) noexcept;
 
 
 	class Circle
@@ -212,9 +251,9 @@ namespace gm2d
 		Point center;
 		Float radius;
 
-		explicit Circle(Point center = Point(Float(0), Float(0)), Float radius = Float(1));
+		constexpr explicit Circle(Point center = Point(Float(0), Float(0)), Float radius = Float(1)) noexcept;
 
-		bool contains(const Point&)const;
+		constexpr bool contains(const Point&)const noexcept;
 	};
 
 
@@ -225,12 +264,574 @@ namespace gm2d
 		Point end;
 		Float radius;
 
-		Stadium(const Point& beg, const Point& end, Float radius);
+		constexpr Stadium(const Point& beg, const Point& end, Float radius) noexcept;
 
-		bool contains(const Point&)const;
+		bool contains(const Point&)const noexcept;
 
-		Circle closest_circle(const Point&)const;
+		Circle closest_circle(const Point&)const noexcept;
 
-		Vector normal()const;
+		Vector normal()const noexcept;
 	};
+
+	// time of impact of a moving circle, as the fraction t in [0, 1] of `motion` after which it first touches the target,
+	// nothing when it misses, t = 0 when it already overlaps the target and moves further in, nothing when it overlaps
+	// and moves out (the overlap tests handle both)
+	std::optional<Float> time_of_impact(const Point& center, const Vector& motion, const Circle& target) noexcept;
+	std::optional<Float> time_of_impact(const Circle& circle, const Vector& motion, const Circle& other, const Vector& other_motion) noexcept;
+	std::optional<Float> time_of_impact(const Circle& circle, const Vector& motion, const Stadium& stadium) noexcept;
+
+	static_assert(std::is_trivially_copyable_v<Vector>);
+	static_assert(std::is_trivially_copyable_v<Point>);
+	static_assert(std::is_trivially_copyable_v<DirectionVector>);
+	static_assert(std::is_trivially_copyable_v<Matrix>);
+	static_assert(std::is_trivially_copyable_v<Circle>);
+	static_assert(std::is_trivially_copyable_v<Stadium>);
+	static_assert(std::is_trivially_copyable_v<Intersection>);
+
+
+	constexpr Vector::Vector(Float x, Float y) noexcept
+		: x{ x }, y{ y }
+	{}
+
+	constexpr Vector::Vector(const Point& begin, const Point& end) noexcept
+		: x{ end.x - begin.x }, y{ end.y - begin.y }
+	{}
+
+	constexpr void Vector::operator*=(Float s) noexcept {
+		x *= s;
+		y *= s;
+	}
+
+	constexpr void Vector::operator/=(Float s) noexcept {
+		x /= s;
+		y /= s;
+	}
+
+	constexpr void Vector::operator+=(const Vector& other) noexcept {
+		x += other.x;
+		y += other.y;
+	}
+
+	constexpr void Vector::operator-=(const Vector& other) noexcept {
+		x -= other.x;
+		y -= other.y;
+	}
+
+	constexpr Point Vector::as_point()const noexcept {
+		return Point(x, y);
+	}
+
+	constexpr Vector Vector::perp()const noexcept {
+		return gm2d::perp(*this);
+	}
+	inline Vector Vector::rotate(Float theta)const noexcept {
+		return gm2d::rotate(*this, theta);
+	}
+
+	inline DirectionVector Vector::normalize()const noexcept {
+		return DirectionVector(*this);
+	}
+
+	constexpr Vector operator*(const Vector& vector, Float scalar) noexcept {
+		return Vector(scalar * vector.x, scalar * vector.y);
+	}
+
+	constexpr Vector operator/(const Vector& vector, Float scalar) noexcept {
+		return Vector(vector.x / scalar, vector.y / scalar);
+	}
+
+	constexpr Vector operator*(Float scalar, const Vector& vector) noexcept {
+		return Vector(vector.x * scalar, vector.y * scalar);
+	}
+
+	constexpr Vector operator+(const Vector& p, const Vector& q) noexcept {
+		return Vector(p.x + q.x, p.y + q.y);
+	}
+
+	constexpr Vector operator-(const Vector& p, const Vector& q) noexcept {
+		return Vector(p.x - q.x, p.y - q.y);
+	}
+
+	constexpr Vector operator-(const Vector& v) noexcept {
+		return Vector(-v.x, -v.y);
+	}
+
+	constexpr Float dot(const Vector& p, const Vector& q) noexcept {
+		return p.x * q.x + p.y * q.y;
+	}
+
+	constexpr Float det(const Vector& p, const Vector& q) noexcept {
+		return p.x * q.y - q.x * p.y;
+	}
+
+	constexpr Float length2(const Vector& v) noexcept {
+		return v.x * v.x + v.y * v.y;
+	}
+
+	
+	inline Float length(const Vector& v) noexcept {
+		return sqrt(length2(v));
+	}
+
+	
+	constexpr Vector perp(const Vector& v) noexcept {
+		return Vector(-v.y, v.x);
+	}
+
+	inline Vector rotate(const Vector& v, Float theta) noexcept {
+		const Float nx = v.x * cos(theta) - v.y * sin(theta);
+		const Float ny = v.y * cos(theta) + v.x * sin(theta);
+		return Vector(nx, ny);
+	}
+
+	constexpr Point::Point(Float x, Float y) noexcept
+		: x{ x }, y{ y }
+	{}
+
+	constexpr void Point::operator+=(const Vector&v) noexcept {
+		x += v.x;
+		y += v.y;
+	}
+	constexpr void Point::operator-=(const Vector& v) noexcept {
+		x -= v.x;
+		y -= v.y;
+	}
+
+	constexpr Vector Point::as_vector()const noexcept {
+		return Vector(x, y);
+	}
+
+	constexpr Point Point::operator+(const Vector& v)const noexcept {
+		return Point(x + v.x, y + v.y);
+	}
+
+	constexpr Point Point::operator-(const Vector& v)const noexcept {
+		return Point(x - v.x, y - v.y);
+	}
+
+	constexpr Float distance2(const Point& p1, const Point& p2) noexcept {
+		return length2({ p1, p2 });
+	}
+
+	inline Float distance(const Point& p1, const Point& p2) noexcept {
+		return length({ p1, p2 });
+	}
+
+	inline DirectionVector::DirectionVector(Float theta) noexcept
+		: x{ cos(theta) }, y{ sin(theta) }
+	{}
+
+	inline DirectionVector::DirectionVector(const Vector& v) noexcept
+		: x{ v.x / length(v) }, y{ v.y / length(v) }
+	{}
+
+	constexpr DirectionVector::DirectionVector(Float x, Float y) noexcept
+		: x{ x }, y{ y }
+	{}
+
+	constexpr DirectionVector::operator Vector()const noexcept {
+		return Vector(x, y);
+	}
+
+	constexpr DirectionVector DirectionVector::operator-()const noexcept {
+		return DirectionVector(-x, -y);
+	}
+
+	constexpr DirectionVector DirectionVector::perp()const noexcept {
+		return DirectionVector(-y, x);
+	}
+
+	constexpr Point DirectionVector::as_point()const noexcept {
+		return Point(x, y);
+	}
+
+	constexpr Float length(const DirectionVector&) noexcept {
+		return Float(1);
+	}
+
+
+	constexpr Matrix::Matrix(Float a, Float b, Float c, Float d) noexcept
+		: a{ a }, b{ b }, c{ c }, d{ d }
+	{}
+
+	constexpr Matrix::Matrix(const Vector& basis_x, const Vector& basis_y) noexcept
+		: Matrix(basis_x.x, basis_y.x,
+				 basis_x.y, basis_y.y)
+	{}
+
+	constexpr Matrix Matrix::id() noexcept {
+		return Matrix(
+			Float(1), Float(0),
+			Float(0), Float(1));
+	}
+	inline Matrix Matrix::clockwise_rotation(Float theta) noexcept {
+		return Matrix(
+			cos(theta), sin(theta),
+			-sin(theta), cos(theta));
+	}
+	inline Matrix Matrix::counterclockwise_rotation(Float theta) noexcept {
+		return Matrix(
+			cos(theta), -sin(theta),
+			sin(theta), cos(theta));
+	}
+
+	constexpr Matrix Matrix::stretching_x(Float k) noexcept {
+		return Matrix(
+			Float(k), Float(0),
+			Float(0), Float(1));
+	}
+
+	constexpr Matrix Matrix::stretching_y(Float k) noexcept {
+		return Matrix(
+			Float(1), Float(0),
+			Float(0), Float(k));
+	}
+
+	constexpr Matrix Matrix::scaling(Float k) noexcept {
+		return Matrix(
+			Float(k), Float(0),
+			Float(0), Float(k));
+	}
+
+	constexpr Matrix Matrix::shearing_x(Float k) noexcept {
+		return Matrix(
+			Float(1), Float(k),
+			Float(0), Float(1));
+	}
+
+	constexpr Matrix Matrix::shearing_y(Float k) noexcept {
+		return Matrix(
+			Float(1), Float(0),
+			Float(k), Float(1));
+	}
+
+	constexpr Matrix Matrix::reflection(const Vector& v) noexcept {
+		const Float d = Float(1) / dot(v, v);
+		return Matrix(
+			(v.x * v.x - v.y * v.y) * d, Float(2) * v.x * v.y * d,
+			Float(2) * v.x * v.y * d, (v.y * v.y - v.x * v.x) * d);
+	}
+
+	constexpr Matrix Matrix::orthogonal_projection(const Vector& u) noexcept {
+		const Float d = Float(1) / dot(u, u);
+		return Matrix(
+			u.x * u.x * d, u.x * u.y * d,
+			u.x * u.y * d, u.y * u.y * d);
+	}
+
+	constexpr Matrix Matrix::change_basis(const Vector& new_basis_1, const Vector& new_basis_2) noexcept {
+		return Matrix(new_basis_1, new_basis_2);
+	}
+	
+	constexpr Matrix Matrix::operator*(Float s)const noexcept {
+		return Matrix(a * s, b * s, c * s, d * s);
+	}
+
+	constexpr Matrix Matrix::operator/(Float s)const noexcept {
+		return Matrix(a / s, b / s, c / s, d / s);
+	}
+
+	constexpr Matrix Matrix::operator-()const noexcept {
+		return Matrix(-a, -b, -c, -d);
+	}
+
+	constexpr Vector Matrix::operator*(const Vector& v)const noexcept {
+		return Vector(v.x * a + v.y * b, v.x * c + v.y * d);
+	}
+
+	constexpr Matrix Matrix::operator*(const Matrix& m)const noexcept {
+		return Matrix(
+			m.a * a + m.c * b,
+			m.b * a + m.d * b,
+			m.a * c + m.c * d,
+			m.b * c + m.d * d);
+	}
+
+	constexpr Matrix Matrix::operator+(const Matrix& other)const noexcept {
+		return Matrix(a + other.a, b + other.b, c + other.c, d + other.d);
+	}
+
+	constexpr Matrix Matrix::operator-(const Matrix& other)const noexcept {
+		return Matrix(a - other.a, b - other.b, c - other.c, d - other.d);
+	}
+
+	constexpr Matrix Matrix::transpose()const noexcept {
+		return Matrix(a, c, b, d);
+	}
+
+	constexpr Float Matrix::det()const noexcept {
+		return a * d - b * c;
+	}
+
+	constexpr Matrix Matrix::adjugate() const noexcept {
+		return Matrix(d, -b, -c, a);
+	}
+
+
+	//Vector world_to_screen(Vector v, const Vector& screen_origin, const Vector& screen_basis_x, const Vector& screen_basis_y) {
+	//	return Matrix(screen_basis_x, screen_basis_y) * v + screen_origin;
+	//}
+
+	//Point change_basis(Point p, const Vector& new_basis_1, const Vector& new_basis_2) {
+	//	const auto M = Matrix::change_basis(new_basis_1, new_basis_2);
+	//	const Vector origin = M * Vector{};
+	//	return (M * (p - origin).as_vector()).as_point() + origin;
+	//}
+
+	constexpr Point orthogonal_projection(const Point beg, const Point end, const Point p) noexcept {
+		// dot / dot instead of the projection matrix, whose 1 / |v|^2 underflows a fixed point Float for long segments
+		const Vector v(beg, end);
+		return beg + v * (dot(Vector(beg, p), v) / dot(v, v));
+	}
+
+	constexpr Point reflection(const Point beg, const Point end, const Point p) noexcept {
+		const Vector v(beg, end);
+		return (Matrix::reflection(v) * (p - beg.as_vector()).as_vector() + beg.as_vector()).as_point();
+	}
+
+	constexpr Float distance2(const Point& beg, const Point& end, const Point& p) noexcept {
+		return distance2(orthogonal_projection(beg, end, p), p);
+	}
+
+	inline Float distance(const Point& beg, const Point& end, const Point& p) noexcept {
+		return sqrt(distance2(beg, end, p));
+	}
+
+	constexpr size_t Intersection::size()const noexcept {
+		return count;
+	}
+
+	constexpr bool Intersection::empty()const noexcept {
+		return count == 0;
+	}
+
+	constexpr const Point& Intersection::operator[](size_t i)const noexcept {
+		return points[i];
+	}
+
+	constexpr const Point* Intersection::begin()const noexcept {
+		return points;
+	}
+
+	constexpr const Point* Intersection::end()const noexcept {
+		return points + count;
+	}
+
+	constexpr void Intersection::push_back(const Point& p) noexcept {
+		points[count++] = p;
+	}
+
+	inline Intersection lines_intersection(const Point& beg_1, const Point& end_1, const Point& beg_2, const Point& end_2) noexcept {
+
+		const Vector direction_1(beg_1, end_1);
+		const Vector direction_2(beg_2, end_2);
+
+		const Float Det = det(direction_1, -direction_2);
+
+		const Float Det_1 = det(Vector(beg_1, beg_2), -direction_2);
+		const Float Det_2 = det(direction_1, Vector(beg_1, beg_2));
+
+		Intersection points{};
+
+
+		if (is_nearly_zero(Det)) {
+			if (is_nearly_zero(Det_1) or is_nearly_zero(Det_2)) {
+				points.push_back(beg_1);
+				points.push_back(beg_2);
+			}
+		}
+		else {
+			const Float t = Det_1 / Det;
+			points.push_back(beg_1 + t * direction_1);
+		}
+
+		return points;
+	}
+
+	inline Line::Line(const Point& p1, const Point& p2) noexcept
+		: point{ p1 }, direction(Vector(p1, p2))
+	{}
+
+	inline Line::Line(const Point& p, const Vector& v) noexcept
+		: point{ p }, direction(v)
+	{}
+
+	constexpr Point Line::operator()(Float t)const noexcept {
+		return point + direction * t;
+	}
+
+	constexpr Point Line::reflection(const Point& p)const noexcept {
+		return (point.as_vector() + Matrix::reflection(direction) * (p - point.as_vector()).as_vector()).as_point();
+	}
+
+	constexpr Point Line::projection(const Point& p)const noexcept {
+		return (point.as_vector() + Matrix::orthogonal_projection(direction) * (p - point.as_vector()).as_vector()).as_point();
+	}
+
+
+	constexpr Float Line::get_x_for_y(Float y)const noexcept {
+		return (*this)((y - point.y) / ((Vector)direction).y).x;
+	}
+
+	constexpr Float Line::get_y_for_x(Float x)const noexcept {
+		return (*this)((x - point.x) / ((Vector)direction).x).y;
+	}
+
+	inline bool Line::contains(const Point& p)const noexcept {
+		return is_nearly_zero(dot(Vector(point, p), direction));
+	}
+
+	inline Intersection lines_intersection(const Line& line_1, const Line& line_2) noexcept {
+		return lines_intersection(line_1.point, line_1(Float(1)), line_2.point, line_2(Float(1)));
+	}
+
+	constexpr LineSegment::LineSegment(const Point& p, const Point& q) noexcept
+		: beg{ p }, end{ q }
+	{}
+
+	inline Point LineSegment::closest_point(const Point& p)const noexcept {
+		// the projection clamped to the ends by its parameter, testing the projected point with contains instead
+		// rejected it whenever rounding moved it by more than the relative epsilon, and a coordinate of 0 always
+		const Vector v(beg, end);
+		const Float length_2 = dot(v, v);
+		if (length_2 <= Float(0))
+			return beg;
+		return beg + v * std::clamp(dot(Vector(beg, p), v) / length_2, Float(0), Float(1));
+	}
+
+	inline bool LineSegment::contains(const Point& p)const noexcept {
+		const auto proj = orthogonal_projection(beg, end, p);
+		return
+			are_nearly_equal(p.x, proj.x) and
+			are_nearly_equal(p.y, proj.y) and
+			distance2(p, beg) <= distance2(beg, end) and
+			distance2(p, end) <= distance2(beg, end);
+	}
+
+
+	inline Intersection line_segments_intersection(const LineSegment& seg_1, const LineSegment& seg_2) noexcept {
+		const Vector direction_1(seg_1.beg, seg_1.end);
+		const Vector direction_2(seg_2.beg, seg_2.end);
+
+		const Float Det = det(direction_1, -direction_2);
+
+		const Float Det_1 = det(Vector(seg_1.beg, seg_2.beg), -direction_2);
+		const Float Det_2 = det(direction_1, Vector(seg_1.beg, seg_2.beg));
+
+		Intersection points{};
+
+		if (is_nearly_zero(Det)) {
+			if (is_nearly_zero(Det_1) or is_nearly_zero(Det_2)) {
+				if (seg_1.contains(seg_2.beg) or seg_1.contains(seg_2.end) or seg_2.contains(seg_1.beg) or seg_2.contains(seg_1.end)) {
+					points.push_back(seg_1.beg);
+					points.push_back(seg_2.beg);
+				}
+			}
+		}
+		else {
+			// the cross point is seg_1.beg + t * direction_1 = seg_2.beg + u * direction_2, on both segments when t and u are in [0, 1]
+			const Float t = Det_1 / Det;
+			const Float u = Det_2 / Det;
+			if (t >= Float(0) and t <= Float(1) and u >= Float(0) and u <= Float(1))
+				points.push_back(seg_1.beg + t * direction_1);
+		}
+
+		return points;
+	}
+
+	constexpr Circle::Circle(Point center, Float r) noexcept
+		: center{ center }, radius{ r }
+	{}
+
+	constexpr bool Circle::contains(const Point& p)const noexcept {
+		return distance2(center, p) <= radius * radius;
+	}
+
+	constexpr Stadium::Stadium(const Point& beg, const Point& end, Float radius) noexcept
+		: beg{ beg }, end{ end }, radius{ radius }
+	{}
+
+	inline bool Stadium::contains(const Point& p)const noexcept {
+		return closest_circle(p).contains(p);
+	}
+
+	inline Circle Stadium::closest_circle(const Point& p)const noexcept {
+		return Circle(LineSegment(beg, end).closest_point(p), radius);
+	}
+
+	inline Vector Stadium::normal()const noexcept {
+		return Vector(beg, end).normalize().perp();
+	}
+
+	inline std::optional<Float> time_of_impact(const Point& center, const Vector& motion, const Circle& target) noexcept {
+		// smallest root of |center + t * motion - target.center|^2 = radius^2
+		const Vector f(target.center, center);
+		const Float c = dot(f, f) - target.radius * target.radius;
+		const Float b = dot(f, motion);
+		if (b >= Float(0))
+			return std::nullopt;
+		// a path starting inside, like the contact band a cut back ball is left in, must not carry on through
+		if (c <= Float(0))
+			return Float(0);
+
+		const Float a = dot(motion, motion);
+		const Float discriminant = b * b - a * c;
+		if (discriminant < Float(0))
+			return std::nullopt;
+
+		const Float t = (-b - sqrt(discriminant)) / a;
+		if (t > Float(1))
+			return std::nullopt;
+		return std::max(t, Float(0));
+	}
+
+	inline std::optional<Float> time_of_impact(const Circle& circle, const Vector& motion, const Circle& other, const Vector& other_motion) noexcept {
+		// in the frame of the other circle only the relative motion is left
+		return time_of_impact(circle.center, motion - other_motion, Circle(other.center, circle.radius + other.radius));
+	}
+
+	inline std::optional<Float> time_of_impact(const Circle& circle, const Vector& motion, const Stadium& stadium) noexcept {
+		// the center against the stadium grown by the circle radius: two end circles and the two flat sides between them
+		const Float r = stadium.radius + circle.radius;
+		const LineSegment core(stadium.beg, stadium.end);
+		const Vector offset(core.closest_point(circle.center), circle.center);
+		if (length2(offset) <= r * r) {
+			// starting inside, it stops at once when heading toward the core, from an end circle or a flat side alike,
+			// a center right on the core has no way out that is not through the wall
+			const Float b = dot(offset, motion);
+			return b < Float(0) or (is_nearly_zero(length2(offset)) and length2(motion) > Float(0)) ? std::optional<Float>(Float(0)) : std::nullopt;
+		}
+
+		auto toi = time_of_impact(circle.center, motion, Circle(stadium.beg, r));
+		if (const auto t = time_of_impact(circle.center, motion, Circle(stadium.end, r)); t and (not toi or *t < *toi))
+			toi = t;
+
+		const Vector along(stadium.beg, stadium.end);
+		if (is_nearly_zero(length2(along)))
+			return toi;
+
+		// signed distances of the start and the end of the path from the core line
+		const Vector normal = stadium.normal();
+		const Float d0 = dot(Vector(stadium.beg, circle.center), normal);
+		const Float d1 = d0 + dot(motion, normal);
+		const Float side = d0 > Float(0) ? r : -r;
+		if (fabs(d0) > r and (d0 > Float(0) ? d1 <= side : d1 >= side)) {
+			const Float t = (d0 - side) / (d0 - d1);
+			const Point hit = circle.center + motion * t;
+			const Float s = dot(Vector(stadium.beg, hit), along);
+			if (s >= Float(0) and s <= dot(along, along) and (not toi or t < *toi))
+				toi = t;
+		}
+		else if (fabs(d0) <= r and fabs(d1) < fabs(d0)) {
+			// in the band of a flat side by this measure though just outside by the closest point one, heading in
+			const Float s = dot(Vector(stadium.beg, circle.center), along);
+			if (s >= Float(0) and s <= dot(along, along))
+				toi = Float(0);
+		}
+		return toi;
+	}
+
+	// the constexpr part of the layer can run at compile time
+	static_assert(distance2(orthogonal_projection(Point(Float(0), Float(0)), Point(Float(4), Float(0)), Point(Float(1), Float(3))), Point(Float(1), Float(0))) == Float(0));
+	static_assert((Matrix::reflection(Vector(Float(1), Float(0))) * Vector(Float(2), Float(3))).y == Float(-3));
 }
\ No newline at end of file
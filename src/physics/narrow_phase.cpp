@@ -0,0 +1,318 @@
+#include "narrow_phase.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+// the vector kernels only exist for float on x86-64, they are compiled for their instruction set whatever the flags
+// of the build and only called on a CPU that has it
+#if defined(PHS_SCALAR_FLOAT) && (defined(__x86_64__) || defined(_M_X64))
+#define PHS_X86_KERNELS
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define PHS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PHS_TARGET(isa)
+#endif
+#endif
+
+namespace phs
+{
+	static const Float grow = Float(1) + Float(1.0 / 1024.0);
+
+	// pairs [begin, end), one at a time
+	static size_t keep_scalar(const BallStorage& balls, const Pair* pairs, size_t begin, size_t end, std::uint32_t* kept) {
+		size_t n = 0;
+		for (size_t k = begin; k < end; ++k) {
+			const auto [i, j] = pairs[k];
+			const Float dx = balls.x[j] - balls.x[i];
+			const Float dy = balls.y[j] - balls.y[i];
+			const Float r = (balls.radius[i] + balls.radius[j]) * grow;
+			// written unconditionally and counted only when kept, so there is no branch to mispredict
+			kept[n] = std::uint32_t(k);
+			n += dx * dx + dy * dy > r * r ? 0 : 1;
+		}
+		return n;
+	}
+
+	// a wall as the kernels see it, the ball centers are taken relative to its first end
+	struct WallTest
+	{
+		Float ax, ay, vx, vy;
+		// squared length, 1 for a wall that is a single point, where every projection is 0 anyway
+		Float length2;
+		Float radius;
+		Float slack;
+
+		explicit WallTest(const Wall& wall)
+			: ax{ wall.beg.x }, ay{ wall.beg.y }, vx{ wall.end.x - wall.beg.x }, vy{ wall.end.y - wall.beg.y },
+			length2{}, radius{ wall.radius }, slack{}
+		{
+			const Float l2 = vx * vx + vy * vy;
+			length2 = l2 > Float(0) ? l2 : Float(1);
+			slack = (fabs(wall.beg.x) + fabs(wall.beg.y) + fabs(wall.end.x) + fabs(wall.end.y)) * Float(1.0 / 65536.0);
+		}
+	};
+
+	// balls begin + k for k in [first, count), one at a time
+	static size_t keep_near_wall_scalar(const WallTest& w, const BallStorage& balls, size_t begin, size_t first, size_t count, std::uint32_t* kept) {
+		size_t n = 0;
+		for (size_t k = first; k < count; ++k) {
+			const size_t i = begin + k;
+			const Float fx = balls.x[i] - w.ax;
+			const Float fy = balls.y[i] - w.ay;
+			const Float t = std::clamp((fx * w.vx + fy * w.vy) / w.length2, Float(0), Float(1));
+			const Float dx = fx - t * w.vx;
+			const Float dy = fy - t * w.vy;
+			const Float r = (w.radius + balls.radius[i]) * grow + w.slack;
+			kept[n] = std::uint32_t(k);
+			n += dx * dx + dy * dy > r * r ? 0 : 1;
+		}
+		return n;
+	}
+
+#if defined(PHS_X86_KERNELS)
+	// every kernel clears the upper halves of the vector registers before the scalar loop takes the rest, the compiler
+	// leaves them dirty across the call and legacy SSE code after them pays for the transition on every block
+	//
+	// a pair is two 64 bit indices, read as four 32 bit halves of which the low ones are the index
+	static_assert(sizeof(Pair) == 16);
+
+	PHS_TARGET("avx2")
+	static size_t keep_avx2(const BallStorage& balls, const Pair* pairs, size_t count, std::uint32_t* kept) {
+		const float* const x = balls.x.data();
+		const float* const y = balls.y.data();
+		const float* const radius = balls.radius.data();
+		const __m256 grow8 = _mm256_set1_ps(grow);
+		// the shuffles below leave the pairs in the order 0 2 4 6 1 3 5 7, this puts them back
+		const __m256i unshuffle = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+		size_t n = 0, k = 0;
+		for (; k + 8 <= count; k += 8) {
+			const float* const p = reinterpret_cast<const float*>(pairs + k);
+			const __m256 p01 = _mm256_loadu_ps(p), p23 = _mm256_loadu_ps(p + 8), p45 = _mm256_loadu_ps(p + 16), p67 = _mm256_loadu_ps(p + 24);
+			// i0 j0 i2 j2 | i1 j1 i3 j3, then i0 i2 i4 i6 | i1 i3 i5 i7
+			const __m256 s0 = _mm256_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0));
+			const __m256 s1 = _mm256_shuffle_ps(p45, p67, _MM_SHUFFLE(2, 0, 2, 0));
+			const __m256i vi = _mm256_permutevar8x32_epi32(_mm256_castps_si256(_mm256_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0))), unshuffle);
+			const __m256i vj = _mm256_permutevar8x32_epi32(_mm256_castps_si256(_mm256_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1))), unshuffle);
+
+			const __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(x, vj, 4), _mm256_i32gather_ps(x, vi, 4));
+			const __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(y, vj, 4), _mm256_i32gather_ps(y, vi, 4));
+			const __m256 r = _mm256_mul_ps(_mm256_add_ps(_mm256_i32gather_ps(radius, vi, 4), _mm256_i32gather_ps(radius, vj, 4)), grow8);
+			const __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+			// not greater rather than less or equal, so a NaN is kept like the scalar test keeps it
+			auto mask = unsigned(_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(r, r), _CMP_NGT_UQ)));
+			for (size_t l = 0; l < 8; ++l) {
+				kept[n] = std::uint32_t(k + l);
+				n += (mask >> l) & 1;
+			}
+		}
+		_mm256_zeroupper();
+		return n + keep_scalar(balls, pairs, k, count, kept + n);
+	}
+
+	PHS_TARGET("avx512f")
+	static size_t keep_avx512(const BallStorage& balls, const Pair* pairs, size_t count, std::uint32_t* kept) {
+		const float* const x = balls.x.data();
+		const float* const y = balls.y.data();
+		const float* const radius = balls.radius.data();
+		const __m512 grow16 = _mm512_set1_ps(grow);
+		// the low halves of 8 pairs from two registers, the first indices then the second ones
+		const __m512i split = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 2, 6, 10, 14, 18, 22, 26, 30);
+		const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+		size_t n = 0, k = 0;
+		for (; k + 16 <= count; k += 16) {
+			const auto* const p = reinterpret_cast<const std::int32_t*>(pairs + k);
+			const __m512i lo = _mm512_permutex2var_epi32(_mm512_loadu_si512(p), split, _mm512_loadu_si512(p + 16));
+			const __m512i hi = _mm512_permutex2var_epi32(_mm512_loadu_si512(p + 32), split, _mm512_loadu_si512(p + 48));
+			const __m512i vi = _mm512_shuffle_i64x2(lo, hi, _MM_SHUFFLE(1, 0, 1, 0));
+			const __m512i vj = _mm512_shuffle_i64x2(lo, hi, _MM_SHUFFLE(3, 2, 3, 2));
+
+			const __m512 dx = _mm512_sub_ps(_mm512_i32gather_ps(vj, x, 4), _mm512_i32gather_ps(vi, x, 4));
+			const __m512 dy = _mm512_sub_ps(_mm512_i32gather_ps(vj, y, 4), _mm512_i32gather_ps(vi, y, 4));
+			const __m512 r = _mm512_mul_ps(_mm512_add_ps(_mm512_i32gather_ps(vi, radius, 4), _mm512_i32gather_ps(vj, radius, 4)), grow16);
+			const __m512 d2 = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+			const __mmask16 mask = _mm512_cmp_ps_mask(d2, _mm512_mul_ps(r, r), _CMP_NGT_UQ);
+			_mm512_mask_compressstoreu_epi32(kept + n, mask, _mm512_add_epi32(lanes, _mm512_set1_epi32(int(k))));
+			n += size_t(std::popcount(unsigned(mask)));
+		}
+		_mm256_zeroupper();
+		return n + keep_scalar(balls, pairs, k, count, kept + n);
+	}
+
+	PHS_TARGET("avx2")
+	static size_t keep_near_wall_avx2(const WallTest& w, const BallStorage& balls, size_t begin, size_t count, std::uint32_t* kept) {
+		const float* const x = balls.x.data() + begin;
+		const float* const y = balls.y.data() + begin;
+		const float* const radius = balls.radius.data() + begin;
+		const __m256 ax = _mm256_set1_ps(w.ax), ay = _mm256_set1_ps(w.ay), vx = _mm256_set1_ps(w.vx), vy = _mm256_set1_ps(w.vy);
+		const __m256 length2 = _mm256_set1_ps(w.length2), wall_radius = _mm256_set1_ps(w.radius), slack = _mm256_set1_ps(w.slack);
+		const __m256 grow8 = _mm256_set1_ps(grow), zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+
+		size_t n = 0, k = 0;
+		for (; k + 8 <= count; k += 8) {
+			const __m256 fx = _mm256_sub_ps(_mm256_loadu_ps(x + k), ax);
+			const __m256 fy = _mm256_sub_ps(_mm256_loadu_ps(y + k), ay);
+			const __m256 dot = _mm256_add_ps(_mm256_mul_ps(fx, vx), _mm256_mul_ps(fy, vy));
+			const __m256 t = _mm256_min_ps(_mm256_max_ps(_mm256_div_ps(dot, length2), zero), one);
+			const __m256 dx = _mm256_sub_ps(fx, _mm256_mul_ps(t, vx));
+			const __m256 dy = _mm256_sub_ps(fy, _mm256_mul_ps(t, vy));
+			const __m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(wall_radius, _mm256_loadu_ps(radius + k)), grow8), slack);
+			const __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+			auto mask = unsigned(_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(r, r), _CMP_NGT_UQ)));
+			for (size_t l = 0; l < 8; ++l) {
+				kept[n] = std::uint32_t(k + l);
+				n += (mask >> l) & 1;
+			}
+		}
+		_mm256_zeroupper();
+		return n + keep_near_wall_scalar(w, balls, begin, k, count, kept + n);
+	}
+
+	PHS_TARGET("avx512f")
+	static size_t keep_near_wall_avx512(const WallTest& w, const BallStorage& balls, size_t begin, size_t count, std::uint32_t* kept) {
+		const float* const x = balls.x.data() + begin;
+		const float* const y = balls.y.data() + begin;
+		const float* const radius = balls.radius.data() + begin;
+		const __m512 ax = _mm512_set1_ps(w.ax), ay = _mm512_set1_ps(w.ay), vx = _mm512_set1_ps(w.vx), vy = _mm512_set1_ps(w.vy);
+		const __m512 length2 = _mm512_set1_ps(w.length2), wall_radius = _mm512_set1_ps(w.radius), slack = _mm512_set1_ps(w.slack);
+		const __m512 grow16 = _mm512_set1_ps(grow), zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.f);
+		const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+		size_t n = 0, k = 0;
+		for (; k + 16 <= count; k += 16) {
+			const __m512 fx = _mm512_sub_ps(_mm512_loadu_ps(x + k), ax);
+			const __m512 fy = _mm512_sub_ps(_mm512_loadu_ps(y + k), ay);
+			const __m512 dot = _mm512_add_ps(_mm512_mul_ps(fx, vx), _mm512_mul_ps(fy, vy));
+			const __m512 t = _mm512_min_ps(_mm512_max_ps(_mm512_div_ps(dot, length2), zero), one);
+			const __m512 dx = _mm512_sub_ps(fx, _mm512_mul_ps(t, vx));
+			const __m512 dy = _mm512_sub_ps(fy, _mm512_mul_ps(t, vy));
+			const __m512 r = _mm512_add_ps(_mm512_mul_ps(_mm512_add_ps(wall_radius, _mm512_loadu_ps(radius + k)), grow16), slack);
+			const __m512 d2 = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+			const __mmask16 mask = _mm512_cmp_ps_mask(d2, _mm512_mul_ps(r, r), _CMP_NGT_UQ);
+			_mm512_mask_compressstoreu_epi32(kept + n, mask, _mm512_add_epi32(lanes, _mm512_set1_epi32(int(k))));
+			n += size_t(std::popcount(unsigned(mask)));
+		}
+		_mm256_zeroupper();
+		return n + keep_near_wall_scalar(w, balls, begin, k, count, kept + n);
+	}
+
+	static SimdLevel detect_simd_level() {
+#if defined(_MSC_VER)
+		int info[4]{};
+		__cpuid(info, 0);
+		const int max_leaf = info[0];
+		__cpuid(info, 1);
+		// the OS has to save the wide registers as well, which XCR0 tells
+		if (max_leaf < 7 or (info[2] & (1 << 27)) == 0)
+			return SimdLevel::scalar;
+		const unsigned long long xcr0 = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+		if ((xcr0 & 0xe6) == 0xe6 and (info[1] & (1 << 16)) != 0)
+			return SimdLevel::avx512;
+		if ((xcr0 & 0x6) == 0x6 and (info[1] & (1 << 5)) != 0)
+			return SimdLevel::avx2;
+		return SimdLevel::scalar;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+			return SimdLevel::avx512;
+		if (__builtin_cpu_supports("avx2"))
+			return SimdLevel::avx2;
+		return SimdLevel::scalar;
+#endif
+	}
+#else
+	static SimdLevel detect_simd_level() {
+		return SimdLevel::scalar;
+	}
+#endif
+
+	const char* simd_level_name(SimdLevel level) {
+		switch (level) {
+		case SimdLevel::scalar: return "scalar";
+		case SimdLevel::avx2: return "avx2";
+		case SimdLevel::avx512: return "avx512";
+		default: return "unknown";
+		}
+	}
+
+	SimdLevel supported_simd_level() {
+		static const SimdLevel level = detect_simd_level();
+		return level;
+	}
+
+	size_t keep_overlapping_pairs(const BallStorage& balls, const Pair* pairs, size_t count, std::uint32_t* kept) {
+		return keep_overlapping_pairs(balls, pairs, count, kept, supported_simd_level());
+	}
+
+	size_t keep_overlapping_pairs(const BallStorage& balls, const Pair* pairs, size_t count, std::uint32_t* kept, SimdLevel level) {
+		if (level > supported_simd_level())
+			throw std::invalid_argument(std::string("the ") + simd_level_name(level) + " narrow phase is not supported here");
+		switch (level) {
+#if defined(PHS_X86_KERNELS)
+		case SimdLevel::avx512: return keep_avx512(balls, pairs, count, kept);
+		case SimdLevel::avx2: return keep_avx2(balls, pairs, count, kept);
+#endif
+		default: return keep_scalar(balls, pairs, 0, count, kept);
+		}
+	}
+
+	size_t keep_balls_near_wall(const Wall& wall, const BallStorage& balls, size_t begin, size_t count, std::uint32_t* kept) {
+		return keep_balls_near_wall(wall, balls, begin, count, kept, supported_simd_level());
+	}
+
+	size_t keep_balls_near_wall(const Wall& wall, const BallStorage& balls, size_t begin, size_t count, std::uint32_t* kept, SimdLevel level) {
+		if (level > supported_simd_level())
+			throw std::invalid_argument(std::string("the ") + simd_level_name(level) + " narrow phase is not supported here");
+		const WallTest w(wall);
+		switch (level) {
+#if defined(PHS_X86_KERNELS)
+		case SimdLevel::avx512: return keep_near_wall_avx512(w, balls, begin, count, kept);
+		case SimdLevel::avx2: return keep_near_wall_avx2(w, balls, begin, count, kept);
+#endif
+		default: return keep_near_wall_scalar(w, balls, begin, 0, count, kept);
+		}
+	}
+
+	void mark_balls_near_walls(const std::vector<Wall>& walls, const WallTree& wall_tree, const BallStorage& balls, size_t begin, size_t count, std::uint8_t* near) {
+		std::fill(near, near + count, std::uint8_t(0));
+		if (walls.empty() or count == 0)
+			return;
+
+		Float min_x = balls.x[begin] - balls.radius[begin], max_x = balls.x[begin] + balls.radius[begin];
+		Float min_y = balls.y[begin] - balls.radius[begin], max_y = balls.y[begin] + balls.radius[begin];
+		for (size_t i = begin + 1; i < begin + count; ++i) {
+			min_x = std::min(min_x, balls.x[i] - balls.radius[i]);
+			max_x = std::max(max_x, balls.x[i] + balls.radius[i]);
+			min_y = std::min(min_y, balls.y[i] - balls.radius[i]);
+			max_y = std::max(max_y, balls.y[i] + balls.radius[i]);
+		}
+
+		std::uint32_t block_walls[max_block_walls];
+		size_t wall_count = 0;
+		bool crowded = false;
+		wall_tree.query(min_x, min_y, max_x, max_y, [&](size_t j) {
+			if (wall_count < max_block_walls)
+				block_walls[wall_count++] = std::uint32_t(j);
+			else
+				crowded = true;
+		});
+		if (crowded) {
+			std::fill(near, near + count, std::uint8_t(1));
+			return;
+		}
+
+		std::uint32_t kept[ball_block];
+		for (size_t w = 0; w < wall_count; ++w) {
+			const size_t kept_count = keep_balls_near_wall(walls[block_walls[w]], balls, begin, count, kept);
+			for (size_t s = 0; s < kept_count; ++s)
+				near[kept[s]] = 1;
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "ball_storage.h"
+#include "broad_phase.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace phs
+{
+	// instruction sets of the batched narrow phase kernels, picked at run time
+	enum class SimdLevel : std::uint8_t
+	{
+		scalar,
+		avx2,
+		avx512
+	};
+
+	const char* simd_level_name(SimdLevel level);
+	// the widest level this CPU runs and this build has kernels for, only the float build on x86-64 has vector kernels
+	SimdLevel supported_simd_level();
+
+	// pairs a caller filters at a time, so the kept positions fit on the stack and a block is resolved while its balls
+	// are still in cache
+	inline constexpr size_t pair_block = 64;
+
+	// batched rejection of candidate pairs, most candidates of a grid are apart and never need a square root
+	//
+	// writes the positions k in [0, count) of the pairs whose circles may overlap to kept, in order, and returns how many
+	// the centers and radii of 8 (AVX2) or 16 (AVX-512) pairs at a time are gathered and compared as squared distances,
+	// with the radius sum grown by 1 / 1024, so rounding never leaves out a pair resolve_static_collision would resolve,
+	// the kept pairs still go through the exact test
+	// the ball indices have to fit in 31 bits
+	size_t keep_overlapping_pairs(const BallStorage& balls, const Pair* pairs, size_t count, std::uint32_t* kept);
+	// the same with the kernel of `level`, throws std::invalid_argument when it is not supported
+	size_t keep_overlapping_pairs(const BallStorage& balls, const Pair* pairs, size_t count, std::uint32_t* kept, SimdLevel level);
+
+	// balls tested against the walls at a time, the flags of a block fit on the stack
+	inline constexpr size_t ball_block = 64;
+	// walls a block is tested against at most, a block spanning more leaves them to the queries of its balls
+	inline constexpr size_t max_block_walls = 16;
+
+	// batched wall test, one wall against the consecutive balls [begin, begin + count) of the arrays
+	//
+	// writes the positions k in [0, count) of the balls whose circles may overlap the stadium to kept, in order, and
+	// returns how many
+	// 8 (AVX2) or 16 (AVX-512) centers at a time are projected on the wall, the projection clamped to its ends, and
+	// compared by squared distance with the same margin as the pairs plus a share of the wall coordinates, which covers
+	// the rounding of the projection along long walls, the kept balls still go through the exact test
+	// sleeping balls are tested like the others
+	size_t keep_balls_near_wall(const Wall& wall, const BallStorage& balls, size_t begin, size_t count, std::uint32_t* kept);
+	// the same with the kernel of `level`, throws std::invalid_argument when it is not supported
+	size_t keep_balls_near_wall(const Wall& wall, const BallStorage& balls, size_t begin, size_t count, std::uint32_t* kept, SimdLevel level);
+
+	// sets near[k] to 1 for the balls begin + k that may overlap a wall and to 0 for the others, count is at most
+	// ball_block
+	// the tree is queried once with the box of the whole block and keep_balls_near_wall run for each wall it returns,
+	// a block that spans more than max_block_walls walls gets every flag set
+	void mark_balls_near_walls(const std::vector<Wall>& walls, const WallTree& wall_tree, const BallStorage& balls, size_t begin, size_t count, std::uint8_t* near);
+}
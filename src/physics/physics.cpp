@@ -16,7 +16,8 @@ namespace phs
 		if (dist > wall.radius + ball.radius)
 			return false;
 
-		const Vector displacement = Vector(closest_cirlce.center, ball.center) / dist;
+		// a center right on the wall or on the other center has no direction to push in, any one will do
+		const Vector displacement = dist > Float(0) ? Vector(closest_cirlce.center, ball.center) / dist : wall.normal();
 		const Float diff = wall.radius + ball.radius - dist;
 		ball.center += displacement * diff;
 		return true;
@@ -26,7 +27,7 @@ namespace phs
 		const Float dist = distance(ball_1.center, ball_2.center);
 		if (dist > ball_1.radius + ball_2.radius)
 			return false;
-		const Vector displacement = Vector(ball_1.center, ball_2.center) / dist;
+		const Vector displacement = dist > Float(0) ? Vector(ball_1.center, ball_2.center) / dist : Vector(Float(1), Float(0));
 		const Float diff = ball_1.radius + ball_2.radius - dist;
 		const Float mass_ratio = ball_1.mass / (ball_1.mass + ball_2.mass);
 
@@ -37,7 +38,11 @@ namespace phs
 	}
 
 	void resolve_dynamic_collision(Ball& ball_1, Ball& ball_2) {
-		const auto n = Vector(ball_1.center, ball_2.center).normalize();// normalized displacement vector
+		const Vector displacement(ball_1.center, ball_2.center);
+		if (displacement.x == Float(0) and displacement.y == Float(0))
+			return; // no line between the centers to exchange momentum along
+
+		const auto n = displacement.normalize();// normalized displacement vector
 		const auto t = n.perp(); // perpendicular to displacement vector
 
 		const Float v1n = dot(n, ball_1.velocity);
@@ -46,7 +51,7 @@ namespace phs
 		const Float v2n = dot(n, ball_2.velocity);
 		const Float v2t = dot(t, ball_2.velocity);
 
-		const Float rf = 1.f;
+		const Float rf = Float(1);
 
 		const Float v1np = (ball_1.mass * v1n + ball_2.mass * v2n + ball_2.mass * rf * (v2n - v1n)) / (ball_1.mass + ball_2.mass);
 		const Float v2np = (ball_1.mass * v1n + ball_2.mass * v2n + ball_1.mass * rf * (v1n - v2n)) / (ball_1.mass + ball_2.mass);
@@ -56,7 +61,7 @@ namespace phs
 	}
 
 	void resolve_dynamic_collision(Wall& wall, Ball& ball) {
-		auto ball_wall = Ball(wall.closest_circle(ball.center).center, wall.radius, 10000.f);
+		auto ball_wall = Ball(wall.closest_circle(ball.center).center, wall.radius, Float(10000));
 		resolve_dynamic_collision(ball_wall, ball);
 	}
 
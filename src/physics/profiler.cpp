@@ -0,0 +1,194 @@
+#include "profiler.h"
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace phs
+{
+	const char* stage_name(Stage stage) {
+		switch (stage) {
+		case Stage::step: return "step";
+		case Stage::reorder: return "reorder";
+		case Stage::integrate: return "integrate";
+		case Stage::sweep: return "sweep";
+		case Stage::broad_phase: return "broad_phase";
+		case Stage::narrow_phase: return "narrow_phase";
+		case Stage::resolution: return "resolution";
+		case Stage::sleep: return "sleep";
+		case Stage::render: return "render";
+		default: return "unknown";
+		}
+	}
+
+	const char* counter_name(Counter counter) {
+		switch (counter) {
+		case Counter::balls: return "balls";
+		case Counter::sleeping_balls: return "sleeping_balls";
+		case Counter::candidate_pairs: return "candidate_pairs";
+		case Counter::ball_ball_cols: return "ball_ball_cols";
+		case Counter::ball_wall_cols: return "ball_wall_cols";
+		default: return "unknown";
+		}
+	}
+
+	void StageHistogram::add(std::uint64_t ns) {
+		const size_t bucket = ns == 0 ? 0 : std::min<size_t>(size_t(std::bit_width(ns)) - 1, bucket_count - 1);
+		++buckets[bucket];
+		++frames;
+		total_ns += ns;
+		max_ns = std::max(max_ns, ns);
+	}
+
+	double StageHistogram::mean_ms()const {
+		return frames > 0 ? 1e-6 * double(total_ns) / double(frames) : 0.0;
+	}
+
+	double StageHistogram::percentile_ms(double p)const {
+		if (frames == 0)
+			return 0.0;
+		const std::uint64_t rank = std::min(frames - 1, std::uint64_t(std::clamp(p, 0.0, 1.0) * double(frames)));
+		std::uint64_t seen = 0;
+		for (size_t k = 0; k < bucket_count; ++k) {
+			if (seen + buckets[k] > rank) {
+				// spread the frames of the bucket evenly over its range
+				const double low = k == 0 ? 0.0 : double(std::uint64_t(1) << k);
+				const double width = k == 0 ? 2.0 : low;
+				const double share = (double(rank - seen) + 0.5) / double(buckets[k]);
+				return 1e-6 * std::min(low + share * width, double(max_ns));
+			}
+			seen += buckets[k];
+		}
+		return 1e-6 * double(max_ns);
+	}
+
+	Profiler::Profiler(size_t max_events, size_t max_frames)
+		: max_events{ max_events }, max_frames{ max_frames }, start{ clock::now() }
+	{}
+
+	std::uint64_t Profiler::since_start(clock::time_point t)const {
+		return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t - start).count());
+	}
+
+	void Profiler::record(Stage stage, clock::time_point beg, clock::time_point end) {
+		const std::uint64_t ns = std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg).count());
+		current.stage_ns[size_t(stage)] += ns;
+		current.ran |= std::uint32_t(1) << size_t(stage);
+		if (events.size() < max_events)
+			events.push_back(Event{ since_start(beg), ns, stage });
+	}
+
+	void Profiler::set(Counter counter, std::uint64_t value) {
+		current.counters[size_t(counter)] = value;
+	}
+
+	void Profiler::end_frame() {
+		current.end_ns = since_start(clock::now());
+		for (size_t s = 0; s < stage_count; ++s)
+			if (current.ran & (std::uint32_t(1) << s))
+				histograms[s].add(current.stage_ns[s]);
+		if (rows.size() < max_frames)
+			rows.push_back(current);
+		last = current;
+		current = Frame{};
+		++frames;
+	}
+
+	std::uint64_t Profiler::frame_count()const {
+		return frames;
+	}
+
+	const StageHistogram& Profiler::histogram(Stage stage)const {
+		return histograms[size_t(stage)];
+	}
+
+	std::uint64_t Profiler::last_frame_ns(Stage stage)const {
+		return last.stage_ns[size_t(stage)];
+	}
+
+	std::uint64_t Profiler::last_frame_counter(Counter counter)const {
+		return last.counters[size_t(counter)];
+	}
+
+	void Profiler::write_chrome_trace(const std::filesystem::path& path)const {
+		std::ofstream file(path, std::ios::binary);
+		if (not file)
+			throw std::runtime_error("cannot create " + path.string());
+
+		// timestamps are in microseconds, with the nanoseconds as fractions
+		const std::string tid = std::to_string(thread_id);
+		char number[64];
+		const auto micros = [&number](std::uint64_t ns) {
+			std::snprintf(number, sizeof(number), "%" PRIu64 ".%03" PRIu64, ns / 1000, ns % 1000);
+			return std::string(number);
+		};
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		for (const Event& e : events) {
+			file << (first ? "" : ",\n") << "{\"name\":\"" << stage_name(e.stage) << "\",\"cat\":\"physics\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+				<< ",\"ts\":" << micros(e.beg_ns) << ",\"dur\":" << micros(e.duration_ns) << "}";
+			first = false;
+		}
+		for (const Frame& frame : rows) {
+			file << (first ? "" : ",\n") << "{\"name\":\"contacts\",\"ph\":\"C\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << micros(frame.end_ns) << ",\"args\":{";
+			for (size_t c = 0; c < counter_count; ++c)
+				file << (c > 0 ? "," : "") << "\"" << counter_name(Counter(c)) << "\":" << frame.counters[c];
+			file << "}}";
+			first = false;
+		}
+		file << "\n]}\n";
+		if (not file)
+			throw std::runtime_error("cannot write " + path.string());
+	}
+
+	void Profiler::write_csv(const std::filesystem::path& path)const {
+		std::ofstream file(path, std::ios::binary);
+		if (not file)
+			throw std::runtime_error("cannot create " + path.string());
+
+		file << "frame,end_us";
+		for (size_t s = 0; s < stage_count; ++s)
+			file << "," << stage_name(Stage(s)) << "_us";
+		for (size_t c = 0; c < counter_count; ++c)
+			file << "," << counter_name(Counter(c));
+		file << "\n";
+
+		char number[32];
+		for (size_t f = 0; f < rows.size(); ++f) {
+			file << f << "," << rows[f].end_ns / 1000;
+			for (size_t s = 0; s < stage_count; ++s) {
+				std::snprintf(number, sizeof(number), ",%.3f", 1e-3 * double(rows[f].stage_ns[s]));
+				file << number;
+			}
+			for (size_t c = 0; c < counter_count; ++c)
+				file << "," << rows[f].counters[c];
+			file << "\n";
+		}
+		if (not file)
+			throw std::runtime_error("cannot write " + path.string());
+	}
+
+	void Profiler::write_summary(std::FILE* out)const {
+		std::fprintf(out, "%-14s %8s %10s %10s %10s %10s\n", "stage", "frames", "mean ms", "p50 ms", "p99 ms", "max ms");
+		for (size_t s = 0; s < stage_count; ++s) {
+			const StageHistogram& h = histograms[s];
+			if (h.frames == 0)
+				continue;
+			std::fprintf(out, "%-14s %8" PRIu64 " %10.3f %10.3f %10.3f %10.3f\n", stage_name(Stage(s)), h.frames,
+				h.mean_ms(), h.percentile_ms(0.5), h.percentile_ms(0.99), 1e-6 * double(h.max_ns));
+		}
+	}
+
+	void Profiler::reset() {
+		start = clock::now();
+		current = Frame{};
+		last = Frame{};
+		frames = 0;
+		histograms = {};
+		events.clear();
+		rows.clear();
+	}
+}
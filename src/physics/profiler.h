@@ -0,0 +1,163 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace phs
+{
+	// the stages of a step timed by the profiler, render is timed by the caller around its drawing
+	enum class Stage : std::uint8_t
+	{
+		step,
+		reorder,
+		integrate,
+		sweep,
+		broad_phase,
+		narrow_phase,
+		resolution,
+		sleep,
+		render,
+		count
+	};
+
+	enum class Counter : std::uint8_t
+	{
+		balls,
+		sleeping_balls,
+		candidate_pairs,
+		ball_ball_cols,
+		ball_wall_cols,
+		count
+	};
+
+	inline constexpr size_t stage_count = size_t(Stage::count);
+	inline constexpr size_t counter_count = size_t(Counter::count);
+
+	const char* stage_name(Stage stage);
+	const char* counter_name(Counter counter);
+
+	// time spent per frame in one stage, in power of two buckets of nanoseconds, bucket k holds [2^k, 2^(k+1))
+	struct StageHistogram
+	{
+		static constexpr size_t bucket_count = 40;
+
+		std::array<std::uint64_t, bucket_count> buckets{};
+		// frames the stage ran in, a stage that did not run in a frame is not counted
+		std::uint64_t frames = 0;
+		std::uint64_t total_ns = 0;
+		std::uint64_t max_ns = 0;
+
+		void add(std::uint64_t ns);
+		double mean_ms()const;
+		// the p quantile, p in [0, 1], interpolated inside its bucket, so off by less than a factor of two
+		double percentile_ms(double p)const;
+	};
+
+	// per stage timers and counters of the hot path, aggregated per frame
+	//
+	// a World with a profiler set times its stages into the current frame, the caller ends a frame with end_frame,
+	// after a step or after a rendered frame with several steps, the frame then goes into the stage histograms
+	// every timed scope is also kept as an event for the trace, and every frame as a row for the CSV,
+	// up to max_events and max_frames, the histograms go on counting past them
+	// timers cost two clock reads each, building with PHS_NO_PROFILING (cmake -DPHS_PROFILING=OFF) removes them
+	// not thread safe, a profiler belongs to the thread stepping the world (parallel stages are timed as a whole)
+	class Profiler
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		explicit Profiler(size_t max_events = 1 << 20, size_t max_frames = 1 << 16);
+
+		void record(Stage stage, clock::time_point beg, clock::time_point end);
+		// counters keep the last value set in a frame
+		void set(Counter counter, std::uint64_t value);
+		void end_frame();
+
+		std::uint64_t frame_count()const;
+		const StageHistogram& histogram(Stage stage)const;
+		// time of a stage in the frame ended last, in nanoseconds
+		std::uint64_t last_frame_ns(Stage stage)const;
+		std::uint64_t last_frame_counter(Counter counter)const;
+
+		// chrome://tracing or Perfetto: a complete event per timed scope and counter events per frame
+		// throw std::runtime_error when the file cannot be written
+		void write_chrome_trace(const std::filesystem::path& path)const;
+		// one row per frame, the time of every stage in microseconds and every counter
+		void write_csv(const std::filesystem::path& path)const;
+		// stage, frames, mean, p50, p99 and max in milliseconds
+		void write_summary(std::FILE* out)const;
+
+		void reset();
+
+		// tid of the events in the trace, to tell apart the profilers of several threads in one trace
+		std::uint32_t thread_id = 1;
+	private:
+		struct Event
+		{
+			std::uint64_t beg_ns, duration_ns;
+			Stage stage;
+		};
+
+		struct Frame
+		{
+			std::uint64_t end_ns;
+			std::array<std::uint64_t, stage_count> stage_ns;
+			std::array<std::uint64_t, counter_count> counters;
+			// stages that ran, a stage can run and take 0 ns on a coarse clock
+			std::uint32_t ran;
+		};
+
+		std::uint64_t since_start(clock::time_point t)const;
+
+		size_t max_events;
+		size_t max_frames;
+		clock::time_point start;
+
+		Frame current{};
+		Frame last{};
+		std::uint64_t frames = 0;
+		std::array<StageHistogram, stage_count> histograms{};
+		std::vector<Event> events{};
+		std::vector<Frame> rows{};
+	};
+
+	// times its scope into a profiler, does nothing when the profiler is null
+	class ScopedTimer
+	{
+	public:
+		ScopedTimer(Profiler* profiler, Stage stage)
+			: profiler{ profiler }, stage{ stage }
+		{
+			if (profiler)
+				beg = Profiler::clock::now();
+		}
+
+		~ScopedTimer() {
+			if (profiler)
+				profiler->record(stage, beg, Profiler::clock::now());
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+	private:
+		Profiler* profiler;
+		Stage stage;
+		Profiler::clock::time_point beg{};
+	};
+}
+
+#define PHS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define PHS_PROFILE_CONCAT(a, b) PHS_PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(PHS_NO_PROFILING)
+#define PHS_PROFILE_SCOPE(profiler, stage) ((void)0)
+#define PHS_PROFILE_COUNT(profiler, counter, value) ((void)0)
+#else
+// times the rest of the enclosing scope as `stage`
+#define PHS_PROFILE_SCOPE(profiler, stage) const ::phs::ScopedTimer PHS_PROFILE_CONCAT(phs_profile_timer_, __LINE__){ (profiler), (stage) }
+#define PHS_PROFILE_COUNT(profiler, counter, value) do { if (profiler) (profiler)->set((counter), (value)); } while (false)
+#endif
@@ -0,0 +1,247 @@
+#include "replay.h"
+#include "snapshot.h"
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// the log is written as it is in memory
+static_assert(std::endian::native == std::endian::little, "replays are little endian");
+
+namespace phs
+{
+	namespace
+	{
+		struct Header
+		{
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t scalar_type;
+			std::uint32_t scalar_size;
+			// bit 0 continuous, bit 1 use_solver, bit 2 allow_sleeping, bit 3 sort and sweep broad phase, bit 4 hierarchical grid broad phase
+			std::uint32_t flags;
+
+			std::uint64_t seed;
+			std::uint64_t ball_count;
+			std::uint64_t velocity_iterations;
+			std::uint64_t reorder_interval;
+			std::uint64_t impulse_count;
+			std::uint64_t hash_count;
+
+			// middle, half_width, half_height and dt, each stored in 8 bytes whatever the Float
+			std::byte scalars[5][8];
+		};
+
+		struct StoredImpulse
+		{
+			std::uint64_t step;
+			std::uint64_t ball;
+			std::byte acceleration[2][8];
+		};
+
+		void put_scalar(std::byte* slot, Float value) {
+			std::memset(slot, 0, 8);
+			std::memcpy(slot, &value, sizeof(Float));
+		}
+
+		Float get_scalar(const std::byte* slot) {
+			Float value{};
+			std::memcpy(&value, slot, sizeof(Float));
+			return value;
+		}
+
+		// one multiply and shift per 8 bytes, with the tail zero padded
+		std::uint64_t mix(std::uint64_t h, const void* data, size_t bytes) {
+			const auto* p = static_cast<const unsigned char*>(data);
+			for (; bytes >= 8; bytes -= 8, p += 8) {
+				std::uint64_t word;
+				std::memcpy(&word, p, 8);
+				h = (h ^ word) * 0x9e3779b97f4a7c15ull;
+				h ^= h >> 32;
+			}
+			if (bytes > 0) {
+				std::uint64_t word = 0;
+				std::memcpy(&word, p, bytes);
+				h = (h ^ word) * 0x9e3779b97f4a7c15ull;
+				h ^= h >> 32;
+			}
+			return h;
+		}
+	}
+
+	void build_scene(World& world, const ReplayScene& scene) {
+		world = World{};
+		world.continuous = scene.continuous;
+		world.use_solver = scene.use_solver;
+		world.solver.velocity_iterations = scene.velocity_iterations;
+		world.allow_sleeping = scene.allow_sleeping;
+		world.broad_phase = scene.broad_phase;
+		world.reorder_interval = scene.reorder_interval;
+		add_box_scene(world, scene.middle, scene.half_width, scene.half_height, scene.ball_count, scene.seed);
+	}
+
+	std::uint64_t state_hash(const World& world) {
+		const size_t n = world.balls.size();
+		std::uint64_t h = mix(0xcbf29ce484222325ull, &n, sizeof(n));
+		for (const auto* values : { &world.balls.x, &world.balls.y, &world.balls.vx, &world.balls.vy, &world.balls.ax, &world.balls.ay })
+			h = mix(h, values->data(), n * sizeof(Float));
+		return mix(h, world.balls.sleeping.data(), n);
+	}
+
+	void save_replay(const ReplayLog& log, const std::filesystem::path& path) {
+		Header header{};
+		std::memcpy(header.magic, replay::magic, sizeof(header.magic));
+		header.version = replay::version;
+		header.scalar_type = snapshot::scalar_type();
+		header.scalar_size = sizeof(Float);
+		header.flags = (log.scene.continuous ? 1u : 0u) | (log.scene.use_solver ? 2u : 0u) | (log.scene.allow_sleeping ? 4u : 0u)
+			| (log.scene.broad_phase == BroadPhaseKind::sweep_and_prune ? 8u : 0u) | (log.scene.broad_phase == BroadPhaseKind::hierarchical_grid ? 16u : 0u);
+		header.seed = log.scene.seed;
+		header.ball_count = log.scene.ball_count;
+		header.velocity_iterations = log.scene.velocity_iterations;
+		header.reorder_interval = log.scene.reorder_interval;
+		header.impulse_count = log.impulses.size();
+		header.hash_count = log.hashes.size();
+		put_scalar(header.scalars[0], log.scene.middle.x);
+		put_scalar(header.scalars[1], log.scene.middle.y);
+		put_scalar(header.scalars[2], log.scene.half_width);
+		put_scalar(header.scalars[3], log.scene.half_height);
+		put_scalar(header.scalars[4], log.dt);
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		if (not file)
+			throw std::runtime_error("cannot create " + path.string());
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (const ReplayImpulse& impulse : log.impulses) {
+			StoredImpulse stored{ impulse.step, impulse.ball, {} };
+			put_scalar(stored.acceleration[0], impulse.acceleration.x);
+			put_scalar(stored.acceleration[1], impulse.acceleration.y);
+			file.write(reinterpret_cast<const char*>(&stored), sizeof(stored));
+		}
+		file.write(reinterpret_cast<const char*>(log.hashes.data()), std::streamsize(log.hashes.size() * sizeof(std::uint64_t)));
+		if (not file)
+			throw std::runtime_error("cannot write " + path.string());
+	}
+
+	ReplayLog load_replay(const std::filesystem::path& path) {
+		std::ifstream file{ path, std::ios::binary };
+		if (not file)
+			throw std::runtime_error("cannot open " + path.string());
+
+		Header header{};
+		if (not file.read(reinterpret_cast<char*>(&header), sizeof(header)) or std::memcmp(header.magic, replay::magic, sizeof(header.magic)) != 0)
+			throw std::runtime_error(path.string() + " is not a replay");
+		if (header.version != replay::version)
+			throw std::runtime_error(path.string() + " is a replay of version " + std::to_string(header.version) + ", not " + std::to_string(replay::version));
+		if (header.scalar_type != snapshot::scalar_type() or header.scalar_size != sizeof(Float))
+			throw std::runtime_error(path.string() + " was recorded by a build with a different Float");
+
+		// every count is bounded by the bytes left for it before it is multiplied or reserved, so none can wrap around
+		const std::uint64_t size = std::filesystem::file_size(path);
+		const std::uint64_t payload = size < sizeof(Header) ? 0 : size - sizeof(Header);
+		if (header.impulse_count > payload / sizeof(StoredImpulse)
+			or header.hash_count > (payload - header.impulse_count * sizeof(StoredImpulse)) / sizeof(std::uint64_t))
+			throw std::runtime_error(path.string() + " is truncated");
+
+		ReplayLog log{};
+		log.scene.seed = unsigned(header.seed);
+		log.scene.middle = Point{ get_scalar(header.scalars[0]), get_scalar(header.scalars[1]) };
+		log.scene.half_width = get_scalar(header.scalars[2]);
+		log.scene.half_height = get_scalar(header.scalars[3]);
+		log.scene.ball_count = size_t(header.ball_count);
+		log.scene.continuous = (header.flags & 1u) != 0;
+		log.scene.use_solver = (header.flags & 2u) != 0;
+		log.scene.allow_sleeping = (header.flags & 4u) != 0;
+		log.scene.broad_phase = (header.flags & 8u) != 0 ? BroadPhaseKind::sweep_and_prune
+			: (header.flags & 16u) != 0 ? BroadPhaseKind::hierarchical_grid : BroadPhaseKind::grid;
+		log.scene.velocity_iterations = size_t(header.velocity_iterations);
+		log.scene.reorder_interval = size_t(header.reorder_interval);
+		log.dt = get_scalar(header.scalars[4]);
+
+		log.impulses.reserve(size_t(header.impulse_count));
+		for (std::uint64_t k = 0; k < header.impulse_count; ++k) {
+			StoredImpulse stored{};
+			file.read(reinterpret_cast<char*>(&stored), sizeof(stored));
+			log.impulses.push_back(ReplayImpulse{ stored.step, stored.ball,
+				Vector{ get_scalar(stored.acceleration[0]), get_scalar(stored.acceleration[1]) } });
+		}
+		log.hashes.resize(size_t(header.hash_count));
+		file.read(reinterpret_cast<char*>(log.hashes.data()), std::streamsize(log.hashes.size() * sizeof(std::uint64_t)));
+		if (not file)
+			throw std::runtime_error("cannot read " + path.string());
+		return log;
+	}
+
+	ReplayRecorder::ReplayRecorder(World& world, const ReplayScene& scene)
+		: world{ world }
+	{
+		recorded.scene = scene;
+		build_scene(world, scene);
+	}
+
+	void ReplayRecorder::impulse(size_t ball, const Vector& acceleration) {
+		world.balls.ax[ball] += acceleration.x;
+		world.balls.ay[ball] += acceleration.y;
+		recorded.impulses.push_back(ReplayImpulse{ recorded.hashes.size(), ball, acceleration });
+	}
+
+	void ReplayRecorder::step(Float dt) {
+		if (recorded.hashes.empty())
+			recorded.dt = dt;
+		else if (dt != recorded.dt)
+			throw std::invalid_argument("a replay needs the same dt for every step");
+
+		world.step(dt);
+		recorded.hashes.push_back(state_hash(world));
+	}
+
+	const ReplayLog& ReplayRecorder::log()const {
+		return recorded;
+	}
+
+	ReplayPlayer::ReplayPlayer(ReplayLog log)
+		: played{ std::move(log) }
+	{
+		build_scene(world, played.scene);
+	}
+
+	const ReplayLog& ReplayPlayer::log()const {
+		return played;
+	}
+
+	size_t ReplayPlayer::position()const {
+		return steps;
+	}
+
+	bool ReplayPlayer::done()const {
+		return steps >= played.hashes.size();
+	}
+
+	bool ReplayPlayer::step() {
+		// impulses on balls the scene does not have (a log from another scene) are dropped, the hashes tell the story
+		for (; next_impulse < played.impulses.size() and played.impulses[next_impulse].step == steps; ++next_impulse) {
+			const ReplayImpulse& impulse = played.impulses[next_impulse];
+			if (impulse.ball < world.balls.size()) {
+				world.balls.ax[size_t(impulse.ball)] += impulse.acceleration.x;
+				world.balls.ay[size_t(impulse.ball)] += impulse.acceleration.y;
+			}
+		}
+
+		world.step(played.dt);
+		return state_hash(world) == played.hashes[steps++];
+	}
+
+	std::optional<size_t> ReplayPlayer::run() {
+		return run_to(played.hashes.size());
+	}
+
+	std::optional<size_t> ReplayPlayer::run_to(size_t position) {
+		while (steps < position and not done()) {
+			if (not step())
+				return steps - 1;
+		}
+		return std::nullopt;
+	}
+}
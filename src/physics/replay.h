@@ -0,0 +1,109 @@
+#pragma once
+#include "world.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace phs
+{
+	// deterministic replays of the demo scene
+	//
+	// a replay log holds what a run cannot recompute: the scene (add_box_scene and its seed), the world switches,
+	// the fixed step time, every impulse with the step it was applied before, and the state hash after every step
+	// impulses are logged by ball index, which a reordering world changes, replaying reorders the same way so the index holds
+	// replaying rebuilds the scene, applies the impulses at the same steps and compares the hashes, so the first step
+	// that differs is the exact step where a build, a platform or a change to the engine diverged
+	// the single threaded step is recorded, a replay is only bit exact on a build with the same Float
+	namespace replay
+	{
+		inline constexpr char magic[8] = { 'P', 'H', 'S', 'R', 'E', 'P', 'L', '\0' };
+		inline constexpr std::uint32_t version = 2;
+	}
+
+	struct ReplayScene
+	{
+		unsigned seed = 0;
+		Point middle{};
+		Float half_width = Float(300);
+		Float half_height = Float(250);
+		size_t ball_count = 20;
+
+		bool continuous = false;
+		bool use_solver = false;
+		size_t velocity_iterations = 8;
+		bool allow_sleeping = false;
+		BroadPhaseKind broad_phase = BroadPhaseKind::grid;
+		size_t reorder_interval = 0;
+	};
+
+	// builds the world of a scene, replacing whatever the world held
+	void build_scene(World& world, const ReplayScene& scene);
+
+	// hash of the ball state (centers, velocities, accelerations and sleep flags)
+	std::uint64_t state_hash(const World& world);
+
+	struct ReplayImpulse
+	{
+		// applied right before this step, so the step after `step` recorded steps sees it
+		std::uint64_t step;
+		std::uint64_t ball;
+		Vector acceleration;
+	};
+
+	struct ReplayLog
+	{
+		ReplayScene scene{};
+		Float dt = Float(0);
+		std::vector<ReplayImpulse> impulses{};
+		// state hash after every step
+		std::vector<std::uint64_t> hashes{};
+	};
+
+	// throws std::runtime_error when the file cannot be written or is not a replay of this version and Float
+	void save_replay(const ReplayLog& log, const std::filesystem::path& path);
+	ReplayLog load_replay(const std::filesystem::path& path);
+
+	// records a live run, every step and impulse of the world has to go through it
+	class ReplayRecorder
+	{
+	public:
+		// builds the scene into the world
+		ReplayRecorder(World& world, const ReplayScene& scene);
+
+		// adds the impulse to the acceleration of the ball and logs it for the next step
+		void impulse(size_t ball, const Vector& acceleration);
+		// steps the world and logs its hash, throws std::invalid_argument when dt differs from the first step's
+		void step(Float dt);
+
+		const ReplayLog& log()const;
+	private:
+		World& world;
+		ReplayLog recorded{};
+	};
+
+	// plays a log back on its own world, as fast as the CPU allows
+	class ReplayPlayer
+	{
+	public:
+		explicit ReplayPlayer(ReplayLog log);
+
+		World world{};
+
+		const ReplayLog& log()const;
+		// number of steps taken
+		size_t position()const;
+		bool done()const;
+
+		// applies the impulses of the next step, steps and returns whether the hash matches the log
+		bool step();
+		// steps until the end of the log, or stops after the first step whose hash differs and returns its index
+		std::optional<size_t> run();
+		// steps until `position` steps were taken or a hash differs, to look at the world right before a divergence
+		std::optional<size_t> run_to(size_t position);
+	private:
+		ReplayLog played;
+		size_t steps = 0;
+		size_t next_impulse = 0;
+	};
+}
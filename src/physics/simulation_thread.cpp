@@ -0,0 +1,125 @@
+#include "simulation_thread.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace phs
+{
+	size_t WorldSnapshot::size()const {
+		return x.size();
+	}
+
+	void WorldSnapshot::capture(const World& world, std::uint64_t new_step, double new_time) {
+		step = new_step;
+		time = new_time;
+		const size_t n = world.balls.size();
+		x.assign(world.balls.x.begin(), world.balls.x.begin() + n);
+		y.assign(world.balls.y.begin(), world.balls.y.begin() + n);
+		radius.assign(world.balls.radius.begin(), world.balls.radius.begin() + n);
+		sleeping.assign(world.balls.sleeping.begin(), world.balls.sleeping.begin() + n);
+
+		// balls past the end of the ids were added after the last reorder and are already in place,
+		// ids outnumbering the balls are left from balls that were cleared, and ignored
+		const auto& ids = world.get_ball_ids();
+		const size_t renumbered = ids.size() <= n ? ids.size() : 0;
+		for (size_t i = 0; i < renumbered; ++i) {
+			x[ids[i]] = world.balls.x[i];
+			y[ids[i]] = world.balls.y[i];
+			radius[ids[i]] = world.balls.radius[i];
+			sleeping[ids[i]] = world.balls.sleeping[i];
+		}
+	}
+
+	SimulationThread::SimulationThread(World& world, double rate, bool paced, Step step, std::uint64_t step_limit, size_t max_behind)
+		: world{ world }, rate{ rate }, paced{ paced }, step{ std::move(step) }, step_limit{ step_limit }, max_behind{ std::max<size_t>(max_behind, 1) }
+	{
+		if (not (rate > 0.0))
+			throw std::invalid_argument("the simulation rate has to be positive");
+		if (not this->step)
+			this->step = [](World& w, Float dt) { w.step(dt); };
+
+		snapshots.back().capture(world, 0, 0.0);
+		snapshots.publish();
+		thread = std::thread([this] { run(); });
+	}
+
+	SimulationThread::~SimulationThread() {
+		stopping = true;
+		join();
+	}
+
+	void SimulationThread::post(Command command) {
+		std::lock_guard lock{ command_mutex };
+		commands.push_back(std::move(command));
+	}
+
+	const WorldSnapshot& SimulationThread::latest() {
+		snapshots.update();
+		return snapshots.front();
+	}
+
+	std::uint64_t SimulationThread::steps()const {
+		return step_count.load(std::memory_order_relaxed);
+	}
+
+	bool SimulationThread::finished()const {
+		return done.load(std::memory_order_acquire);
+	}
+
+	void SimulationThread::stop() {
+		stopping = true;
+		join();
+		if (error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+	}
+
+	void SimulationThread::wait() {
+		join();
+		if (error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+	}
+
+	void SimulationThread::join() {
+		if (thread.joinable())
+			thread.join();
+	}
+
+	void SimulationThread::run() {
+		using clock = std::chrono::steady_clock;
+		const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / rate));
+		const Float dt = Float(1.0 / rate);
+		auto next = clock::now();
+
+		try {
+			std::uint64_t count = 0;
+			while (not stopping.load(std::memory_order_relaxed) and (step_limit == 0 or count < step_limit)) {
+				{
+					std::lock_guard lock{ command_mutex };
+					running.swap(commands);
+				}
+				for (Command& command : running)
+					command(world);
+				running.clear();
+
+				if (paced) {
+					const auto now = clock::now();
+					if (now < next)
+						std::this_thread::sleep_until(next);
+					else if (now - next > period * std::int64_t(max_behind))
+						next = now;
+					next += period;
+				}
+
+				step(world, dt);
+				++count;
+				snapshots.back().capture(world, count, double(count) / rate);
+				snapshots.publish();
+				step_count.store(count, std::memory_order_relaxed);
+			}
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+		done.store(true, std::memory_order_release);
+	}
+}
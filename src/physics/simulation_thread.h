@@ -0,0 +1,130 @@
+#pragma once
+#include "world.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace phs
+{
+	// hands the latest value from one writer thread to one reader thread without locks or waiting
+	//
+	// the writer fills back() and publishes it by swapping it with the middle slot, the reader takes the middle slot
+	// into front() by swapping again, so each side always owns one slot and the middle holds the newest complete value
+	// values the reader was too slow to take are overwritten, values are reused, so vectors in them keep their capacity
+	template<class T>
+	class TripleBuffer
+	{
+	public:
+		// writer side
+		T& back() {
+			return slots[back_index];
+		}
+
+		void publish() {
+			back_index = middle.exchange(std::uint8_t(back_index | fresh), std::memory_order_acq_rel) & index_mask;
+		}
+
+		// reader side, takes the newest published value if there is one and returns whether there was
+		bool update() {
+			if ((middle.load(std::memory_order_relaxed) & fresh) == 0)
+				return false;
+			front_index = middle.exchange(front_index, std::memory_order_acq_rel) & index_mask;
+			return true;
+		}
+
+		const T& front()const {
+			return slots[front_index];
+		}
+	private:
+		static constexpr std::uint8_t index_mask = 3;
+		static constexpr std::uint8_t fresh = 4;
+
+		std::array<T, 3> slots{};
+		// the writer and the reader indices on their own cache lines, the writer and the reader do not share them
+		alignas(64) std::uint8_t back_index = 0;
+		alignas(64) std::atomic<std::uint8_t> middle{ 1 };
+		alignas(64) std::uint8_t front_index = 2;
+	};
+
+	// what a renderer needs of a World after a step, copied out so the simulation can go on
+	// the balls are in order of their ids, so a ball stays at the same place in every snapshot of a reordering world
+	struct WorldSnapshot
+	{
+		// number of steps taken, 0 before the first one
+		std::uint64_t step = 0;
+		// simulated time
+		double time = 0.0;
+		std::vector<Float> x{}, y{}, radius{};
+		std::vector<std::uint8_t> sleeping{};
+
+		size_t size()const;
+		void capture(const World& world, std::uint64_t step, double time);
+	};
+
+	// steps a World on its own thread and publishes a WorldSnapshot after every step
+	//
+	// every step has dt = 1 / rate, paced steps are spread over the wall clock at `rate` per second and a thread falling
+	// behind by more than max_behind steps drops that time instead of catching up, unpaced steps run back to back
+	// the world belongs to the simulation thread while it runs, other threads read snapshots and change the world
+	// only through post, whose commands run on the simulation thread between two steps
+	class SimulationThread
+	{
+	public:
+		using Step = std::function<void(World&, Float)>;
+		using Command = std::function<void(World&)>;
+
+		// starts the thread, step(world, dt) defaults to world.step(dt), step_limit > 0 stops after that many steps
+		// throws std::invalid_argument for a rate that is not positive
+		explicit SimulationThread(World& world, double rate = 120.0, bool paced = true, Step step = {},
+			std::uint64_t step_limit = 0, size_t max_behind = 8);
+		~SimulationThread();
+
+		SimulationThread(const SimulationThread&) = delete;
+		SimulationThread& operator=(const SimulationThread&) = delete;
+
+		void post(Command command);
+
+		// reader side, the newest snapshot, the snapshot of the world as it was before the thread started until the
+		// first step, stays valid until the next call
+		const WorldSnapshot& latest();
+
+		// steps taken so far
+		std::uint64_t steps()const;
+		// whether the thread has stopped, at the step limit, on stop or on an exception
+		bool finished()const;
+
+		// stops after the current step and joins, rethrows an exception thrown by a step or a command
+		void stop();
+		// waits for the step limit and joins, rethrows like stop, without a step limit it only returns after an exception
+		void wait();
+	private:
+		void run();
+		void join();
+
+		World& world;
+		double rate;
+		bool paced;
+		Step step;
+		std::uint64_t step_limit;
+		size_t max_behind;
+
+		TripleBuffer<WorldSnapshot> snapshots{};
+
+		std::mutex command_mutex;
+		std::vector<Command> commands{};
+		std::vector<Command> running{};
+
+		std::atomic<std::uint64_t> step_count{ 0 };
+		std::atomic<bool> stopping{ false };
+		std::atomic<bool> done{ false };
+		std::exception_ptr error{};
+		std::thread thread;
+	};
+}
@@ -0,0 +1,430 @@
+#include "snapshot.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// the sections are the in memory arrays copied byte for byte
+static_assert(std::endian::native == std::endian::little, "snapshots are little endian");
+
+namespace phs
+{
+	namespace snapshot
+	{
+		std::uint32_t scalar_type() {
+			if constexpr (std::is_same_v<Float, float>)
+				return 0;
+			else if constexpr (std::is_same_v<Float, double>)
+				return 1;
+			else
+				return 2;
+		}
+	}
+
+	MappedFile MappedFile::open(const std::filesystem::path& path) {
+		MappedFile mapped{};
+#if defined(_WIN32)
+		const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("cannot open " + path.string());
+		mapped.file = std::intptr_t(file);
+
+		LARGE_INTEGER size{};
+		GetFileSizeEx(file, &size);
+		mapped.length = size_t(size.QuadPart);
+		if (mapped.length > 0) {
+			const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping == nullptr)
+				throw std::runtime_error("cannot map " + path.string());
+			mapped.mapping = std::intptr_t(mapping);
+			mapped.bytes = static_cast<std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			if (mapped.bytes == nullptr)
+				throw std::runtime_error("cannot map " + path.string());
+		}
+#else
+		const int file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			throw std::runtime_error("cannot open " + path.string());
+		mapped.file = file;
+
+		struct stat status{};
+		fstat(file, &status);
+		mapped.length = size_t(status.st_size);
+		if (mapped.length > 0) {
+			void* p = mmap(nullptr, mapped.length, PROT_READ, MAP_PRIVATE, file, 0);
+			if (p == MAP_FAILED)
+				throw std::runtime_error("cannot map " + path.string());
+			mapped.bytes = static_cast<std::byte*>(p);
+		}
+#endif
+		return mapped;
+	}
+
+	MappedFile MappedFile::create(const std::filesystem::path& path, size_t size) {
+		MappedFile mapped{};
+		mapped.length = size;
+#if defined(_WIN32)
+		const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("cannot create " + path.string());
+		mapped.file = std::intptr_t(file);
+
+		const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, DWORD(std::uint64_t(size) >> 32), DWORD(size), nullptr);
+		if (mapping == nullptr)
+			throw std::runtime_error("cannot map " + path.string());
+		mapped.mapping = std::intptr_t(mapping);
+		mapped.bytes = static_cast<std::byte*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+		if (mapped.bytes == nullptr)
+			throw std::runtime_error("cannot map " + path.string());
+#else
+		const int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (file < 0)
+			throw std::runtime_error("cannot create " + path.string());
+		mapped.file = file;
+
+		if (ftruncate(file, off_t(size)) != 0)
+			throw std::runtime_error("cannot resize " + path.string());
+		void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		if (p == MAP_FAILED)
+			throw std::runtime_error("cannot map " + path.string());
+		mapped.bytes = static_cast<std::byte*>(p);
+#endif
+		return mapped;
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			close();
+			bytes = std::exchange(other.bytes, nullptr);
+			length = std::exchange(other.length, 0);
+			file = std::exchange(other.file, -1);
+			mapping = std::exchange(other.mapping, 0);
+		}
+		return *this;
+	}
+
+	MappedFile::~MappedFile() {
+		close();
+	}
+
+	void MappedFile::close() noexcept {
+#if defined(_WIN32)
+		if (bytes != nullptr)
+			UnmapViewOfFile(bytes);
+		if (mapping != 0)
+			CloseHandle(HANDLE(mapping));
+		if (file != -1)
+			CloseHandle(HANDLE(file));
+#else
+		if (bytes != nullptr)
+			munmap(bytes, length);
+		if (file >= 0)
+			::close(int(file));
+#endif
+		bytes = nullptr;
+		length = 0;
+		file = -1;
+		mapping = 0;
+	}
+
+	std::byte* MappedFile::data()const {
+		return bytes;
+	}
+
+	size_t MappedFile::size()const {
+		return length;
+	}
+
+	namespace
+	{
+		// the scalars of the header take 8 bytes each, so the header looks the same for every Float
+		void put_scalar(std::byte(&slot)[8], Float value) {
+			std::memset(slot, 0, sizeof(slot));
+			std::memcpy(slot, &value, sizeof(Float));
+		}
+
+		Float get_scalar(const std::byte(&slot)[8]) {
+			Float value{};
+			std::memcpy(&value, slot, sizeof(Float));
+			return value;
+		}
+
+		size_t align(size_t offset) {
+			return (offset + snapshot::alignment - 1) / snapshot::alignment * snapshot::alignment;
+		}
+	}
+
+	SnapshotView::SnapshotView(const std::filesystem::path& path)
+		: file{ MappedFile::open(path) }
+	{
+		if (file.size() < snapshot::header_size)
+			throw std::runtime_error(path.string() + " is not a snapshot");
+
+		const auto& h = header();
+		if (std::memcmp(h.magic, snapshot::magic, sizeof(snapshot::magic)) != 0)
+			throw std::runtime_error(path.string() + " is not a snapshot");
+		if (h.version != snapshot::version)
+			throw std::runtime_error(path.string() + " is a snapshot of version " + std::to_string(h.version) + ", not " + std::to_string(snapshot::version));
+		if (h.scalar_type != snapshot::scalar_type() or h.scalar_size != sizeof(Float))
+			throw std::runtime_error(path.string() + " was saved by a build with a different Float");
+		// written so that no sum or product of the counts can wrap around
+		for (size_t s = 0; s < snapshot::section_count; ++s)
+			if (h.size[s] > file.size() or h.offset[s] > file.size() - h.size[s] or h.offset[s] % snapshot::alignment != 0)
+				throw std::runtime_error(path.string() + " is truncated");
+
+		// every section holds exactly the elements the counts say, so the loader can copy and index by the counts
+		const auto holds = [&](snapshot::Section s, std::uint64_t count, size_t element) {
+			return count <= file.size() / element and h.size[s] == count * element;
+		};
+		const std::uint64_t n = h.ball_count;
+		bool valid = n <= file.size() and h.padded_count == (n + BallStorage::lanes - 1) / BallStorage::lanes * BallStorage::lanes;
+		for (size_t s = snapshot::ball_x; s <= snapshot::ball_inv_mass; ++s)
+			valid = valid and holds(snapshot::Section(s), h.padded_count, sizeof(Float));
+		valid = valid and holds(snapshot::ball_sleeping, h.padded_count, 1);
+		// the sleep arrays may be shorter than the balls
+		valid = valid and h.size[snapshot::rest_time] % sizeof(Float) == 0 and h.size[snapshot::rest_time] / sizeof(Float) <= n;
+		valid = valid and h.size[snapshot::island] % sizeof(std::uint32_t) == 0 and h.size[snapshot::island] / sizeof(std::uint32_t) <= n;
+		valid = valid and h.asleep <= n;
+		for (size_t s = snapshot::wall_beg_x; s <= snapshot::wall_radius; ++s)
+			valid = valid and holds(snapshot::Section(s), h.wall_count, sizeof(Float));
+		valid = valid and holds(snapshot::ball_contact_a, h.ball_contact_count, sizeof(std::uint32_t)) and holds(snapshot::ball_contact_b, h.ball_contact_count, sizeof(std::uint32_t))
+			and holds(snapshot::ball_contact_impulse, h.ball_contact_count, sizeof(Float));
+		valid = valid and holds(snapshot::wall_contact_a, h.wall_contact_count, sizeof(std::uint32_t)) and holds(snapshot::wall_contact_b, h.wall_contact_count, sizeof(std::uint32_t))
+			and holds(snapshot::wall_contact_impulse, h.wall_contact_count, sizeof(Float));
+		// a world that was never reordered saves no ids
+		valid = valid and (h.size[snapshot::ball_id] == 0 or holds(snapshot::ball_id, n, sizeof(std::uint32_t)));
+		if (not valid)
+			throw std::runtime_error(path.string() + " has sections that do not match its counts");
+
+		// the solver indexes the balls and walls of its contacts when the balls are reordered
+		const auto* ball_a = array<std::uint32_t>(snapshot::ball_contact_a);
+		const auto* ball_b = array<std::uint32_t>(snapshot::ball_contact_b);
+		for (size_t k = 0; k < h.ball_contact_count; ++k)
+			if (ball_a[k] >= n or ball_b[k] >= n)
+				throw std::runtime_error(path.string() + " has a contact with a ball that does not exist");
+		const auto* wall_a = array<std::uint32_t>(snapshot::wall_contact_a);
+		const auto* wall_b = array<std::uint32_t>(snapshot::wall_contact_b);
+		for (size_t k = 0; k < h.wall_contact_count; ++k)
+			if (wall_a[k] >= n or wall_b[k] >= h.wall_count)
+				throw std::runtime_error(path.string() + " has a contact with a ball or wall that does not exist");
+
+		// islands index the balls, and waking a sleeping ball reads its island and writes its rest time
+		const size_t rest_count = size_t(h.size[snapshot::rest_time] / sizeof(Float));
+		const size_t island_count = size_t(h.size[snapshot::island] / sizeof(std::uint32_t));
+		const auto* island = array<std::uint32_t>(snapshot::island);
+		for (size_t k = 0; k < island_count; ++k)
+			if (island[k] >= n)
+				throw std::runtime_error(path.string() + " has an island that does not exist");
+		const auto* sleeping = array<std::uint8_t>(snapshot::ball_sleeping);
+		std::uint64_t asleep = 0;
+		for (size_t k = 0; k < h.padded_count; ++k) {
+			if (sleeping[k] == 0)
+				continue;
+			if (k >= n or k >= rest_count or k >= island_count)
+				throw std::runtime_error(path.string() + " has a sleeping ball without a rest time or island");
+			++asleep;
+		}
+		if (asleep != h.asleep)
+			throw std::runtime_error(path.string() + " counts " + std::to_string(h.asleep) + " sleeping balls but flags " + std::to_string(asleep));
+	}
+
+	const snapshot::Header& SnapshotView::header()const {
+		return *reinterpret_cast<const snapshot::Header*>(file.data());
+	}
+
+	void save_snapshot(const World& world, const std::filesystem::path& path) {
+		using namespace snapshot;
+
+		const auto& balls = world.balls;
+		const auto& solver = world.solver;
+		const size_t n = balls.size();
+
+		// (data, bytes) of every section in file order
+		struct Source { const void* data; size_t bytes; };
+		std::vector<Float> wall_arrays[5];
+		for (auto& array : wall_arrays)
+			array.reserve(world.walls.size());
+		for (const auto& wall : world.walls) {
+			wall_arrays[0].push_back(wall.beg.x);
+			wall_arrays[1].push_back(wall.beg.y);
+			wall_arrays[2].push_back(wall.end.x);
+			wall_arrays[3].push_back(wall.end.y);
+			wall_arrays[4].push_back(wall.radius);
+		}
+
+		std::vector<std::uint32_t> contact_ids[4];
+		std::vector<Float> contact_impulses[2];
+		for (size_t k = 0; k < 2; ++k) {
+			for (const auto& contact : k == 0 ? solver.last_ball_contacts() : solver.last_wall_contacts()) {
+				contact_ids[2 * k].push_back(contact.a);
+				contact_ids[2 * k + 1].push_back(contact.b);
+				contact_impulses[k].push_back(contact.impulse);
+			}
+		}
+
+		const size_t padded = balls.padded_size();
+		const size_t walls = world.walls.size();
+		const Source sources[section_count] = {
+			{ balls.x.data(), padded * sizeof(Float) }, { balls.y.data(), padded * sizeof(Float) },
+			{ balls.vx.data(), padded * sizeof(Float) }, { balls.vy.data(), padded * sizeof(Float) },
+			{ balls.ax.data(), padded * sizeof(Float) }, { balls.ay.data(), padded * sizeof(Float) },
+			{ balls.radius.data(), padded * sizeof(Float) }, { balls.inv_mass.data(), padded * sizeof(Float) },
+			{ balls.sleeping.data(), padded },
+			// the sleep arrays only grow on steps with sleeping allowed, so they may be shorter than the balls
+			{ world.rest_time.data(), std::min(n, world.rest_time.size()) * sizeof(Float) },
+			{ world.island.data(), std::min(n, world.island.size()) * sizeof(std::uint32_t) },
+			{ wall_arrays[0].data(), walls * sizeof(Float) }, { wall_arrays[1].data(), walls * sizeof(Float) },
+			{ wall_arrays[2].data(), walls * sizeof(Float) }, { wall_arrays[3].data(), walls * sizeof(Float) },
+			{ wall_arrays[4].data(), walls * sizeof(Float) },
+			{ contact_ids[0].data(), contact_ids[0].size() * sizeof(std::uint32_t) },
+			{ contact_ids[1].data(), contact_ids[1].size() * sizeof(std::uint32_t) },
+			{ contact_impulses[0].data(), contact_impulses[0].size() * sizeof(Float) },
+			{ contact_ids[2].data(), contact_ids[2].size() * sizeof(std::uint32_t) },
+			{ contact_ids[3].data(), contact_ids[3].size() * sizeof(std::uint32_t) },
+			{ contact_impulses[1].data(), contact_impulses[1].size() * sizeof(Float) },
+			{ world.ids.data(), world.ids.size() * sizeof(std::uint32_t) },
+		};
+
+		Header h{};
+		std::memcpy(h.magic, magic, sizeof(magic));
+		h.version = version;
+		h.scalar_type = scalar_type();
+		h.scalar_size = sizeof(Float);
+		h.flags = (world.continuous ? 1u : 0u) | (world.use_solver ? 2u : 0u) | (world.allow_sleeping ? 4u : 0u) | (solver.warm_start ? 8u : 0u)
+			| (world.broad_phase == BroadPhaseKind::sweep_and_prune ? 16u : 0u) | (world.broad_phase == BroadPhaseKind::hierarchical_grid ? 32u : 0u);
+		h.ball_count = n;
+		h.padded_count = padded;
+		h.wall_count = walls;
+		h.ball_contact_count = solver.last_ball_contacts().size();
+		h.wall_contact_count = solver.last_wall_contacts().size();
+		h.asleep = world.asleep;
+		h.velocity_iterations = solver.velocity_iterations;
+		h.position_iterations = solver.position_iterations;
+		h.reorder_interval = world.reorder_interval;
+		h.steps_since_reorder = world.steps_since_reorder;
+
+		const Float scalars[11] = {
+			world.gravity.x, world.gravity.y, world.sleep_speed, world.time_to_sleep,
+			solver.restitution, solver.restitution_threshold, solver.correction_rate, solver.slop, solver.max_correction,
+			Float(0), Float(0) };
+		for (size_t k = 0; k < 11; ++k)
+			put_scalar(h.scalars[k], scalars[k]);
+
+		size_t offset = header_size;
+		for (size_t s = 0; s < section_count; ++s) {
+			offset = align(offset);
+			h.offset[s] = offset;
+			h.size[s] = sources[s].bytes;
+			offset += sources[s].bytes;
+		}
+
+		auto file = MappedFile::create(path, offset);
+		std::memcpy(file.data(), &h, sizeof(h));
+		for (size_t s = 0; s < section_count; ++s)
+			if (sources[s].bytes > 0)
+				std::memcpy(file.data() + h.offset[s], sources[s].data, sources[s].bytes);
+	}
+
+	void load_snapshot(World& world, const SnapshotView& view) {
+		using namespace snapshot;
+
+		const auto& h = view.header();
+		const size_t n = size_t(h.ball_count);
+		const size_t padded = size_t(h.padded_count);
+
+		// the ids are the slots of the balls, so they have to be every number below the ball count once
+		const size_t id_count = h.size[ball_id] / sizeof(std::uint32_t);
+		const std::uint32_t* const ids = view.array<std::uint32_t>(ball_id);
+		std::vector<std::uint8_t> seen(id_count, 0);
+		for (size_t i = 0; i < id_count; ++i) {
+			if (ids[i] >= id_count or seen[ids[i]] != 0)
+				throw std::runtime_error("the ball ids of the snapshot are not a permutation of its balls");
+			seen[ids[i]] = 1;
+		}
+
+		auto& balls = world.balls;
+		balls.resize(n);
+
+		AlignedVector<Float>* arrays[] = { &balls.x, &balls.y, &balls.vx, &balls.vy, &balls.ax, &balls.ay, &balls.radius, &balls.inv_mass };
+		for (size_t s = 0; s < 8; ++s)
+			std::memcpy(arrays[s]->data(), view.array<Float>(Section(s)), padded * sizeof(Float));
+		std::memcpy(balls.sleeping.data(), view.array<std::uint8_t>(ball_sleeping), padded);
+
+		world.rest_time.assign(view.array<Float>(rest_time), view.array<Float>(rest_time) + h.size[rest_time] / sizeof(Float));
+		world.island.assign(view.array<std::uint32_t>(island), view.array<std::uint32_t>(island) + h.size[island] / sizeof(std::uint32_t));
+		world.asleep = size_t(h.asleep);
+
+		world.ids.assign(ids, ids + id_count);
+		world.slots.assign(world.ids.size(), 0);
+		for (size_t i = 0; i < world.ids.size(); ++i)
+			world.slots[world.ids[i]] = std::uint32_t(i);
+		world.reorder_interval = size_t(h.reorder_interval);
+		world.steps_since_reorder = size_t(h.steps_since_reorder);
+		// the order kept by the sort and sweep belongs to the balls that were replaced
+		world.sweep_and_prune.reset();
+
+		world.walls.clear();
+		world.walls.reserve(size_t(h.wall_count));
+		for (size_t j = 0; j < h.wall_count; ++j) {
+			world.walls.emplace_back(
+				Point(view.array<Float>(wall_beg_x)[j], view.array<Float>(wall_beg_y)[j]),
+				Point(view.array<Float>(wall_end_x)[j], view.array<Float>(wall_end_y)[j]),
+				view.array<Float>(wall_radius)[j]);
+		}
+		world.update_walls();
+
+		world.continuous = (h.flags & 1u) != 0;
+		world.use_solver = (h.flags & 2u) != 0;
+		world.allow_sleeping = (h.flags & 4u) != 0;
+		world.broad_phase = (h.flags & 16u) != 0 ? BroadPhaseKind::sweep_and_prune
+			: (h.flags & 32u) != 0 ? BroadPhaseKind::hierarchical_grid : BroadPhaseKind::grid;
+		world.gravity = Vector(get_scalar(h.scalars[0]), get_scalar(h.scalars[1]));
+		world.sleep_speed = get_scalar(h.scalars[2]);
+		world.time_to_sleep = get_scalar(h.scalars[3]);
+
+		auto& solver = world.solver;
+		solver.clear();
+		solver.warm_start = (h.flags & 8u) != 0;
+		solver.velocity_iterations = size_t(h.velocity_iterations);
+		solver.position_iterations = size_t(h.position_iterations);
+		solver.restitution = get_scalar(h.scalars[4]);
+		solver.restitution_threshold = get_scalar(h.scalars[5]);
+		solver.correction_rate = get_scalar(h.scalars[6]);
+		solver.slop = get_scalar(h.scalars[7]);
+		solver.max_correction = get_scalar(h.scalars[8]);
+
+		// only the ids and impulses of the last contacts matter to the next step, which warm starts from them
+		std::vector<ContactSolver::Contact> contacts[2];
+		for (size_t k = 0; k < h.ball_contact_count; ++k)
+			contacts[0].push_back(ContactSolver::Contact{ view.array<std::uint32_t>(ball_contact_a)[k], view.array<std::uint32_t>(ball_contact_b)[k],
+				Vector(), Float(0), Float(0), view.array<Float>(ball_contact_impulse)[k] });
+		for (size_t k = 0; k < h.wall_contact_count; ++k)
+			contacts[1].push_back(ContactSolver::Contact{ view.array<std::uint32_t>(wall_contact_a)[k], view.array<std::uint32_t>(wall_contact_b)[k],
+				Vector(), Float(0), Float(0), view.array<Float>(wall_contact_impulse)[k] });
+		solver.restore_contacts(std::move(contacts[0]), std::move(contacts[1]));
+
+		world.ball_ball_cols.clear();
+		world.ball_wall_cols.clear();
+	}
+
+	void load_snapshot(World& world, const std::filesystem::path& path) {
+		load_snapshot(world, SnapshotView(path));
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "world.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace phs
+{
+	// binary world snapshots, laid out so a load is nothing but memcpy out of a mapped file
+	//
+	// the file is a 1024 byte header followed by one section per array, every section starts on a 64 byte boundary:
+	// the ball arrays of BallStorage with their padding (so a section is the exact image of the vector), the sleep state,
+	// the walls as five arrays, the warm start impulses of the contact solver and the ball ids of a reordered world
+	// everything is little endian and written in the Float of the build, a snapshot only loads into a build of the same Float
+	// the state kept between steps is saved in full, so a loaded world continues bit for bit like the saved one
+	namespace snapshot
+	{
+		inline constexpr char magic[8] = { 'P', 'H', 'S', 'S', 'N', 'A', 'P', '\0' };
+		inline constexpr std::uint32_t version = 2;
+		inline constexpr size_t alignment = 64;
+
+		enum Section : std::uint32_t
+		{
+			ball_x, ball_y, ball_vx, ball_vy, ball_ax, ball_ay, ball_radius, ball_inv_mass, ball_sleeping,
+			rest_time, island,
+			wall_beg_x, wall_beg_y, wall_end_x, wall_end_y, wall_radius,
+			ball_contact_a, ball_contact_b, ball_contact_impulse,
+			wall_contact_a, wall_contact_b, wall_contact_impulse,
+			ball_id,
+			section_count
+		};
+
+		// 0 float, 1 double, 2 Fixed
+		std::uint32_t scalar_type();
+
+		struct Header
+		{
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t scalar_type;
+			std::uint32_t scalar_size;
+			// bit 0 continuous, bit 1 use_solver, bit 2 allow_sleeping, bit 3 solver.warm_start, bit 4 sort and sweep broad phase,
+			// bit 5 hierarchical grid broad phase
+			std::uint32_t flags;
+
+			std::uint64_t ball_count;
+			std::uint64_t padded_count;
+			std::uint64_t wall_count;
+			std::uint64_t ball_contact_count;
+			std::uint64_t wall_contact_count;
+			std::uint64_t asleep;
+			std::uint64_t velocity_iterations;
+			std::uint64_t position_iterations;
+			std::uint64_t reorder_interval;
+			std::uint64_t steps_since_reorder;
+
+			// gravity, sleep_speed, time_to_sleep and the solver factors, each stored in 8 bytes whatever the Float
+			std::byte scalars[11][8];
+
+			// byte offset and size of every section from the start of the file
+			std::uint64_t offset[section_count];
+			std::uint64_t size[section_count];
+		};
+		static_assert(sizeof(Header) <= 1024);
+		inline constexpr size_t header_size = 1024;
+	}
+
+	// a file mapped into memory, read only or freshly created with a fixed size
+	class MappedFile
+	{
+	public:
+		static MappedFile open(const std::filesystem::path& path);
+		static MappedFile create(const std::filesystem::path& path, size_t size);
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		std::byte* data()const;
+		size_t size()const;
+	private:
+		MappedFile() = default;
+		void close() noexcept;
+
+		std::byte* bytes = nullptr;
+		size_t length = 0;
+		// a file descriptor, or the file and mapping HANDLEs on Windows
+		std::intptr_t file = -1;
+		std::intptr_t mapping = 0;
+	};
+
+	// a snapshot file mapped read only, the arrays can be read in place without loading a world
+	class SnapshotView
+	{
+	public:
+		// throws std::runtime_error if the file is not a snapshot of this version and Float
+		explicit SnapshotView(const std::filesystem::path& path);
+
+		const snapshot::Header& header()const;
+
+		template<class T>
+		const T* array(snapshot::Section section)const {
+			return reinterpret_cast<const T*>(file.data() + header().offset[section]);
+		}
+	private:
+		MappedFile file;
+	};
+
+	// throws std::runtime_error when the file cannot be written
+	void save_snapshot(const World& world, const std::filesystem::path& path);
+	// replaces the whole state of the world
+	void load_snapshot(World& world, const SnapshotView& snapshot);
+	void load_snapshot(World& world, const std::filesystem::path& path);
+}
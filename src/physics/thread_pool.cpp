@@ -0,0 +1,132 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace phs
+{
+	ThreadPool::ThreadPool(size_t threads) {
+		threads = std::max<size_t>(threads, 1);
+		for (size_t i = 0; i < threads; ++i)
+			queues.push_back(std::make_unique<Queue>());
+
+		// queue 0 belongs to the calling thread
+		for (size_t i = 1; i < threads; ++i)
+			workers.emplace_back([this, i] { worker_loop(i); });
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard lock(sleep_mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	size_t ThreadPool::size()const {
+		return queues.size();
+	}
+
+	void ThreadPool::run(size_t n, size_t grain, void(*invoke)(void*, size_t, size_t), void* fn) {
+		if (n == 0)
+			return;
+		grain = std::max<size_t>(grain, 1);
+		const size_t chunks = (n + grain - 1) / grain;
+
+		if (queues.size() == 1 or chunks == 1) {
+			for (size_t begin = 0; begin < n; begin += grain)
+				invoke(fn, begin, std::min(begin + grain, n));
+			return;
+		}
+
+		std::atomic<size_t> remaining{ chunks };
+
+		// contiguous runs of chunks per queue, so without stealing every thread walks through memory in order
+		const size_t per_queue = (chunks + queues.size() - 1) / queues.size();
+		for (size_t q = 0; q < queues.size(); ++q) {
+			const size_t first = q * per_queue;
+			const size_t last = std::min(first + per_queue, chunks);
+			if (first >= last)
+				break;
+
+			std::lock_guard lock(queues[q]->mutex);
+			// the owner pops from the back, so push in reverse to start with the first chunk
+			for (size_t c = last; c-- > first;)
+				queues[q]->tasks.push_back(Task{ invoke, fn, c * grain, std::min((c + 1) * grain, n), &remaining });
+		}
+
+		{
+			std::lock_guard lock(sleep_mutex);
+			queued.fetch_add(chunks);
+		}
+		wake.notify_all();
+
+		Task task{};
+		while (remaining.load(std::memory_order_acquire) != 0) {
+			if (take(0, task))
+				execute(task);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	bool ThreadPool::pop(size_t q, Task& task) {
+		auto& queue = *queues[q];
+		std::lock_guard lock(queue.mutex);
+		if (queue.head == queue.tasks.size())
+			return false;
+
+		task = queue.tasks.back();
+		queue.tasks.pop_back();
+		if (queue.head == queue.tasks.size()) {
+			queue.tasks.clear();
+			queue.head = 0;
+		}
+		return true;
+	}
+
+	bool ThreadPool::steal(size_t thief, Task& task) {
+		for (size_t k = 1; k < queues.size(); ++k) {
+			auto& queue = *queues[(thief + k) % queues.size()];
+			std::lock_guard lock(queue.mutex);
+			if (queue.head == queue.tasks.size())
+				continue;
+
+			task = queue.tasks[queue.head++];
+			if (queue.head == queue.tasks.size()) {
+				queue.tasks.clear();
+				queue.head = 0;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	bool ThreadPool::take(size_t q, Task& task) {
+		if (pop(q, task) or steal(q, task)) {
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+		return false;
+	}
+
+	void ThreadPool::execute(const Task& task) {
+		task.invoke(task.fn, task.begin, task.end);
+		task.remaining->fetch_sub(1, std::memory_order_release);
+	}
+
+	void ThreadPool::worker_loop(size_t q) {
+		Task task{};
+		while (true) {
+			if (take(q, task)) {
+				execute(task);
+				continue;
+			}
+
+			std::unique_lock lock(sleep_mutex);
+			wake.wait(lock, [this] { return stopping or queued.load() != 0; });
+			if (stopping)
+				return;
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace phs
+{
+	// work stealing pool for data parallel loops
+	// every worker owns a queue of chunks, takes work from its back and steals from the front of the others,
+	// the thread calling parallel_for works on its own queue as well
+	class ThreadPool
+	{
+	public:
+		// total number of threads, including the one calling parallel_for
+		explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		size_t size()const;
+
+		// calls fn(begin, end) for consecutive chunks of [0, n), at most `grain` long, and waits for all of them
+		template<class F>
+		void parallel_for(size_t n, size_t grain, F&& fn) {
+			auto invoke = [](void* f, size_t begin, size_t end) { (*static_cast<std::remove_reference_t<F>*>(f))(begin, end); };
+			run(n, grain, invoke, const_cast<void*>(static_cast<const void*>(std::addressof(fn))));
+		}
+	private:
+		struct Task
+		{
+			void(*invoke)(void*, size_t, size_t);
+			void* fn;
+			size_t begin, end;
+			std::atomic<size_t>* remaining;
+		};
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::vector<Task> tasks;
+			size_t head{};
+		};
+
+		void run(size_t n, size_t grain, void(*invoke)(void*, size_t, size_t), void* fn);
+		bool pop(size_t queue, Task& task);
+		bool steal(size_t thief, Task& task);
+		bool take(size_t queue, Task& task);
+		void execute(const Task& task);
+		void worker_loop(size_t queue);
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> workers;
+
+		std::mutex sleep_mutex;
+		std::condition_variable wake;
+		std::atomic<size_t> queued{};
+		bool stopping = false;
+	};
+}
@@ -0,0 +1,77 @@
+#include "timestep.h"
+#include <algorithm>
+
+namespace phs
+{
+	FixedTimestep::FixedTimestep(double rate, size_t max_substeps)
+		: rate{ rate }, dt{ 1.0 / rate }, max_substeps{ std::max<size_t>(max_substeps, 1) }
+	{}
+
+	size_t FixedTimestep::take_steps(double frame_time) {
+		accumulator += std::max(frame_time, 0.0);
+		const size_t steps = std::min(size_t(accumulator / dt), max_substeps);
+		accumulator -= double(steps) * dt;
+		// a frame too slow to catch up with drops the rest, instead of making the next frame even slower
+		if (steps == max_substeps)
+			accumulator = std::min(accumulator, dt * 0.999);
+		return steps;
+	}
+
+	void FixedTimestep::keep_previous(const World& world) {
+		const size_t n = world.balls.size();
+		previous_x.assign(world.balls.x.begin(), world.balls.x.begin() + n);
+		previous_y.assign(world.balls.y.begin(), world.balls.y.begin() + n);
+		// by id, the same as WorldSnapshot::capture
+		const auto& ids = world.get_ball_ids();
+		const size_t renumbered = ids.size() <= n ? ids.size() : 0;
+		for (size_t i = 0; i < renumbered; ++i) {
+			previous_x[ids[i]] = world.balls.x[i];
+			previous_y[ids[i]] = world.balls.y[i];
+		}
+	}
+
+	size_t FixedTimestep::advance(World& world, double frame_time) {
+		return advance(world, frame_time, [](World& w, Float t) { w.step(t); });
+	}
+
+	size_t FixedTimestep::advance(World& world, double frame_time, ThreadPool& pool) {
+		return advance(world, frame_time, [&pool](World& w, Float t) { w.step(t, pool); });
+	}
+
+	double FixedTimestep::get_rate()const {
+		return rate;
+	}
+
+	void FixedTimestep::set_rate(double new_rate) {
+		// keeps the same share of a step in the accumulator
+		accumulator = accumulator / dt / new_rate;
+		rate = new_rate;
+		dt = 1.0 / new_rate;
+	}
+
+	size_t FixedTimestep::get_max_substeps()const {
+		return max_substeps;
+	}
+
+	void FixedTimestep::set_max_substeps(size_t new_max_substeps) {
+		max_substeps = std::max<size_t>(new_max_substeps, 1);
+	}
+
+	Float FixedTimestep::step_time()const {
+		return Float(dt);
+	}
+
+	Float FixedTimestep::alpha()const {
+		return Float(accumulator / dt);
+	}
+
+	Point FixedTimestep::interpolated_center(const World& world, size_t i)const {
+		const Point current = world.balls.center(i);
+		const size_t id = world.ball_id(i);
+		if (id >= previous_x.size())
+			return current;
+
+		const Float a = alpha();
+		return Point(previous_x[id] + (current.x - previous_x[id]) * a, previous_y[id] + (current.y - previous_y[id]) * a);
+	}
+}
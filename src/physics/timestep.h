@@ -0,0 +1,56 @@
+#pragma once
+#include "world.h"
+#include <vector>
+
+namespace phs
+{
+	// drives a World at a fixed physics rate from variable frame times
+	// the frame time goes into an accumulator that is spent in whole steps of 1 / rate, at most max_substeps per frame,
+	// whatever a slow frame leaves beyond that is dropped, so the physics cost of a frame stays bounded
+	// the renderer draws between the last two steps, `alpha` of the way from the previous state to the current one
+	class FixedTimestep
+	{
+	public:
+		explicit FixedTimestep(double rate = 120.0, size_t max_substeps = 8);
+
+		// returns the number of steps taken
+		size_t advance(World& world, double frame_time);
+		size_t advance(World& world, double frame_time, ThreadPool& pool);
+		// takes every step with step(world, dt), for callers that do more per step, like recording a replay
+		template<class Step>
+		size_t advance(World& world, double frame_time, Step&& step) {
+			const size_t steps = take_steps(frame_time);
+			for (size_t s = 0; s < steps; ++s) {
+				// only the state before the last step is needed for the interpolation
+				if (s + 1 == steps)
+					keep_previous(world);
+				step(world, Float(dt));
+			}
+			return steps;
+		}
+
+		double get_rate()const;
+		void set_rate(double rate);
+		size_t get_max_substeps()const;
+		void set_max_substeps(size_t max_substeps);
+
+		Float step_time()const;
+		// share of a step the accumulator holds after the last advance, in [0, 1)
+		Float alpha()const;
+
+		// the center of ball i between the last two steps, balls added since then are drawn where they are
+		// the previous centers are kept by ball id, so they still match when the last step reordered the balls
+		Point interpolated_center(const World& world, size_t i)const;
+	private:
+		size_t take_steps(double frame_time);
+		void keep_previous(const World& world);
+
+		double rate;
+		double dt;
+		size_t max_substeps;
+		double accumulator = 0.0;
+
+		std::vector<Float> previous_x{};
+		std::vector<Float> previous_y{};
+	};
+}
@@ -0,0 +1,269 @@
+#include "trajectory.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// the headers are written as they are in memory
+static_assert(std::endian::native == std::endian::little, "trajectories are little endian");
+
+namespace phs
+{
+	namespace
+	{
+		// at most 10 bytes for a 64 bit value
+		constexpr size_t max_varint = 10;
+
+		std::uint8_t* put_varint(std::uint8_t* out, std::uint64_t v) {
+			while (v >= 0x80) {
+				*out++ = std::uint8_t(v | 0x80);
+				v >>= 7;
+			}
+			*out++ = std::uint8_t(v);
+			return out;
+		}
+
+		std::uint64_t zigzag(std::int64_t v) {
+			return (std::uint64_t(v) << 1) ^ std::uint64_t(v >> 63);
+		}
+
+		std::int64_t unzigzag(std::uint64_t v) {
+			return std::int64_t(v >> 1) ^ -std::int64_t(v & 1);
+		}
+	}
+
+	TrajectoryRecorder::TrajectoryRecorder(const std::filesystem::path& path, size_t keyframe_interval, double position_step, double velocity_step)
+		: keyframe_interval{ std::max<size_t>(keyframe_interval, 1) }, position_step{ position_step }, velocity_step{ velocity_step },
+		file{ path, std::ios::binary | std::ios::trunc }
+	{
+		if (not file)
+			throw std::runtime_error("cannot create " + path.string());
+
+		trajectory::Header header{};
+		std::memcpy(header.magic, trajectory::magic, sizeof(header.magic));
+		header.version = trajectory::version;
+		header.keyframe_interval = std::uint32_t(this->keyframe_interval);
+		header.position_step = position_step;
+		header.velocity_step = velocity_step;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		writer = std::thread([this] { write_loop(); });
+	}
+
+	TrajectoryRecorder::~TrajectoryRecorder() {
+		try {
+			close();
+		}
+		catch (const std::runtime_error&) {
+			// a failed write can only be reported by an explicit close
+		}
+	}
+
+	size_t TrajectoryRecorder::frame_count()const {
+		return frames;
+	}
+
+	void TrajectoryRecorder::encode(const AlignedVector<Float>& values, const std::vector<std::uint32_t>& index_of, double step, std::int64_t* previous) {
+		const size_t n = current.header.ball_count;
+		const size_t used = current.bytes.size();
+		current.bytes.resize(used + n * max_varint);
+
+		std::uint8_t* out = current.bytes.data() + used;
+		const double scale = 1.0 / step;
+		// ids past the end of index_of were added after the last reorder and are their own index
+		for (size_t id = 0; id < n; ++id) {
+			const size_t i = id < index_of.size() ? index_of[id] : id;
+			const std::int64_t q = std::llrint(double(values[i]) * scale);
+			out = put_varint(out, zigzag(q - previous[id]));
+			previous[id] = q;
+		}
+		current.bytes.resize(size_t(out - current.bytes.data()));
+	}
+
+	void TrajectoryRecorder::record(const World& world) {
+		const size_t n = world.balls.size();
+		if (current.header.frame_count == keyframe_interval or (current.header.frame_count > 0 and n != current.header.ball_count)) {
+			if (finish_block())
+				throw std::runtime_error("cannot write the trajectory");
+		}
+
+		if (current.header.frame_count == 0) {
+			current.header.first_frame = frames;
+			current.header.ball_count = std::uint32_t(n);
+			previous.assign(4 * n, 0);
+		}
+
+		const auto& index_of = world.get_ball_indices();
+		encode(world.balls.x, index_of, position_step, previous.data());
+		encode(world.balls.y, index_of, position_step, previous.data() + n);
+		encode(world.balls.vx, index_of, velocity_step, previous.data() + 2 * n);
+		encode(world.balls.vy, index_of, velocity_step, previous.data() + 3 * n);
+		++current.header.frame_count;
+		++frames;
+	}
+
+	bool TrajectoryRecorder::finish_block() {
+		if (current.header.frame_count == 0)
+			return false;
+		current.header.byte_count = current.bytes.size();
+
+		bool write_failed = false;
+		{
+			std::lock_guard lock{ mutex };
+			write_failed = failed;
+			pending.push_back(std::move(current));
+			current = Block{};
+			// buffers come back from the writer, so a long recording stops allocating
+			if (not spare.empty()) {
+				current.bytes = std::move(spare.back());
+				spare.pop_back();
+			}
+		}
+		wake.notify_one();
+		return write_failed;
+	}
+
+	void TrajectoryRecorder::close() {
+		if (not writer.joinable())
+			return;
+		finish_block();
+		{
+			std::lock_guard lock{ mutex };
+			stopping = true;
+		}
+		wake.notify_one();
+		writer.join();
+
+		file.close();
+		if (failed or not file)
+			throw std::runtime_error("cannot write the trajectory");
+	}
+
+	void TrajectoryRecorder::write_loop() {
+		std::vector<Block> writing{};
+		for (;;) {
+			{
+				std::unique_lock lock{ mutex };
+				wake.wait(lock, [this] { return stopping or not pending.empty(); });
+				if (pending.empty())
+					return;
+				std::swap(writing, pending);
+			}
+
+			for (const Block& block : writing) {
+				file.write(reinterpret_cast<const char*>(&block.header), sizeof(block.header));
+				file.write(reinterpret_cast<const char*>(block.bytes.data()), std::streamsize(block.bytes.size()));
+			}
+
+			std::lock_guard lock{ mutex };
+			failed = failed or not file;
+			for (Block& block : writing) {
+				block.bytes.clear();
+				spare.push_back(std::move(block.bytes));
+			}
+			writing.clear();
+		}
+	}
+
+	TrajectoryReader::TrajectoryReader(const std::filesystem::path& path)
+		: file{ path, std::ios::binary }
+	{
+		if (not file)
+			throw std::runtime_error("cannot open " + path.string());
+		if (not file.read(reinterpret_cast<char*>(&header), sizeof(header)) or std::memcmp(header.magic, trajectory::magic, sizeof(header.magic)) != 0)
+			throw std::runtime_error(path.string() + " is not a trajectory");
+		if (header.version != trajectory::version)
+			throw std::runtime_error(path.string() + " is a trajectory of version " + std::to_string(header.version) + ", not " + std::to_string(trajectory::version));
+
+		// a block cut off at the end of the file is ignored, it is all a crash while recording can leave behind
+		const std::uint64_t file_size = std::filesystem::file_size(path);
+		std::uint64_t offset = sizeof(header);
+		std::uint64_t frame = 0;
+		trajectory::BlockHeader block_header{};
+		while (offset + sizeof(block_header) <= file_size) {
+			file.seekg(std::streamoff(offset));
+			file.read(reinterpret_cast<char*>(&block_header), sizeof(block_header));
+			const std::uint64_t end = offset + sizeof(block_header) + block_header.byte_count;
+			if (not file or end > file_size)
+				break;
+			if (block_header.first_frame != frame)
+				throw std::runtime_error(path.string() + " has a block starting at frame " + std::to_string(block_header.first_frame) + " instead of " + std::to_string(frame));
+			blocks.push_back(BlockEntry{ block_header, offset + sizeof(block_header) });
+			frame += block_header.frame_count;
+			offset = end;
+		}
+		file.clear();
+	}
+
+	size_t TrajectoryReader::frame_count()const {
+		return blocks.empty() ? 0 : size_t(blocks.back().header.first_frame + blocks.back().header.frame_count);
+	}
+
+	size_t TrajectoryReader::keyframe_interval()const {
+		return header.keyframe_interval;
+	}
+
+	void TrajectoryReader::load_block(size_t b) {
+		const BlockEntry& entry = blocks[b];
+		bytes.resize(size_t(entry.header.byte_count));
+		file.seekg(std::streamoff(entry.offset));
+		if (not file.read(reinterpret_cast<char*>(bytes.data()), std::streamsize(bytes.size())))
+			throw std::runtime_error("cannot read the trajectory");
+
+		block = b;
+		cursor = 0;
+		next_frame = size_t(entry.header.first_frame);
+		quantized.assign(4 * size_t(entry.header.ball_count), 0);
+	}
+
+	void TrajectoryReader::decode_frame() {
+		const std::uint8_t* in = bytes.data() + cursor;
+		const std::uint8_t* const end = bytes.data() + bytes.size();
+		for (std::int64_t& q : quantized) {
+			std::uint64_t v = 0;
+			for (unsigned shift = 0;; shift += 7) {
+				if (in == end or shift >= 64)
+					throw std::runtime_error("the trajectory is corrupt");
+				const std::uint8_t byte = *in++;
+				v |= std::uint64_t(byte & 0x7f) << shift;
+				if (byte < 0x80)
+					break;
+			}
+			q += unzigzag(v);
+		}
+		cursor = size_t(in - bytes.data());
+		++next_frame;
+	}
+
+	const TrajectoryFrame& TrajectoryReader::frame(size_t index) {
+		if (index >= frame_count())
+			throw std::out_of_range("frame " + std::to_string(index) + " of a trajectory of " + std::to_string(frame_count()));
+		if (index == current.index and block != size_t(-1) and next_frame == index + 1)
+			return current;
+
+		const auto it = std::upper_bound(blocks.begin(), blocks.end(), index,
+			[](size_t i, const BlockEntry& entry) { return i < entry.header.first_frame; });
+		const size_t b = size_t(it - blocks.begin()) - 1;
+		if (b != block or index < next_frame)
+			load_block(b);
+		while (next_frame <= index)
+			decode_frame();
+
+		// only the requested frame is converted, the frames skipped on the way stay quantized
+		const size_t n = quantized.size() / 4;
+		const auto convert = [&](std::vector<Float>& values, const std::int64_t* q, double step) {
+			values.resize(n);
+			for (size_t i = 0; i < n; ++i)
+				values[i] = Float(double(q[i]) * step);
+		};
+		convert(current.x, quantized.data(), header.position_step);
+		convert(current.y, quantized.data() + n, header.position_step);
+		convert(current.vx, quantized.data() + 2 * n, header.velocity_step);
+		convert(current.vy, quantized.data() + 3 * n, header.velocity_step);
+		current.index = index;
+		return current;
+	}
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "world.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace phs
+{
+	// trajectory files, the ball centers and velocities of every recorded step
+	//
+	// the file is a header followed by blocks of at most keyframe_interval frames, every block starts with a keyframe
+	// values are quantized to multiples of position_step and velocity_step, a frame stores for every ball the difference
+	// of its quantized x, y, vx and vy to the previous frame (to zero in a keyframe) as zigzag varints
+	// the quantized values are what is differenced, so the error stays below half a step however long the recording is
+	// a block is only written once it is complete, a recording cut short by a crash loses the frames of its last block
+	namespace trajectory
+	{
+		inline constexpr char magic[8] = { 'P', 'H', 'S', 'T', 'R', 'A', 'J', '\0' };
+		inline constexpr std::uint32_t version = 1;
+
+		struct Header
+		{
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t keyframe_interval;
+			double position_step;
+			double velocity_step;
+		};
+
+		struct BlockHeader
+		{
+			std::uint64_t first_frame;
+			std::uint32_t frame_count;
+			std::uint32_t ball_count;
+			// size of the frame data following the block header
+			std::uint64_t byte_count;
+		};
+	}
+
+	// records a world after every step, call record(world) right after world.step
+	// the balls are recorded in order of their ids, so a world reordering its balls still records each one in its own slot
+	// the frames are encoded on the calling thread and complete blocks are handed to a writer thread,
+	// so record never waits for the disk, a block whose ball count changes is ended early
+	class TrajectoryRecorder
+	{
+	public:
+		// throws std::runtime_error when the file cannot be created
+		explicit TrajectoryRecorder(const std::filesystem::path& path, size_t keyframe_interval = 120,
+			double position_step = 1.0 / 64.0, double velocity_step = 1.0 / 64.0);
+		~TrajectoryRecorder();
+
+		TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+		TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+		// throws std::runtime_error once a write of the writer thread failed
+		void record(const World& world);
+		// writes the last block and waits for the writer thread, throws std::runtime_error when a write failed
+		void close();
+
+		size_t frame_count()const;
+	private:
+		struct Block
+		{
+			trajectory::BlockHeader header;
+			std::vector<std::uint8_t> bytes;
+		};
+
+		// index_of maps the ids to the indices of the values, empty for a world that never reordered
+		void encode(const AlignedVector<Float>& values, const std::vector<std::uint32_t>& index_of, double step, std::int64_t* previous);
+		// hands the current block to the writer, returns whether an earlier write failed
+		bool finish_block();
+		void write_loop();
+
+		size_t keyframe_interval;
+		double position_step;
+		double velocity_step;
+		size_t frames = 0;
+
+		// the block being encoded and the quantized x, y, vx and vy of the last frame
+		Block current{};
+		std::vector<std::int64_t> previous{};
+
+		// only the writer thread touches the file once it runs
+		std::ofstream file;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::vector<Block> pending{};
+		std::vector<std::vector<std::uint8_t>> spare{};
+		bool stopping = false;
+		bool failed = false;
+		std::thread writer;
+	};
+
+	struct TrajectoryFrame
+	{
+		size_t index = 0;
+		std::vector<Float> x, y;
+		std::vector<Float> vx, vy;
+	};
+
+	// reads frames of a trajectory file in any order
+	// the next frame of the same block is decoded from the current one, any other frame from the keyframe of its block,
+	// so a seek costs at most keyframe_interval frames of decoding
+	class TrajectoryReader
+	{
+	public:
+		// throws std::runtime_error if the file is not a trajectory of this version
+		explicit TrajectoryReader(const std::filesystem::path& path);
+
+		size_t frame_count()const;
+		size_t keyframe_interval()const;
+
+		// throws std::out_of_range for frames past the end, the frame stays valid until the next call
+		const TrajectoryFrame& frame(size_t index);
+	private:
+		struct BlockEntry
+		{
+			trajectory::BlockHeader header;
+			std::uint64_t offset;
+		};
+
+		void load_block(size_t b);
+		void decode_frame();
+
+		std::ifstream file;
+		trajectory::Header header{};
+		std::vector<BlockEntry> blocks{};
+
+		size_t block = size_t(-1);
+		size_t cursor = 0;
+		size_t next_frame = 0;
+		std::vector<std::uint8_t> bytes{};
+		std::vector<std::int64_t> quantized{};
+		TrajectoryFrame current{};
+	};
+}
@@ -0,0 +1,706 @@
+#include "world.h"
+#include "narrow_phase.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <type_traits>
+
+namespace phs
+{
+	bool World::collide_static(size_t i, size_t j) {
+		auto ball_i = balls.load(i);
+		auto ball_j = balls.load(j);
+		if (not resolve_static_collision(ball_i, ball_j))
+			return false;
+
+		balls.store(i, ball_i);
+		balls.store(j, ball_j);
+		return true;
+	}
+
+	void World::collide_dynamic(size_t i, size_t j) {
+		auto ball_i = balls.load(i);
+		auto ball_j = balls.load(j);
+		resolve_dynamic_collision(ball_i, ball_j);
+		balls.store(i, ball_i);
+		balls.store(j, ball_j);
+	}
+
+	template<class Hit>
+	void World::collide_static_pairs(const Pair* pairs, size_t count, Hit&& hit) {
+		// a pair left out by the rejection is only tested again when a hit earlier in its block moved one of its balls,
+		// so the result is exactly that of calling collide_static on every pair in order
+		moved_stamp.resize(balls.size(), 0);
+		std::uint32_t kept[pair_block];
+		for (size_t begin = 0; begin < count; begin += pair_block) {
+			const size_t m = std::min(pair_block, count - begin);
+			const size_t kept_count = keep_overlapping_pairs(balls, pairs + begin, m, kept);
+			if (++block_stamp == 0) {
+				std::fill(moved_stamp.begin(), moved_stamp.end(), 0);
+				block_stamp = 1;
+			}
+
+			bool moved = false;
+			const auto collide = [&](size_t k) {
+				const auto [i, j] = pairs[begin + k];
+				if (collide_static(i, j)) {
+					moved_stamp[i] = moved_stamp[j] = block_stamp;
+					moved = true;
+					hit(begin + k);
+				}
+			};
+			size_t k = 0;
+			for (size_t s = 0; s <= kept_count; ++s) {
+				const size_t next = s < kept_count ? kept[s] : m;
+				for (; moved and k < next; ++k)
+					if (moved_stamp[pairs[begin + k].first] == block_stamp or moved_stamp[pairs[begin + k].second] == block_stamp)
+						collide(k);
+				if (s < kept_count)
+					collide(next);
+				k = next + 1;
+			}
+		}
+	}
+
+	void World::collide_walls_static(size_t begin, size_t end, std::vector<Pair>& cols) {
+		// a ball only moves on its own hits, so a ball no wall is near at the start goes through its queries without one
+		// and is left out, the others are queried and resolved as before
+		std::uint8_t near[ball_block];
+		for (size_t block = begin; block < end; block += ball_block) {
+			const size_t m = std::min(ball_block, end - block);
+			mark_balls_near_walls(walls, wall_tree, balls, block, m, near);
+			for (size_t k = 0; k < m; ++k) {
+				const size_t i = block + k;
+				if (not near[k] or balls.sleeping[i])
+					continue;
+				auto ball = balls.load(i);
+				// a hit moves the ball, so the tree is queried again from where it ended up for walls it now reaches,
+				// every wall is resolved once at most
+				std::uint32_t tested[max_ball_walls];
+				size_t tested_count = 0;
+				bool hit = false, moved = true, full = false;
+				for (size_t pass = 0; moved and not full; ++pass) {
+					moved = false;
+					wall_tree.query(ball.center.x, ball.center.y, ball.radius, [&](size_t j) {
+						if (pass > 0 and std::find(tested, tested + tested_count, std::uint32_t(j)) != tested + tested_count)
+							return;
+						if (tested_count < max_ball_walls)
+							tested[tested_count++] = std::uint32_t(j);
+						else
+							full = true;
+						if (resolve_static_collision(walls[j], ball)) {
+							cols.emplace_back(i, j);
+							hit = moved = true;
+						}
+					});
+				}
+				if (hit)
+					balls.store(i, ball);
+			}
+		}
+	}
+
+	void World::collide_walls_dynamic(const std::vector<Pair>& cols) {
+		for (auto [i, wall_j] : cols) {
+			auto ball = balls.load(i);
+			resolve_dynamic_collision(walls[wall_j], ball);
+			balls.store(i, ball);
+		}
+	}
+
+	void World::update_walls() {
+		tree_walls = walls;
+		wall_tree.build(walls);
+	}
+
+	bool World::walls_changed()const {
+		// walls are plain scalars without padding, so equal walls have equal bytes
+		static_assert(std::is_trivially_copyable_v<Wall> and sizeof(Wall) == 5 * sizeof(Float));
+		return walls.size() != tree_walls.size()
+			or (not walls.empty() and std::memcmp(walls.data(), tree_walls.data(), walls.size() * sizeof(Wall)) != 0);
+	}
+
+	void World::sweep() {
+		const size_t n = balls.size();
+		const Float shrink = Float(1) - impact_skin;
+
+		fast_balls.clear();
+		for (size_t i = 0; i < n; ++i) {
+			const Vector motion(balls.x[i] - start_x[i], balls.y[i] - start_y[i]);
+			if (length2(motion) > balls.radius[i] * balls.radius[i])
+				fast_balls.push_back(i);
+		}
+		if (fast_balls.empty())
+			return;
+
+		// walls first, every ball is cut back to its own first wall contact
+		for (size_t i : fast_balls) {
+			const Circle circle(Point(start_x[i], start_y[i]), balls.radius[i] * shrink);
+			const Vector motion(balls.x[i] - start_x[i], balls.y[i] - start_y[i]);
+
+			Float t_min = Float(1);
+			wall_tree.query(
+				std::min(start_x[i], balls.x[i]) - balls.radius[i], std::min(start_y[i], balls.y[i]) - balls.radius[i],
+				std::max(start_x[i], balls.x[i]) + balls.radius[i], std::max(start_y[i], balls.y[i]) + balls.radius[i],
+				[&](size_t j) {
+					if (const auto t = time_of_impact(circle, motion, walls[j]))
+						t_min = std::min(t_min, *t);
+				});
+			balls.x[i] = start_x[i] + motion.x * t_min;
+			balls.y[i] = start_y[i] + motion.y * t_min;
+		}
+
+		// then the balls along what is left of the paths, so a ball following another one into a wall stops behind it
+		// the grid holds the centers at the end of these paths and a slow ball moved less than half a cell,
+		// so growing the swept box by one cell finds every slow ball the fast one can reach
+		// (two fast balls are only tested against each other when one ends up near the path of the other)
+		grid.build(balls);
+		impact.assign(n, Float(1));
+		const Float cell = grid.get_cell_size();
+
+		for (size_t i : fast_balls) {
+			const Circle circle(Point(start_x[i], start_y[i]), balls.radius[i] * shrink);
+			const Vector motion(balls.x[i] - start_x[i], balls.y[i] - start_y[i]);
+
+			grid.query(
+				std::min(start_x[i], balls.x[i]) - cell, std::min(start_y[i], balls.y[i]) - cell,
+				std::max(start_x[i], balls.x[i]) + cell, std::max(start_y[i], balls.y[i]) + cell,
+				[&](size_t j) {
+					if (j == i)
+						return;
+					const Circle other(Point(start_x[j], start_y[j]), balls.radius[j] * shrink);
+					const Vector other_motion(balls.x[j] - start_x[j], balls.y[j] - start_y[j]);
+					if (const auto t = time_of_impact(circle, motion, other, other_motion)) {
+						impact[i] = std::min(impact[i], *t);
+						impact[j] = std::min(impact[j], *t);
+					}
+				});
+		}
+
+		for (size_t i = 0; i < n; ++i) {
+			if (impact[i] < Float(1)) {
+				balls.x[i] = start_x[i] + (balls.x[i] - start_x[i]) * impact[i];
+				balls.y[i] = start_y[i] + (balls.y[i] - start_y[i]) * impact[i];
+			}
+		}
+	}
+
+	void World::step(Float dt) {
+		PHS_PROFILE_SCOPE(profiler, Stage::step);
+		if (walls_changed())
+			update_walls();
+		reorder_if_due();
+
+		{
+			PHS_PROFILE_SCOPE(profiler, Stage::integrate);
+			if (continuous) {
+				start_x.assign(balls.x.begin(), balls.x.begin() + balls.size());
+				start_y.assign(balls.y.begin(), balls.y.begin() + balls.size());
+			}
+
+			wake_pushed_balls();
+			integrate_balls(dt, 0, balls.padded_size());
+			clear_padding(balls);
+		}
+		if (continuous) {
+			PHS_PROFILE_SCOPE(profiler, Stage::sweep);
+			sweep();
+		}
+
+		ball_ball_cols.clear();
+		ball_wall_cols.clear();
+
+		{
+			PHS_PROFILE_SCOPE(profiler, Stage::broad_phase);
+			pair_finder().build(balls);
+			candidate_pairs.clear();
+			find_candidate_pairs(0, balls.size(), candidate_pairs);
+		}
+
+		if (use_solver) {
+			PHS_PROFILE_SCOPE(profiler, Stage::resolution);
+			solver.solve(balls, walls, wall_tree, candidate_pairs, ball_ball_cols, ball_wall_cols);
+		}
+		else {
+			{
+				PHS_PROFILE_SCOPE(profiler, Stage::narrow_phase);
+				// the narrow phase works on Ball objects, pairs are loaded from the arrays and stored back on a hit
+				collide_static_pairs(candidate_pairs.data(), candidate_pairs.size(), [&](size_t k) {
+					ball_ball_cols.push_back(candidate_pairs[k]);
+				});
+
+				collide_walls_static(0, balls.size(), ball_wall_cols);
+			}
+
+			PHS_PROFILE_SCOPE(profiler, Stage::resolution);
+			for (auto [i, j] : ball_ball_cols)
+				collide_dynamic(i, j);
+
+			collide_walls_dynamic(ball_wall_cols);
+		}
+		{
+			PHS_PROFILE_SCOPE(profiler, Stage::sleep);
+			update_sleep(dt);
+		}
+		count_contacts();
+	}
+
+	void World::color_pairs() {
+		// greedy coloring in pair order, each color is a set of pairs with no ball in common
+		// pairs of balls that already used every color go to the last group, which runs on one thread
+		constexpr size_t colors = 64;
+
+		ball_colors.assign(balls.size(), 0);
+		pair_color.resize(candidate_pairs.size());
+		color_start.assign(colors + 2, 0);
+
+		for (size_t k = 0; k < candidate_pairs.size(); ++k) {
+			const auto [i, j] = candidate_pairs[k];
+			const std::uint64_t free = ~(ball_colors[i] | ball_colors[j]);
+			const size_t c = free != 0 ? size_t(std::countr_zero(free)) : colors;
+			if (c < colors) {
+				ball_colors[i] |= std::uint64_t(1) << c;
+				ball_colors[j] |= std::uint64_t(1) << c;
+			}
+			pair_color[k] = std::uint8_t(c);
+			color_start[c + 1] += 1;
+		}
+
+		for (size_t c = 0; c <= colors; ++c)
+			color_start[c + 1] += color_start[c];
+
+		colored_pairs.resize(candidate_pairs.size());
+		color_fill.assign(color_start.begin(), color_start.end() - 1);
+		for (size_t k = 0; k < candidate_pairs.size(); ++k)
+			colored_pairs[color_fill[pair_color[k]]++] = candidate_pairs[k];
+	}
+
+	void World::step(Float dt, ThreadPool& pool) {
+		PHS_PROFILE_SCOPE(profiler, Stage::step);
+		// every split below depends only on the ball and pair counts, never on the number of threads,
+		// and no two threads ever touch the same ball, so the result is the same for any pool size
+		const size_t n = balls.size();
+		const size_t chunks = (n + parallel_chunk - 1) / parallel_chunk;
+
+		if (walls_changed())
+			update_walls();
+		reorder_if_due();
+
+		{
+			PHS_PROFILE_SCOPE(profiler, Stage::integrate);
+			if (continuous) {
+				start_x.assign(balls.x.begin(), balls.x.begin() + n);
+				start_y.assign(balls.y.begin(), balls.y.begin() + n);
+			}
+
+			wake_pushed_balls();
+			pool.parallel_for(balls.padded_size(), parallel_chunk, [&](size_t begin, size_t end) {
+				integrate_balls(dt, begin, end);
+			});
+			clear_padding(balls);
+		}
+
+		// rare and cheap without fast balls, so it stays on one thread
+		if (continuous) {
+			PHS_PROFILE_SCOPE(profiler, Stage::sweep);
+			sweep();
+		}
+
+		{
+			PHS_PROFILE_SCOPE(profiler, Stage::broad_phase);
+			pair_finder().build(balls);
+			chunk_cols.resize(chunks);
+			pool.parallel_for(n, parallel_chunk, [&](size_t begin, size_t end) {
+				auto& pairs = chunk_cols[begin / parallel_chunk];
+				pairs.clear();
+				find_candidate_pairs(begin, end, pairs);
+			});
+
+			size_t found = 0;
+			for (const auto& pairs : chunk_cols)
+				found += pairs.size();
+			candidate_pairs.clear();
+			reserve_doubling(candidate_pairs, found);
+			for (const auto& pairs : chunk_cols)
+				candidate_pairs.insert(candidate_pairs.end(), pairs.begin(), pairs.end());
+		}
+
+		if (use_solver) {
+			ball_ball_cols.clear();
+			ball_wall_cols.clear();
+			{
+				PHS_PROFILE_SCOPE(profiler, Stage::resolution);
+				solver.solve(balls, walls, wall_tree, candidate_pairs, ball_ball_cols, ball_wall_cols);
+			}
+			{
+				PHS_PROFILE_SCOPE(profiler, Stage::sleep);
+				update_sleep(dt);
+			}
+			count_contacts();
+			return;
+		}
+
+		size_t colors = 0;
+		{
+			PHS_PROFILE_SCOPE(profiler, Stage::narrow_phase);
+			color_pairs();
+			pair_hit.clear();
+			reserve_doubling(pair_hit, colored_pairs.size());
+			pair_hit.resize(colored_pairs.size(), 0);
+
+			colors = color_start.size() - 2;
+			for (size_t c = 0; c < colors; ++c) {
+				const size_t first = color_start[c];
+				pool.parallel_for(color_start[c + 1] - first, parallel_pair_chunk, [&](size_t begin, size_t end) {
+					// no two pairs of a color share a ball, so no hit moves a ball of a pair the rejection left out
+					std::uint32_t kept[pair_block];
+					for (size_t block = first + begin; block < first + end; block += pair_block) {
+						const size_t kept_count = keep_overlapping_pairs(balls, colored_pairs.data() + block, std::min(pair_block, first + end - block), kept);
+						for (size_t s = 0; s < kept_count; ++s) {
+							const size_t k = block + kept[s];
+							pair_hit[k] = collide_static(colored_pairs[k].first, colored_pairs[k].second);
+						}
+					}
+				});
+			}
+			const size_t last = color_start[colors];
+			collide_static_pairs(colored_pairs.data() + last, colored_pairs.size() - last, [&](size_t k) {
+				pair_hit[last + k] = 1;
+			});
+
+			pool.parallel_for(n, parallel_chunk, [&](size_t begin, size_t end) {
+				auto& cols = chunk_cols[begin / parallel_chunk];
+				cols.clear();
+				collide_walls_static(begin, end, cols);
+			});
+		}
+
+		{
+			PHS_PROFILE_SCOPE(profiler, Stage::resolution);
+			for (size_t c = 0; c < colors; ++c) {
+				const size_t first = color_start[c];
+				pool.parallel_for(color_start[c + 1] - first, parallel_pair_chunk, [&](size_t begin, size_t end) {
+					for (size_t k = first + begin; k < first + end; ++k)
+						if (pair_hit[k])
+							collide_dynamic(colored_pairs[k].first, colored_pairs[k].second);
+				});
+			}
+			for (size_t k = color_start[colors]; k < colored_pairs.size(); ++k)
+				if (pair_hit[k])
+					collide_dynamic(colored_pairs[k].first, colored_pairs[k].second);
+
+			pool.parallel_for(n, parallel_chunk, [&](size_t begin, size_t) {
+				collide_walls_dynamic(chunk_cols[begin / parallel_chunk]);
+			});
+
+			ball_ball_cols.clear();
+			for (size_t k = 0; k < colored_pairs.size(); ++k)
+				if (pair_hit[k])
+					ball_ball_cols.push_back(colored_pairs[k]);
+
+			size_t hits = 0;
+			for (const auto& cols : chunk_cols)
+				hits += cols.size();
+			ball_wall_cols.clear();
+			reserve_doubling(ball_wall_cols, hits);
+			for (const auto& cols : chunk_cols)
+				ball_wall_cols.insert(ball_wall_cols.end(), cols.begin(), cols.end());
+		}
+
+		{
+			PHS_PROFILE_SCOPE(profiler, Stage::sleep);
+			update_sleep(dt);
+		}
+		count_contacts();
+	}
+
+	void World::count_contacts() {
+		PHS_PROFILE_COUNT(profiler, Counter::balls, balls.size());
+		PHS_PROFILE_COUNT(profiler, Counter::sleeping_balls, asleep);
+		PHS_PROFILE_COUNT(profiler, Counter::candidate_pairs, candidate_pairs.size());
+		PHS_PROFILE_COUNT(profiler, Counter::ball_ball_cols, ball_ball_cols.size());
+		PHS_PROFILE_COUNT(profiler, Counter::ball_wall_cols, ball_wall_cols.size());
+	}
+
+	void World::integrate_balls(Float dt, size_t begin, size_t end) {
+		if (asleep > 0)
+			integrate_awake(balls, begin, end, dt, gravity);
+		else
+			integrate(balls, begin, end, dt, gravity);
+	}
+
+	BroadPhase& World::pair_finder() {
+		switch (broad_phase) {
+		case BroadPhaseKind::sweep_and_prune: return sweep_and_prune;
+		case BroadPhaseKind::hierarchical_grid: return hierarchical_grid;
+		default: return grid;
+		}
+	}
+
+	const BroadPhase& World::pair_finder()const {
+		switch (broad_phase) {
+		case BroadPhaseKind::sweep_and_prune: return sweep_and_prune;
+		case BroadPhaseKind::hierarchical_grid: return hierarchical_grid;
+		default: return grid;
+		}
+	}
+
+	void World::find_candidate_pairs(size_t begin, size_t end, std::vector<Pair>& pairs)const {
+		const BroadPhase& finder = pair_finder();
+		if (asleep > 0)
+			finder.find_awake_pairs(begin, end, balls.sleeping, pairs);
+		else
+			finder.find_pairs(begin, end, pairs);
+	}
+
+	const SweepAndPrune& World::get_sweep_and_prune()const {
+		return sweep_and_prune;
+	}
+
+	// distance along the Hilbert curve through a 65536 x 65536 grid, neighbors on the curve are neighbors in the grid
+	static std::uint32_t hilbert_index(std::uint32_t x, std::uint32_t y) {
+		std::uint32_t d = 0;
+		for (std::uint32_t s = 1u << 15; s > 0; s >>= 1) {
+			const std::uint32_t rx = (x & s) != 0 ? 1 : 0;
+			const std::uint32_t ry = (y & s) != 0 ? 1 : 0;
+			d += s * s * ((3 * rx) ^ ry);
+			// turns the quadrant so the curve enters and leaves it at the right corners
+			if (ry == 0) {
+				if (rx == 1) {
+					x = 0xffff - x;
+					y = 0xffff - y;
+				}
+				std::swap(x, y);
+			}
+		}
+		return d;
+	}
+
+	void World::reorder_if_due() {
+		if (reorder_interval > 0 and ++steps_since_reorder >= reorder_interval) {
+			PHS_PROFILE_SCOPE(profiler, Stage::reorder);
+			reorder_balls();
+		}
+	}
+
+	void World::reorder_balls() {
+		const size_t n = balls.size();
+		steps_since_reorder = 0;
+		if (n < 2)
+			return;
+
+		// the keys are computed in double, so a fixed point Float does not overflow on the scaled coordinates
+		double min_x = double(balls.x[0]), max_x = min_x, min_y = double(balls.y[0]), max_y = min_y;
+		for (size_t i = 1; i < n; ++i) {
+			min_x = std::min(min_x, double(balls.x[i]));
+			max_x = std::max(max_x, double(balls.x[i]));
+			min_y = std::min(min_y, double(balls.y[i]));
+			max_y = std::max(max_y, double(balls.y[i]));
+		}
+		const double extent = std::max(max_x - min_x, max_y - min_y);
+		const double scale = extent > 0.0 ? 65535.0 / extent : 0.0;
+
+		reorder_keys.resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			const auto qx = std::uint32_t((double(balls.x[i]) - min_x) * scale);
+			const auto qy = std::uint32_t((double(balls.y[i]) - min_y) * scale);
+			reorder_keys[i] = std::uint64_t(hilbert_index(qx, qy)) << 32 | i;
+		}
+		// the index breaks ties, so the order is the same on every platform
+		std::sort(reorder_keys.begin(), reorder_keys.end());
+
+		reorder_order.resize(n);
+		new_index.resize(n);
+		bool moved = false;
+		for (size_t k = 0; k < n; ++k) {
+			reorder_order[k] = std::uint32_t(reorder_keys[k]);
+			new_index[reorder_order[k]] = std::uint32_t(k);
+			moved = moved or reorder_order[k] != k;
+		}
+		if (not moved)
+			return;
+
+		balls.permute(reorder_order);
+
+		// balls added since the last reorder are their own ids
+		if (ids.size() > n)
+			ids.clear();
+		for (size_t i = ids.size(); i < n; ++i)
+			ids.push_back(std::uint32_t(i));
+		spare_indices.resize(n);
+		for (size_t k = 0; k < n; ++k)
+			spare_indices[k] = ids[reorder_order[k]];
+		ids.swap(spare_indices);
+		slots.resize(n);
+		for (size_t k = 0; k < n; ++k)
+			slots[ids[k]] = std::uint32_t(k);
+
+		// the sleep state goes with the balls, an island is named after one of its balls, so the names move as well
+		if (not rest_time.empty()) {
+			rest_time.resize(n, Float(0));
+			spare_rest_time.resize(n);
+			for (size_t k = 0; k < n; ++k)
+				spare_rest_time[k] = rest_time[reorder_order[k]];
+			rest_time.swap(spare_rest_time);
+		}
+		if (not island.empty()) {
+			island.resize(n, 0);
+			for (size_t k = 0; k < n; ++k)
+				spare_indices[k] = new_index[island[reorder_order[k]]];
+			island.swap(spare_indices);
+		}
+
+		for (auto& [i, j] : ball_ball_cols) {
+			i = new_index[i];
+			j = new_index[j];
+		}
+		for (auto& col : ball_wall_cols)
+			col.first = new_index[col.first];
+		solver.remap_balls(new_index);
+		sweep_and_prune.reset();
+	}
+
+	size_t World::ball_index(size_t id)const {
+		return id < slots.size() ? slots[id] : id;
+	}
+
+	size_t World::ball_id(size_t i)const {
+		return i < ids.size() ? ids[i] : i;
+	}
+
+	const std::vector<std::uint32_t>& World::get_ball_ids()const {
+		return ids;
+	}
+
+	const std::vector<std::uint32_t>& World::get_ball_indices()const {
+		return slots;
+	}
+
+	void World::wake(size_t i) {
+		if (not balls.sleeping[i])
+			return;
+		islands_to_wake.clear();
+		islands_to_wake.push_back(island[i]);
+		wake_islands();
+	}
+
+	size_t World::sleeping_count()const {
+		return asleep;
+	}
+
+	void World::wake_pushed_balls() {
+		if (asleep == 0)
+			return;
+
+		// a ball given an acceleration while asleep was pushed by hand, or everything wakes when sleeping was turned off
+		islands_to_wake.clear();
+		for (size_t i = 0; i < balls.size(); ++i)
+			if (balls.sleeping[i] and (not allow_sleeping or balls.ax[i] != Float(0) or balls.ay[i] != Float(0)))
+				islands_to_wake.push_back(island[i]);
+		wake_islands();
+	}
+
+	void World::wake_islands() {
+		if (islands_to_wake.empty())
+			return;
+
+		std::sort(islands_to_wake.begin(), islands_to_wake.end());
+		islands_to_wake.erase(std::unique(islands_to_wake.begin(), islands_to_wake.end()), islands_to_wake.end());
+		for (size_t i = 0; i < balls.size(); ++i) {
+			if (balls.sleeping[i] and std::binary_search(islands_to_wake.begin(), islands_to_wake.end(), island[i])) {
+				balls.sleeping[i] = 0;
+				rest_time[i] = Float(0);
+				asleep -= 1;
+			}
+		}
+		islands_to_wake.clear();
+	}
+
+	std::uint32_t World::find_island(std::uint32_t i) {
+		// path halving keeps the trees flat
+		while (island_parent[i] != i) {
+			island_parent[i] = island_parent[island_parent[i]];
+			i = island_parent[i];
+		}
+		return i;
+	}
+
+	void World::update_sleep(Float dt) {
+		if (not allow_sleeping)
+			return;
+
+		const size_t n = balls.size();
+		rest_time.resize(n, Float(0));
+		island.resize(n, 0);
+
+		// a contact between an awake and a sleeping ball wakes the island of the sleeping one
+		islands_to_wake.clear();
+		for (auto [i, j] : ball_ball_cols) {
+			if (balls.sleeping[i] != balls.sleeping[j])
+				islands_to_wake.push_back(island[balls.sleeping[i] ? i : j]);
+		}
+		wake_islands();
+
+		const Float speed2 = sleep_speed * sleep_speed;
+		for (size_t i = 0; i < n; ++i) {
+			if (not balls.sleeping[i])
+				rest_time[i] = balls.vx[i] * balls.vx[i] + balls.vy[i] * balls.vy[i] < speed2 ? rest_time[i] + dt : Float(0);
+		}
+
+		// islands are the connected groups of awake balls touching each other, walls do not connect them
+		island_parent.resize(n);
+		for (size_t i = 0; i < n; ++i)
+			island_parent[i] = std::uint32_t(i);
+		for (auto [i, j] : ball_ball_cols) {
+			const auto a = find_island(std::uint32_t(i));
+			const auto b = find_island(std::uint32_t(j));
+			island_parent[std::max(a, b)] = std::min(a, b);
+		}
+
+		island_rest.assign(n, std::numeric_limits<Float>::max());
+		for (size_t i = 0; i < n; ++i) {
+			if (not balls.sleeping[i]) {
+				const auto root = find_island(std::uint32_t(i));
+				island_rest[root] = std::min(island_rest[root], rest_time[i]);
+			}
+		}
+
+		for (size_t i = 0; i < n; ++i) {
+			if (balls.sleeping[i])
+				continue;
+			const auto root = find_island(std::uint32_t(i));
+			if (island_rest[root] >= time_to_sleep) {
+				balls.sleeping[i] = 1;
+				balls.vx[i] = balls.vy[i] = Float(0);
+				balls.ax[i] = balls.ay[i] = Float(0);
+				island[i] = root;
+				asleep += 1;
+			}
+		}
+	}
+
+	void add_box_scene(World& world, const Point& middle, Float w, Float h, size_t ball_count, unsigned seed) {
+		std::mt19937 gen(seed);
+		// the balls are placed in float for every Float, so all builds start from the same scene
+		// (and a fixed point Float does not round distinct random numbers onto the same spot)
+		std::uniform_real_distribution<float> dis(0.f, 1.f);
+		const float mx = float(middle.x), my = float(middle.y), wf = float(w), hf = float(h);
+
+		world.balls.reserve(world.balls.size() + ball_count);
+		for (size_t n = 0; n < ball_count; ++n) {
+			const float radius = 5.f + dis(gen) * 25.f;
+			const float x0 = mx + wf - 2.f * dis(gen) * 0.9f * wf;
+			const float y0 = my + hf - 2.f * dis(gen) * 0.9f * hf;
+			world.balls.push_back(Ball(Point{ Float(x0), Float(y0) }, Float(radius), Float(radius)));
+		}
+
+		world.walls.emplace_back(middle + Vector(Float(-0.1) * w, Float(10)), middle + Vector(Float(0.1) * w, Float(50)), Float(5));
+
+		world.walls.emplace_back(middle + Vector(-w, h), middle + Vector(w, h), Float(10));
+		world.walls.emplace_back(middle + Vector(-w, -h), middle + Vector(w, -h), Float(10));
+		world.walls.emplace_back(middle + Vector(-w, h), middle + Vector(-w, -h), Float(10));
+		world.walls.emplace_back(middle + Vector(w, h), middle + Vector(w, -h), Float(10));
+	}
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include "physics.h"
+#include "ball_storage.h"
+#include "broad_phase.h"
+#include "contact_solver.h"
+#include "profiler.h"
+#include "thread_pool.h"
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace phs
+{
+	class SnapshotView;
+
+	// simulation state and step logic, independent of any window or renderer
+	class World
+	{
+	public:
+		BallStorage balls{};
+		// the wall tree is rebuilt by the next step whenever the walls differ from those it was built from,
+		// so walls can be added, removed or moved in place
+		std::vector<Wall> walls{};
+		Vector gravity{ Float(0), Float(100) };
+
+		// time of impact mode: a ball moving further than its radius in one step is stopped at its first contact
+		// with a wall or another ball, so a large dt no longer lets fast balls tunnel through thin walls
+		// the rest of that step is dropped, the contact itself is then resolved as usual
+		bool continuous = false;
+
+		// resolves the contacts with the sequential impulse solver instead of the single static and dynamic pass,
+		// which settles dense piles, its iteration counts and correction factors are set on `solver`
+		// the parallel step finds the pairs on the pool and runs the solver on the calling thread
+		bool use_solver = false;
+		ContactSolver solver{};
+
+		// sleeping: islands of touching balls that all moved slower than sleep_speed for time_to_sleep seconds are put
+		// to sleep, their balls are no longer integrated or tested against each other or the walls
+		// a contact with an awake ball or a nonzero acceleration (an impulse) wakes the whole island again
+		bool allow_sleeping = false;
+		Float sleep_speed = Float(15);
+		Float time_to_sleep = Float(0.5);
+
+		// wakes the island of ball i, call it after moving a sleeping ball or changing its velocity
+		void wake(size_t i);
+		size_t sleeping_count()const;
+
+		// how the step finds its candidate pairs: the uniform grid, the sort and sweep kept sorted across steps or the
+		// hierarchical grid for widely varying radii, they find the same contacts but resolve them in a different order,
+		// so their results differ
+		// continuous mode sweeps its fast balls through the grid whichever is picked
+		BroadPhaseKind broad_phase = BroadPhaseKind::grid;
+		// the sort and sweep with the pairs it added and removed in the last step, when it is the broad phase
+		const SweepAndPrune& get_sweep_and_prune()const;
+
+		// every reorder_interval steps the ball arrays are sorted along a Hilbert curve through the ball centers before
+		// the step, so balls close in space are close in memory and the pairs of a step touch far fewer cache lines,
+		// 0 never reorders
+		// a reorder moves balls to new indices and changes the order the pairs are resolved in, so the results differ
+		// from a world that is not reordered, every ball keeps its id (its index before the first reorder) though,
+		// a caller holding on to a ball across steps holds its id and looks up its index with ball_index
+		size_t reorder_interval = 0;
+		// reorders now, whatever the interval
+		void reorder_balls();
+		size_t ball_index(size_t id)const;
+		size_t ball_id(size_t i)const;
+		// the id of every ball by index and the index of every ball by id, both empty until the first reorder moved a ball,
+		// balls added since have their index as id
+		const std::vector<std::uint32_t>& get_ball_ids()const;
+		const std::vector<std::uint32_t>& get_ball_indices()const;
+
+		// times the stages of every step into this profiler and sets its contact counters, null turns it off
+		// with the solver the narrow phase runs inside it, so it is all timed as resolution
+		Profiler* profiler = nullptr;
+
+		// collisions found during the last step
+		std::vector<Pair> ball_ball_cols{};
+		std::vector<Pair> ball_wall_cols{};
+
+		void step(Float dt);
+		// the same step split across the pool, bit identical for every pool size
+		// (though not to the single threaded step, the pairs are resolved in a different order)
+		void step(Float dt, ThreadPool& pool);
+
+		// rebuilds the wall tree now instead of at the next step
+		void update_walls();
+	private:
+		friend void save_snapshot(const World& world, const std::filesystem::path& path);
+		friend void load_snapshot(World& world, const SnapshotView& snapshot);
+
+		static constexpr size_t parallel_chunk = 4096;
+		static constexpr size_t parallel_pair_chunk = 2048;
+
+		bool collide_static(size_t i, size_t j);
+		// collide_static over the pairs in order, after the batched rejection of keep_overlapping_pairs, calls hit(k)
+		// for every pair k that collided
+		template<class Hit>
+		void collide_static_pairs(const Pair* pairs, size_t count, Hit&& hit);
+		void collide_dynamic(size_t i, size_t j);
+		void collide_walls_static(size_t begin, size_t end, std::vector<Pair>& cols);
+		bool walls_changed()const;
+		void collide_walls_dynamic(const std::vector<Pair>& cols);
+		void color_pairs();
+		void sweep();
+		void integrate_balls(Float dt, size_t begin, size_t end);
+		BroadPhase& pair_finder();
+		const BroadPhase& pair_finder()const;
+		void find_candidate_pairs(size_t begin, size_t end, std::vector<Pair>& pairs)const;
+		void wake_pushed_balls();
+		void wake_islands();
+		void update_sleep(Float dt);
+		std::uint32_t find_island(std::uint32_t i);
+		// sets the counters of the profiler after a step
+		void count_contacts();
+		void reorder_if_due();
+
+		// the swept tests run on slightly shrunken circles, so a ball stopped at its time of impact
+		// overlaps by this share of its radius and the overlap tests of the same step see the contact
+		static constexpr Float impact_skin = Float(0.05);
+
+		// the balls moved by a hit in the current block of collide_static_pairs carry its stamp
+		std::vector<std::uint32_t> moved_stamp{};
+		std::uint32_t block_stamp = 0;
+
+		UniformGrid grid{};
+		SweepAndPrune sweep_and_prune{};
+		HierarchicalGrid hierarchical_grid{};
+		WallTree wall_tree{};
+		// the walls wall_tree was built from, compared with `walls` at the start of every step
+		std::vector<Wall> tree_walls{};
+		// walls a ball is resolved against in one step at most, past them its position is no longer queried again
+		static constexpr size_t max_ball_walls = 32;
+		std::vector<Pair> candidate_pairs{};
+
+		// continuous mode, centers before the integration and the earliest time of impact of every ball
+		std::vector<Float> start_x{};
+		std::vector<Float> start_y{};
+		std::vector<Float> impact{};
+		std::vector<size_t> fast_balls{};
+
+		// sleeping, how long every ball has been slow, the island a sleeping ball went to sleep with,
+		// union find parents over this step's contacts and the shortest rest time of every island
+		size_t asleep = 0;
+		std::vector<Float> rest_time{};
+		std::vector<std::uint32_t> island{};
+		std::vector<std::uint32_t> island_parent{};
+		std::vector<Float> island_rest{};
+		std::vector<std::uint32_t> islands_to_wake{};
+
+		// reordering, steps since the last reorder, the id of every index and the index of every id,
+		// the sort keys with the old index in their low half, the old index of every new one and the new index of every old one
+		size_t steps_since_reorder = 0;
+		std::vector<std::uint32_t> ids{};
+		std::vector<std::uint32_t> slots{};
+		std::vector<std::uint64_t> reorder_keys{};
+		std::vector<std::uint32_t> reorder_order{};
+		std::vector<std::uint32_t> new_index{};
+		std::vector<std::uint32_t> spare_indices{};
+		std::vector<Float> spare_rest_time{};
+
+		// parallel step, candidate pairs grouped by color and per chunk pair lists
+		std::vector<std::uint64_t> ball_colors{};
+		std::vector<std::uint8_t> pair_color{};
+		std::vector<size_t> color_start{};
+		std::vector<size_t> color_fill{};
+		std::vector<Pair> colored_pairs{};
+		std::vector<std::uint8_t> pair_hit{};
+		std::vector<std::vector<Pair>> chunk_cols{};
+	};
+
+	// the demo scene: a box of four walls, one slanted wall in the middle and randomly placed balls
+	void add_box_scene(World& world, const Point& middle, Float half_width, Float half_height, size_t ball_count, unsigned seed);
+}
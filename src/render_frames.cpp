@@ -0,0 +1,146 @@
+// steps the demo scene and renders every frame with the software rasterizer, no window or GPU needed
+// usage: render_frames [balls] [frames] [width] [height] [output] [threads] [simulation rate]
+// output is a printf pattern for the frame number ending in .png or .ppm, like frames/%05d.png,
+// or - for raw RGBA frames on stdout:
+//   render_frames 100000 600 1920 1080 - | ffmpeg -f rawvideo -pix_fmt rgba -s 1920x1080 -r 60 -i - out.mp4
+// threads = 0 uses every core for both the step and the rasterizer
+// a simulation rate > 0 steps the world on its own thread at that many steps per second of wall clock time while the
+// frames render the latest state, like a live capture, the threads are then split between the two
+#include "graphics/software.h"
+#include "physics/simulation_thread.h"
+#include "physics/world.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+int main(int argc, char** argv)
+{
+	const size_t ball_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000;
+	const size_t frames = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 120;
+	const size_t width = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1920;
+	const size_t height = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1080;
+	const std::string output = argc > 5 ? argv[5] : "frame_%05d.png";
+	const size_t threads = argc > 6 ? std::strtoull(argv[6], nullptr, 10) : 0;
+	const double simulation_rate = argc > 7 ? std::strtod(argv[7], nullptr) : 0.0;
+
+	try {
+		// the density of the 20 ball demo scene, fitted into the frame
+		const double scale = std::sqrt(double(ball_count) / 20.0);
+		const double half_width = 300.0 * scale, half_height = 250.0 * scale;
+		phs::World world{};
+		phs::add_box_scene(world, phs::Point{ phs::Float(0), phs::Float(0) }, phs::Float(half_width), phs::Float(half_height), ball_count, 42);
+
+		std::mt19937 gen(7);
+		std::uniform_real_distribution<float> dis(0.f, 1.f);
+		// 64 colors, so a frame is 64 circle batches whatever the ball count
+		gfx::DrawList list{};
+		list.background = gfx::Color(0.94f, 0.97f, 1.f);
+		for (size_t c = 0; c < 64; ++c)
+			list.add_color(gfx::Color(dis(gen), dis(gen), dis(gen)));
+		std::vector<std::uint32_t> colors{};
+		for (size_t i = 0; i < world.balls.size(); ++i)
+			colors.push_back(std::uint32_t(gen() % 64));
+
+		const size_t thread_count = std::max<size_t>(threads > 0 ? threads : std::thread::hardware_concurrency(), 1);
+		const bool decoupled = simulation_rate > 0.0;
+		// a pool runs one parallel_for at a time, so the simulation thread gets a pool of its own
+		phs::ThreadPool pool{ decoupled ? std::max<size_t>(thread_count / 2, 1) : thread_count };
+		std::optional<phs::ThreadPool> simulation_pool{};
+		std::optional<phs::SimulationThread> simulation{};
+		if (decoupled) {
+			simulation_pool.emplace(std::max<size_t>(thread_count - pool.size(), 1));
+			simulation.emplace(world, simulation_rate, true, [&simulation_pool](phs::World& w, phs::Float dt) { w.step(dt, *simulation_pool); });
+		}
+		gfx::SoftwareRenderTarget target{ width, height };
+		const float zoom = float(0.95 * std::min(double(width) / (2.0 * half_width + 20.0), double(height) / (2.0 * half_height + 20.0)));
+		const float cx = float(width) * 0.5f, cy = float(height) * 0.5f;
+
+		const std::uint32_t wall_color = list.add_color(gfx::Color(0.f, 0.f, 0.f));
+		for (const auto& wall : world.walls) {
+			list.add_stadium(cx + float(wall.beg.x) * zoom, cy + float(wall.beg.y) * zoom, cx + float(wall.end.x) * zoom, cy + float(wall.end.y) * zoom,
+				float(wall.radius) * zoom, wall_color);
+		}
+		std::vector<float> x{}, y{}, r{};
+		// lockstep frames draw the world itself, this one only holds the balls of the decoupled mode
+		phs::WorldSnapshot lockstep{};
+
+		const bool raw = output == "-";
+#if defined(_WIN32)
+		if (raw)
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		const bool ppm = output.size() > 4 and output.compare(output.size() - 4, 4, ".ppm") == 0;
+		std::vector<char> name(output.size() + 32);
+
+		double step_seconds = 0.0, draw_seconds = 0.0;
+		const auto first = std::chrono::steady_clock::now();
+		for (size_t f = 0; f < frames; ++f) {
+			const auto beg = std::chrono::steady_clock::now();
+			if (not decoupled)
+				world.step(phs::Float(1.0 / 60.0), pool);
+			const auto stepped = std::chrono::steady_clock::now();
+			if (not decoupled)
+				lockstep.capture(world, f + 1, double(f + 1) / 60.0);
+
+			const phs::WorldSnapshot& state = decoupled ? simulation->latest() : lockstep;
+			const size_t n = state.size();
+			x.resize(n);
+			y.resize(n);
+			r.resize(n);
+			for (size_t i = 0; i < n; ++i) {
+				x[i] = cx + float(state.x[i]) * zoom;
+				y[i] = cy + float(state.y[i]) * zoom;
+				r[i] = float(state.radius[i]) * zoom;
+			}
+			list.begin_frame();
+			list.add_circles(x.data(), y.data(), r.data(), colors.data(), std::min(n, colors.size()));
+			list.end_frame();
+
+			target.beg_draw();
+			target.draw(list);
+			target.end_draw(pool);
+			draw_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stepped).count();
+			step_seconds += std::chrono::duration<double>(stepped - beg).count();
+
+			if (raw) {
+				target.write_raw(stdout);
+				continue;
+			}
+			std::snprintf(name.data(), name.size(), output.c_str(), int(f));
+			if (ppm)
+				target.save_ppm(name.data());
+			else
+				target.save_png(name.data());
+		}
+
+		if (simulation) {
+			simulation->stop();
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - first).count();
+			std::fprintf(stderr, "balls: %zu frames: %zu at %zux%zu, draw %.2f ms per frame on %zu threads, %llu steps (%.1f steps/s) on %zu threads\n",
+				ball_count, frames, width, height, 1e3 * draw_seconds / double(frames), pool.size(),
+				(unsigned long long)simulation->steps(), double(simulation->steps()) / seconds, simulation_pool->size());
+		}
+		else {
+			std::fprintf(stderr, "balls: %zu frames: %zu at %zux%zu, step %.2f ms, draw %.2f ms per frame on %zu threads\n",
+				ball_count, frames, width, height, 1e3 * step_seconds / double(frames), 1e3 * draw_seconds / double(frames), pool.size());
+		}
+	}
+	catch (const std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+}
@@ -0,0 +1,87 @@
+// records and plays back replay logs of the demo scene without a window
+// usage: replay play <log> [stop step]
+//        replay record <log> [balls] [steps] [seed]
+// play steps the recorded scene as fast as the CPU allows and checks the state hash of every step, reporting the first
+// step that differs, with a stop step it stops there and saves a snapshot of the world next to the log for a closer look
+// record runs the demo scene at 120 Hz with a random flick every second, like a user dragging balls around
+#include "physics/replay.h"
+#include "physics/snapshot.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <random>
+
+namespace
+{
+	int play(const char* path, const char* stop) {
+		phs::ReplayPlayer player{ phs::load_replay(path) };
+
+		const auto beg = std::chrono::steady_clock::now();
+		const auto diverged = stop ? player.run_to(std::strtoull(stop, nullptr, 10)) : player.run();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+		const double simulated = double(player.position()) * double(player.log().dt);
+
+		std::printf("steps: %zu of %zu, %.3f s for %.3f s simulated (%.1fx real time)\n",
+			player.position(), player.log().hashes.size(), seconds, simulated, simulated / seconds);
+		if (diverged)
+			std::printf("diverged at step %zu, replay with stop step %zu to look at the world right before it\n", *diverged, *diverged);
+		else
+			std::printf("every state hash matches\n");
+
+		if (stop) {
+			std::filesystem::path snapshot = path;
+			snapshot.replace_extension(".step" + std::to_string(player.position()) + ".phs");
+			phs::save_snapshot(player.world, snapshot);
+			std::printf("saved %s\n", snapshot.string().c_str());
+		}
+		return diverged ? 1 : 0;
+	}
+
+	int record(const char* path, size_t ball_count, size_t steps, unsigned seed) {
+		phs::World world{};
+		phs::ReplayScene scene{};
+		scene.seed = seed;
+		scene.ball_count = ball_count;
+		scene.continuous = true;
+		phs::ReplayRecorder recorder{ world, scene };
+
+		std::mt19937 gen(seed);
+		std::uniform_real_distribution<float> dis(-1.f, 1.f);
+		const phs::Float dt = phs::Float(1.0 / 120.0);
+		for (size_t s = 0; s < steps; ++s) {
+			if (s % 120 == 60) {
+				const size_t ball = gen() % world.balls.size();
+				recorder.impulse(ball, phs::Vector{ phs::Float(dis(gen) * 20000.f), phs::Float(dis(gen) * 20000.f) });
+			}
+			recorder.step(dt);
+		}
+
+		phs::save_replay(recorder.log(), path);
+		std::printf("recorded %zu steps with %zu impulses to %s\n", steps, recorder.log().impulses.size(), path);
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try {
+		if (argc > 2 and std::strcmp(argv[1], "play") == 0)
+			return play(argv[2], argc > 3 ? argv[3] : nullptr);
+		if (argc > 2 and std::strcmp(argv[1], "record") == 0) {
+			return record(argv[2],
+				argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 20,
+				argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 7'200,
+				argc > 5 ? unsigned(std::strtoul(argv[5], nullptr, 10)) : 42u);
+		}
+	}
+	catch (const std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 2;
+	}
+
+	std::fprintf(stderr, "usage: replay play <log> [stop step]\n       replay record <log> [balls] [steps] [seed]\n");
+	return 2;
+}